@@ -38,6 +38,9 @@ namespace votca { namespace xtp {
 
         void Initialize(AOBasis &_dftbasis, AOBasis &_auxbasis, const Eigen::MatrixXd& inverse_Coulomb);
         void Initialize_4c_small_molecule(AOBasis &_dftbasis); 
+        // same integrals as Initialize_4c_small_molecule, written to a scratch file in
+        // shell quartet batches that are streamed back for every J/K build
+        void Initialize_4c_disk(AOBasis &_dftbasis, const std::string& filename);
         void Initialize_4c_screening(AOBasis &_dftbasis, double eps); // Pre-screening
       
         const Eigen::MatrixXd& getEXX() const{return _EXXs;}
@@ -53,6 +56,15 @@ namespace votca { namespace xtp {
         void CalculateEXX_4c_small_molecule(const Eigen::MatrixXd &DMAT);
         
         void CalculateERIs_4c_direct(const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT);
+        // contracts only the density change since the last call, full rebuild every rebuild_interval calls
+        void CalculateERIs_4c_direct_incremental(const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT);
+        void setIncrementalRebuild(int rebuild_interval){_incremental_rebuild=rebuild_interval;}
+        // the next incremental build contracts the full density again
+        void ResetIncremental(){_dmat_previous.resize(0,0);}
+        
+        // shell quartets evaluated/skipped by screening in the last direct build
+        long getComputedQuartets() const{return _quartets_computed;}
+        long getSkippedQuartets() const{return _quartets_skipped;}
         
         int getSize1(){return _ERIs.rows();}
         int getSize2(){return _ERIs.cols();}
@@ -63,13 +75,19 @@ namespace votca { namespace xtp {
 
         bool _with_screening = false;
         double _screening_eps;
-        Eigen::MatrixXd _diagonals; // Square matrix containing <ab|ab> for all basis functions a, b
+        Eigen::MatrixXd _schwarz_shellpairs; // max sqrt(<ab|ab>) for all shell pairs
         
-        void CalculateERIsDiagonals(const AOBasis& dftbasis);
+        Eigen::MatrixXd _dmat_previous;
+        int _incremental_steps = 0;
+        int _incremental_rebuild = 10;
+        long _quartets_computed = 0;
+        long _quartets_skipped = 0;
         
-        bool CheckScreen(double eps,
-            const AOShell& shell_1, const AOShell& shell_2,
-            const AOShell& shell_3, const AOShell& shell_4);
+        void CalculateSchwarzShellpairs(const AOBasis& dftbasis);
+        Eigen::MatrixXd ShellDensityMaxima(const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT) const;
+        Eigen::MatrixXd ContractFourCenterDirect(const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT);
+        // J (exchange false) or K from the quartet batches of the disk file
+        Eigen::MatrixXd ContractFourCenterDisk(const Eigen::MatrixXd& DMAT, bool exchange) const;
         
         TCMatrix_dft _threecenter;
         FCMatrix _fourcenter; 
@@ -82,6 +100,8 @@ namespace votca { namespace xtp {
 
         void CalculateEnergy(const Eigen::MatrixXd &DMAT);
         void CalculateEXXEnergy(const Eigen::MatrixXd &DMAT);
+
+        int EXXBatchSize() const;
         
         void FillERIsBlock(Eigen::MatrixXd& ERIsCur, const Eigen::MatrixXd& DMAT,
             const tensor4d& block,
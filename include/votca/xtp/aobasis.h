@@ -25,6 +25,8 @@
 #include <votca/xtp/basisset.h>
 #include <votca/tools/vec.h>
 #include <votca/xtp/eigen.h>
+#include <votca/xtp/shellpairdata.h>
+#include <memory>
 
 
 
@@ -74,6 +76,10 @@ public:
    int getFuncOfAtom(int AtomIndex)const{return _FuncperAtom[AtomIndex];}
    
    const std::vector<int>& getFuncPerAtom()const {return _FuncperAtom;}
+
+   /// primitive pair data of all shell pairs, built on first request so bases
+   /// never used for three-center integrals skip it
+   const ShellPairData& getShellPairData()const;
   
 
 private:
@@ -101,6 +107,8 @@ private:
     
     std::vector<int> _FuncperAtom;
     
+   mutable std::shared_ptr<const ShellPairData> _shellpairs;
+    
    int _AOBasisFragA;
    int _AOBasisFragB;
     unsigned int _AOBasisSize;
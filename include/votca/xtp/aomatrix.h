@@ -25,6 +25,7 @@
 #include <votca/ctp/apolarsite.h>
 #include <votca/ctp/polarseg.h>
 #include <votca/xtp/multiarray.h>
+#include <votca/xtp/boysfunction.h>
 
 
 
@@ -60,7 +61,11 @@ namespace votca { namespace xtp {
         class AOSuperMatrix{
     public: 
         static int getBlockSize( int _lmax );
-        static Eigen::MatrixXd getTrafo( const AOGaussianPrimitive& gaussian);
+        static Eigen::MatrixXd CalcTrafo( const AOGaussianPrimitive& gaussian);
+        // transformation cached in the primitive when the basis is filled
+        static const Eigen::MatrixXd& getTrafo( const AOGaussianPrimitive& gaussian){
+            return gaussian.getTrafo();
+        }
         void PrintIndexToFunction(const AOBasis& aobasis);
     };
     
@@ -77,8 +82,6 @@ namespace votca { namespace xtp {
         void FreeMatrix(){
             _aomatrix.resize(0,0);
         }
-        // integrate F
-        static std::vector<double> XIntegrate( int size, double U );
     protected:
         virtual void FillBlock(Eigen::Block< Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> >&matrix,const  AOShell* shell_row,const AOShell* shell_col)=0 ;
         Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> _aomatrix;   
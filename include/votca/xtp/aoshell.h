@@ -45,6 +45,8 @@ public:
     double getDecay()const {return _decay;}
     const std::vector<double>& getContraction()const {return _contraction;}
     const AOShell* getShell() const{return _aoshell;}
+    /// cartesian to spherical transformation including the contraction, set by AOShell::normalizeContraction
+    const Eigen::MatrixXd& getTrafo() const{return _trafo;}
 private:
      
     int _power; // used in pseudopotenials only
@@ -52,6 +54,7 @@ private:
     std::vector<double> _contraction;
     AOShell* _aoshell;
     double _powfactor;//used in evalspace to speed up DFT
+    Eigen::MatrixXd _trafo;
     // private constructor, only a shell can create a primitive
     AOGaussianPrimitive( const GaussianPrimitive& gaussian, AOShell *aoshell ) 
     : _power(gaussian._power),
@@ -105,6 +108,13 @@ public:
   void EvalAOspace(Eigen::VectorBlock<Eigen::VectorXd>&  AOvalues, const tools::vec& grid_pos ) const;
   void EvalAOspace(Eigen::VectorBlock<Eigen::VectorXd>&  AOvalues,Eigen::Block< Eigen::MatrixX3d >& AODervalues, const tools::vec& grid_pos ) const;
 
+  // batched versions, grid_pos holds the x,y,z coordinates of npoints as columns,
+  // AOvalues and the gradients are npoints x numFunc and are added to
+  void EvalAOspace(Eigen::Block<Eigen::MatrixXd>& AOvalues, const Eigen::MatrixX3d& grid_pos) const;
+  void EvalAOspace(Eigen::Block<Eigen::MatrixXd>& AOvalues, Eigen::Block<Eigen::MatrixXd>& AODer_x,
+                   Eigen::Block<Eigen::MatrixXd>& AODer_y, Eigen::Block<Eigen::MatrixXd>& AODer_z,
+                   const Eigen::MatrixX3d& grid_pos) const;
+
     // iterator over pairs (decay constant; contraction coefficient)
     typedef std::vector< AOGaussianPrimitive >::const_iterator GaussianIterator;
     GaussianIterator begin() const{ return _gaussians.begin(); }
@@ -139,6 +149,9 @@ private:
     
     // only class aobasis can destruct shells
     ~AOShell(){};
+
+    // caches the spherical transformation of each primitive
+    void CalcTrafos();
     
     // shell type (S, P, D))
     std::string _type;
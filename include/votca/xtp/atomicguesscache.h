@@ -0,0 +1,61 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_ATOMICGUESSCACHE_H
+#define _VOTCA_XTP_ATOMICGUESSCACHE_H
+
+#include <votca/xtp/eigen.h>
+#include <string>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Directory of converged atomic density matrices for the atomic guess
+ *
+ * Every entry is a text file named after its key, which also holds the key
+ * itself to detect clashes of the file names. New entries are written to a
+ * unique temporary file and renamed, which is atomic on POSIX filesystems,
+ * so threads and processes sharing the directory only ever read complete
+ * entries. If two jobs miss the same entry at the same time, both compute it
+ * and the last rename wins.
+ */
+class AtomicGuessCache {
+ public:
+  AtomicGuessCache(const std::string& directory) : _directory(directory) {};
+
+  static std::string Key(const std::string& element, const std::string& basis,
+          const std::string& ecp, const std::string& functional, const std::string& grid);
+
+  /// false if there is no valid entry for key
+  bool Load(const std::string& key, Eigen::MatrixXd& dmat) const;
+
+  /// false if the entry could not be written, the cache is then just not used
+  bool Store(const std::string& key, const Eigen::MatrixXd& dmat) const;
+
+ private:
+  std::string Filename(const std::string& key) const;
+
+  std::string _directory;
+};
+
+}
+}
+
+#endif /* _VOTCA_XTP_ATOMICGUESSCACHE_H */
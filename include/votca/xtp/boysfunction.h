@@ -0,0 +1,72 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_BOYSFUNCTION_H
+#define _VOTCA_XTP_BOYSFUNCTION_H
+
+#include <votca/xtp/eigen.h>
+#include <array>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Boys function F_m(U) = int_0^1 t^2m exp(-U t^2) dt for m=0...mmax
+ *
+ * For U < 36 the highest order is taken from a Taylor expansion of order 6
+ * around the nearest point of a table with spacing 0.1,
+ * F_m(U0-x) = sum_k F_(m+k)(U0) x^k/k!, the lower orders follow from the
+ * stable downward recursion F_m = (2U F_(m+1) + exp(-U))/(2m+1). Above,
+ * F_0 = sqrt(pi/U)/2 and the upward recursion are exact to machine
+ * precision. Either way a single exp is evaluated per U.
+ *
+ * The table is built on first use and shared by all integral engines.
+ */
+class BoysFunction {
+ public:
+  static const int MaxOrder = 24;
+  typedef std::array<double, MaxOrder + 1> Values;
+
+  /// F_0(U) ... F_mmax(U) into the first mmax+1 entries of FmU, U >= 0
+  static void Evaluate(Values& FmU, int mmax, double U) {
+    Instance().Calculate(FmU.data(), mmax, U);
+  }
+
+  /// batch version, FmU becomes U.size() x (mmax+1) with one row per U
+  static void Evaluate(Eigen::MatrixXd& FmU, int mmax, const Eigen::VectorXd& U);
+
+ private:
+  static const int _taylor = 7;
+  static const int _tablepoints = 361;
+
+  BoysFunction();
+  static const BoysFunction& Instance();
+
+  void Calculate(double* FmU, int mmax, double U) const;
+
+  // F_m(U0) at the grid points, (MaxOrder+_taylor) x _tablepoints
+  Eigen::MatrixXd _table;
+  double _inv_factorial[_taylor];
+  double _inv_odd[MaxOrder + 1];
+};
+
+}
+}
+
+#endif /* _VOTCA_XTP_BOYSFUNCTION_H */
@@ -23,7 +23,9 @@
 #include <votca/xtp/orbitals.h>
 #include <votca/xtp/ppm.h>
 #include <votca/xtp/threecenter.h>
+#include <votca/xtp/bseoperator.h>
 #include <votca/xtp/qmstate.h>
+#include <type_traits>
 
 namespace votca {
 namespace xtp {
@@ -56,7 +58,13 @@ struct Population {
         _bse_singlet_coefficients_AR(orbitals.BSESingletCoefficientsAR()),
         _bse_triplet_energies(orbitals.BSETripletEnergies()),
         _bse_triplet_coefficients(orbitals.BSETripletCoefficients()),
-        _min_print_weight(min_print_weight){};
+        _min_print_weight(min_print_weight),
+        _use_davidson(false),
+        _davidson_tolerance(1e-5),
+        _davidson_maxiter(50),
+        _double_hamiltonian(std::is_same<real_gwbse, double>::value),
+        _double_operator(std::is_same<real_gwbse, double>::value),
+        _tile_memory(256.0 * 1024.0 * 1024.0){};
   
   void setGWData(const TCMatrix_gwbse* Mmn,const PPM* ppm,const Eigen::MatrixXd* Hqp){
       _Mmn=Mmn;
@@ -84,6 +92,24 @@ struct Population {
                 return;
             }
 
+  void configureDavidson(bool use_davidson, double tolerance, int maxiter){
+      _use_davidson=use_davidson;
+      _davidson_tolerance=tolerance;
+      _davidson_maxiter=maxiter;
+  }
+
+  /// compute precision of the dense TDA Hamiltonian and eigensolver and of the
+  /// matrix-free products in the Davidson solver, storage stays real_gwbse
+  void configurePrecision(bool double_hamiltonian, bool double_operator){
+      _double_hamiltonian=double_hamiltonian;
+      _double_operator=double_operator;
+  }
+
+  /// memory in MB for the intermediates of the dense Hamiltonian setup,
+  /// the kernels are assembled in tiles that fit into it
+  void setTileMemory(double megabytes){
+      _tile_memory=megabytes * 1024.0 * 1024.0;
+  }
    
   void Solve_triplets();
   void Solve_singlets();
@@ -96,6 +122,9 @@ struct Population {
       _eh_s.resize(0, 0);
   }
   
+  /// matrix-free Hamiltonian, x_factor and d2_factor select the spin type, see BSEOperator
+  BSEOperator getOperator(double x_factor, double d2_factor) const;
+
   void SetupHs();
   
   void SetupHt();
@@ -145,6 +174,37 @@ ctp::Logger *_log;
   
   double _min_print_weight;
 
+  bool _use_davidson;
+  double _davidson_tolerance;
+  int _davidson_maxiter;
+
+  bool _double_hamiltonian;
+  bool _double_operator;
+  double _tile_memory;  // in bytes
+
+  // (A-B)(A+B) of the full BSE, eigenvalues are the squared excitation energies
+  class SquaredOperator {
+  public:
+      SquaredOperator(const BSEOperator& ApB, const BSEOperator& AmB):
+        _ApB(ApB),_AmB(AmB){};
+      int rows()const{return _ApB.rows();}
+      Eigen::VectorXd diagonal()const{
+          return _ApB.diagonal().cwiseProduct(_AmB.diagonal());
+      }
+      Eigen::MatrixXd matmul(const Eigen::MatrixXd& X)const{
+          return _AmB.matmul(_ApB.matmul(X));
+      }
+  private:
+      const BSEOperator& _ApB;
+      const BSEOperator& _AmB;
+  };
+
+  template <typename T>
+  void Solve_TDA(double x_factor, const std::string& spin, VectorXfd& energies, MatrixXfd& coefficients);
+  void Solve_Davidson(const BSEOperator& H, VectorXfd& energies, MatrixXfd& coefficients);
+  void Solve_singlets_BTDA_Davidson();
+
+  int TileSize(int width1, int width2, int bytes) const;
    template <typename T>
   void Add_Hqp(Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& H);
    template <typename T>
@@ -19,6 +19,7 @@
 
 #include <votca/xtp/couplingbase.h>
 #include <votca/xtp/qmstate.h>
+#include <votca/xtp/bseoperator.h>
 
 #ifndef _VOTCA_XTP_BSECOUPLING_H
 #define	_VOTCA_XTP_BSECOUPLING_H
@@ -50,6 +51,11 @@ public:
 
     void CalculateCouplings(const Orbitals& orbitalsA,const Orbitals& orbitalsB, 
                                Orbitals& orbitalsAB);
+
+    /// same as above but the dimer Hamiltonians are applied matrix-free, so
+    /// eh_s/eh_t do not have to be stored in orbitalsAB
+    void CalculateCouplings(const Orbitals& orbitalsA,const Orbitals& orbitalsB, 
+                               Orbitals& orbitalsAB, const BSEOperator* Hs, const BSEOperator* Ht);
      
 private:
     
@@ -60,8 +66,17 @@ private:
     
     double getTripletCouplingElement( int levelA, int levelB, int methodindex);
     
+    template<class BSE_Hamiltonian>
     std::vector< Eigen::MatrixXd >ProjectExcitons(const Eigen::MatrixXd& bseA_T,const Eigen::MatrixXd& bseB_T, 
-                         Eigen::MatrixXd& H);
+                         const BSE_Hamiltonian& H);
+
+    static Eigen::MatrixXd ApplyHamiltonian(const Eigen::MatrixXd& H, const Eigen::MatrixXd& X){
+        return H*X;
+    }
+
+    static Eigen::MatrixXd ApplyHamiltonian(const BSEOperator& H, const Eigen::MatrixXd& X){
+        return H.matmul(X);
+    }
     
     Eigen::MatrixXd Fulldiag(const Eigen::MatrixXd& J_dimer);
     
@@ -0,0 +1,123 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_BSEOPERATOR_H
+#define _VOTCA_XTP_BSEOPERATOR_H
+
+#include <votca/xtp/eigen.h>
+#include <votca/xtp/ppm.h>
+#include <votca/xtp/threecenter.h>
+#include <type_traits>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Matrix-free BSE Hamiltonian
+ *
+ * Applies H = H_qp + H_d + x_factor*H_x + d2_factor*H_d2 to a block of trial
+ * vectors using GEMMs over the vc, vv and cc slices of the three-center
+ * integrals. The Hamiltonian itself is never stored, memory scales with
+ * bse_size x number of trial vectors.
+ *
+ * singlet TDA: x_factor=2, d2_factor=0
+ * triplet TDA: x_factor=0, d2_factor=0
+ * full BSE A+B: x_factor=4, d2_factor=1, A-B: x_factor=0, d2_factor=-1
+ *
+ * The product function index is vc = ctotal*v + c as in BSE. The three-center
+ * integrals, PPM and Hqp are only referenced and have to outlive the operator.
+ *
+ * The products are evaluated in the storage precision real_gwbse of the
+ * three-center integrals by default.
+ */
+class BSEOperator {
+ public:
+  BSEOperator(const TCMatrix_gwbse& Mmn, const PPM& ppm,
+              const Eigen::MatrixXd& Hqp)
+      : _Mmn(Mmn), _ppm(ppm), _Hqp(Hqp), _x_factor(0.0), _d2_factor(0.0),
+        _double_precision(std::is_same<real_gwbse, double>::value){};
+
+  void setBSEindices(int vmin, int vmax, int cmin, int cmax) {
+    _bse_vmin = vmin;
+    _bse_vmax = vmax;
+    _bse_cmin = cmin;
+    _bse_cmax = cmax;
+    _bse_vtotal = _bse_vmax - _bse_vmin + 1;
+    _bse_ctotal = _bse_cmax - _bse_cmin + 1;
+    _bse_size = _bse_vtotal * _bse_ctotal;
+  }
+
+  void setFactors(double x_factor, double d2_factor) {
+    _x_factor = x_factor;
+    _d2_factor = d2_factor;
+  }
+
+  void setDoublePrecision(bool double_precision) {
+    _double_precision = double_precision;
+  }
+
+  int rows() const { return _bse_size; }
+  int cols() const { return _bse_size; }
+
+  Eigen::VectorXd diagonal() const;
+
+  Eigen::MatrixXd matmul(const Eigen::MatrixXd& X) const;
+
+  /// dense matrix, only meant for small systems and for storage in orbitals
+  MatrixXfd Dense() const;
+
+ private:
+  const TCMatrix_gwbse& _Mmn;
+  const PPM& _ppm;
+  const Eigen::MatrixXd& _Hqp;
+
+  double _x_factor;
+  double _d2_factor;
+  bool _double_precision;
+
+  int _bse_vmin;
+  int _bse_vmax;
+  int _bse_cmin;
+  int _bse_cmax;
+  int _bse_vtotal;
+  int _bse_ctotal;
+  int _bse_size;
+
+  template <typename T>
+  using MatrixX = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+  template <typename T>
+  using VectorX = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+  template <typename T>
+  Eigen::MatrixXd Apply(const Eigen::MatrixXd& X) const;
+
+  template <typename T>
+  MatrixX<T> Hqp_times(const MatrixX<T>& X) const;
+  template <typename T>
+  MatrixX<T> Hx_times(const MatrixX<T>& X) const;
+  template <typename T>
+  MatrixX<T> Hd_times(const MatrixX<T>& X) const;
+  template <typename T>
+  MatrixX<T> Hd2_times(const MatrixX<T>& X) const;
+};
+
+}
+}
+
+#endif /* _VOTCA_XTP_BSEOPERATOR_H */
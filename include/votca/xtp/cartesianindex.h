@@ -0,0 +1,97 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_CARTESIANINDEX_H
+#define _VOTCA_XTP_CARTESIANINDEX_H
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Compile-time layout of the cartesian Gaussians of s to g shells
+ *
+ * The cartesians of all shells 0...l follow each other in the order of
+ * Cart::Index. For every function the tables give the exponents of x,y,z and
+ * the functions with one power less or more in each direction. They are
+ * constexpr, so that the integral kernels for fixed angular momenta fold all
+ * lookups into constants.
+ */
+namespace CartesianIndex {
+
+const int MaxL = 4;
+
+/// number of cartesians of all shells 0...l
+constexpr int NumUpTo(int l) { return l < 0 ? 0 : ((l + 1) * (l + 2) * (l + 3)) / 6; }
+
+/// number of spherical functions of all shells 0...l
+constexpr int NumSphericalUpTo(int l) { return (l + 1) * (l + 1); }
+
+/// exponent[d][i] is the power of x (d=0), y (d=1) or z (d=2) in function i
+constexpr int exponent[3][35] = {
+    {0, 1, 0, 0, 2, 1, 1, 0, 0, 0, 3, 2, 2, 1, 1, 1, 0, 0, 0, 0,
+     4, 3, 3, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0},
+    {0, 0, 1, 0, 0, 1, 0, 2, 1, 0, 0, 1, 0, 2, 1, 0, 3, 2, 1, 0,
+     0, 1, 0, 2, 1, 0, 3, 2, 1, 0, 4, 3, 2, 1, 0},
+    {0, 0, 0, 1, 0, 0, 1, 0, 1, 2, 0, 0, 1, 0, 1, 2, 0, 1, 2, 3,
+     0, 0, 1, 0, 1, 2, 0, 1, 2, 3, 0, 1, 2, 3, 4}};
+
+/// less[d][i] is function i with one power less in direction d, 0 if exponent[d][i]=0
+constexpr int less[3][35] = {
+    {0, 0, 0, 0, 1, 2, 3, 0, 0, 0, 4, 5, 6, 7, 8, 9, 0, 0, 0, 0,
+     10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 1, 0, 2, 3, 0, 0, 4, 0, 5, 6, 0, 7, 8, 9, 0,
+     0, 10, 0, 11, 12, 0, 13, 14, 15, 0, 16, 17, 18, 19, 0},
+    {0, 0, 0, 0, 0, 0, 1, 0, 2, 3, 0, 0, 4, 0, 5, 6, 0, 7, 8, 9,
+     0, 0, 10, 0, 11, 12, 0, 13, 14, 15, 0, 16, 17, 18, 19}};
+
+/// more[d][i] is function i with one power more in direction d, up to f functions i
+constexpr int more[3][20] = {
+    {1, 4, 5, 6, 10, 11, 12, 13, 14, 15, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29},
+    {2, 5, 7, 8, 11, 13, 14, 16, 17, 18, 21, 23, 24, 26, 27, 28, 30, 31, 32, 33},
+    {3, 6, 8, 9, 12, 14, 15, 17, 18, 19, 22, 24, 25, 27, 28, 29, 31, 32, 33, 34}};
+
+/// first cartesian of the shell the spherical function i belongs to
+constexpr int sph_start[25] = {0, 1, 1, 1, 4, 4, 4, 4, 4, 10, 10, 10, 10, 10, 10, 10,
+                               20, 20, 20, 20, 20, 20, 20, 20, 20};
+
+/// cartesians with a nonzero coefficient in spherical function i, in the
+/// order of AOSuperMatrix::CalcTrafo
+constexpr int sph_numcart[25] = {1, 1, 1, 1, 3, 1, 1, 1, 2, 3, 3, 3, 1, 2, 2, 2,
+                                 6, 3, 3, 3, 4, 2, 2, 2, 3};
+constexpr int sph_cart[25][6] = {
+    {0}, {3}, {2}, {1},
+    {4, 7, 9}, {8}, {6}, {5}, {4, 7},
+    {12, 17, 19}, {11, 16, 18}, {10, 13, 15}, {14}, {12, 17}, {11, 16}, {10, 13},
+    {20, 23, 25, 30, 32, 34}, {24, 31, 33}, {22, 27, 29}, {21, 26, 28}, {20, 25, 30, 32},
+    {24, 31}, {22, 27}, {21, 26}, {20, 23, 30}};
+
+/// angular momentum of function i
+constexpr int Level(int i) { return exponent[0][i] + exponent[1][i] + exponent[2][i]; }
+
+/// direction d in which the recursions build function i from less[d][i], the
+/// one with the smallest nonzero exponent keeps the term with two powers less
+/// small or absent
+constexpr int direction[35] = {0, 0, 1, 2, 0, 0, 0, 1, 1, 2, 0, 1, 2, 0, 0, 0, 1, 2, 1, 2,
+                               0, 1, 2, 0, 1, 0, 0, 0, 0, 0, 1, 2, 1, 1, 2};
+
+}
+}
+}
+
+#endif /* _VOTCA_XTP_CARTESIANINDEX_H */
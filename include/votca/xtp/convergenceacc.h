@@ -80,6 +80,9 @@ class ConvergenceAcc{
    
    void setOverlap(AOOverlap* S, double etol);
    
+   // forgets the Fock and density history of a previous SCF run, the overlap is kept
+   void Reset();
+   
    double getDIIsError(){return _diiserror;}
    
     bool getUseMixing(){return _usemixing;}
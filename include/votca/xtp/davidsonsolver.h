@@ -0,0 +1,147 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_DAVIDSONSOLVER_H
+#define _VOTCA_XTP_DAVIDSONSOLVER_H
+
+#include <votca/xtp/eigen.h>
+#include <algorithm>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Iterative Davidson eigensolver for the lowest eigenpairs
+ *
+ * The operator is never stored, only products with blocks of trial vectors
+ * are requested. Any type providing
+ *   int rows() const;
+ *   Eigen::VectorXd diagonal() const;
+ *   Eigen::MatrixXd matmul(const Eigen::MatrixXd& X) const;
+ * can be used. The diagonal is used for the initial guess and the
+ * diagonal preconditioned residue (DPR) correction. Memory scales with
+ * size x max_search_space.
+ *
+ * For a nonsymmetric operator with real spectrum (e.g. (A-B)(A+B) of the
+ * full BSE) the projected problem is solved with a general eigensolver.
+ */
+class DavidsonSolver {
+ public:
+  enum MatrixType { SYMMETRIC, NONSYMMETRIC };
+
+  DavidsonSolver() : _matrix_type(SYMMETRIC), _tolerance(1e-5),
+                     _iter_max(50), _max_search_space(0),
+                     _iterations(0), _success(false){};
+
+  void setMatrixType(MatrixType type) { _matrix_type = type; }
+  void setTolerance(double tolerance) { _tolerance = tolerance; }
+  void setMaxIterations(int iter_max) { _iter_max = iter_max; }
+  /// 0 chooses the search space size automatically from the number of roots
+  void setMaxSearchSpace(int size) { _max_search_space = size; }
+
+  const Eigen::VectorXd& eigenvalues() const { return _eigenvalues; }
+  const Eigen::MatrixXd& eigenvectors() const { return _eigenvectors; }
+  const Eigen::VectorXd& residues() const { return _residues; }
+  int NumIterations() const { return _iterations; }
+  bool Info() const { return _success; }
+
+  template <typename MatrixReplacement>
+  void solve(const MatrixReplacement& A, int neigen) {
+    const int size = A.rows();
+    if (neigen > size) {
+      neigen = size;
+    }
+    const Eigen::VectorXd Adiag = A.diagonal();
+    int max_space = _max_search_space;
+    if (max_space < 2 * neigen) {
+      max_space = std::max(10 * neigen, 40);
+    }
+    max_space = std::min(max_space, size);
+    int initial_size = std::min(2 * neigen, size);
+
+    Eigen::MatrixXd V = SetupInitialEigenvectors(Adiag, initial_size);
+    Eigen::MatrixXd AV = A.matmul(V);
+    _success = false;
+    _iterations = 0;
+    for (int iter = 0; iter < _iter_max; ++iter) {
+      _iterations = iter + 1;
+      RitzPairs ritz = SolveProjectedProblem(V, AV);
+
+      _eigenvalues = ritz.lambda.head(neigen);
+      _eigenvectors = V * ritz.y.leftCols(neigen);
+      Eigen::MatrixXd residual = AV * ritz.y.leftCols(neigen)
+              - _eigenvectors * _eigenvalues.asDiagonal();
+      _residues = residual.colwise().norm();
+      if (_residues.maxCoeff() < _tolerance) {
+        _success = true;
+        break;
+      }
+      // the full space is spanned, the projected problem is exact
+      if (V.cols() == size) {
+        _success = true;
+        break;
+      }
+      Eigen::MatrixXd correction = CorrectionVectors(residual, Adiag);
+      if (V.cols() + correction.cols() > max_space) {
+        int keep = std::min(std::max(2 * neigen, int(V.cols()) / 2), int(V.cols()));
+        Restart(V, AV, ritz.y.leftCols(keep));
+      }
+      Eigen::MatrixXd newvectors = OrthogonalizeAgainst(V, correction);
+      if (newvectors.cols() == 0) {
+        // no new directions left, subspace has stagnated
+        break;
+      }
+      Eigen::MatrixXd Anew = A.matmul(newvectors);
+      int oldsize = V.cols();
+      V.conservativeResize(Eigen::NoChange, oldsize + newvectors.cols());
+      V.rightCols(newvectors.cols()) = newvectors;
+      AV.conservativeResize(Eigen::NoChange, oldsize + Anew.cols());
+      AV.rightCols(Anew.cols()) = Anew;
+    }
+    return;
+  }
+
+ private:
+  struct RitzPairs {
+    Eigen::VectorXd lambda;
+    Eigen::MatrixXd y;
+  };
+
+  Eigen::MatrixXd SetupInitialEigenvectors(const Eigen::VectorXd& Adiag, int size) const;
+  RitzPairs SolveProjectedProblem(const Eigen::MatrixXd& V, const Eigen::MatrixXd& AV) const;
+  Eigen::MatrixXd CorrectionVectors(const Eigen::MatrixXd& residual, const Eigen::VectorXd& Adiag) const;
+  Eigen::MatrixXd OrthogonalizeAgainst(const Eigen::MatrixXd& V, const Eigen::MatrixXd& vectors) const;
+  void Restart(Eigen::MatrixXd& V, Eigen::MatrixXd& AV, const Eigen::MatrixXd& y) const;
+
+  MatrixType _matrix_type;
+  double _tolerance;
+  int _iter_max;
+  int _max_search_space;
+
+  int _iterations;
+  bool _success;
+  Eigen::VectorXd _eigenvalues;
+  Eigen::MatrixXd _eigenvectors;
+  Eigen::VectorXd _residues;
+};
+
+}
+}
+
+#endif /* _VOTCA_XTP_DAVIDSONSOLVER_H */
@@ -59,6 +59,14 @@ namespace votca {
                 _pLog = pLog;
             }
 
+            void setThreads(int threads) {
+                _openmp_threads = threads;
+            }
+
+            void setWithGuess(bool with_guess) {
+                _with_guess = with_guess;
+            }
+
             void ConfigureExternalGrid(const std::string& grid_name_ext) {
                 _grid_name_ext = grid_name_ext;
                 _do_externalfield = true;
@@ -84,6 +92,18 @@ namespace votca {
 
             void Prepare(Orbitals& orbitals);
 
+            /// keeps basis sets, grids and invariant integrals of the last Prepare for
+            /// orbitals with the same atoms and MOs, only the external multipole terms
+            /// are rebuilt and Evaluate starts from these MOs, false if Prepare is required
+            bool PrepareWarmStart(Orbitals& orbitals);
+
+            /// loads only the basis sets and ECPs, call before EvaluateSemiNumericalGradient
+            void PrepareSemiNumericalGradient(Orbitals& orbitals);
+
+            /// dE/dR of the converged ground state in orbitals [Hartree/Bohr] from central
+            /// differences of the frozen density energy, rebuilds integrals and grids 6N times
+            Eigen::MatrixX3d EvaluateSemiNumericalGradient(Orbitals& orbitals, double displacement);
+
             std::string getDFTBasisName() const{
                 return _dftbasis_name;
             };
@@ -95,9 +115,13 @@ namespace votca {
             Eigen::MatrixXd OrthogonalizeGuess(const Eigen::MatrixXd& GuessMOs );
             void PrintMOs(const Eigen::VectorXd& MOEnergies);
             void CalcElDipole(Orbitals& orbitals)const;
-            void CalculateERIs(const AOBasis& dftbasis, const Eigen::MatrixXd &DMAT);
+            void CalculateERIs(ERIs& eris, const AOBasis& dftbasis, const Eigen::MatrixXd& dmat);
+            void CalculateEXX(ERIs& eris, const Eigen::MatrixXd& dmat);
             void ConfigOrbfile(Orbitals& orbitals);
+            void PrepareSystem(Orbitals& orbitals);
             void SetupInvariantMatrices();
+            void SetupERIs(ERIs& eris, AOBasis& dftbasis, AOBasis& auxbasis);
+            void SetupExternalPotentials();
             Eigen::MatrixXd AtomicGuess(Orbitals& orbitals);
             std::string ReturnSmallGrid(const std::string& largegrid);
             
@@ -107,6 +131,8 @@ namespace votca {
             Eigen::MatrixXd RunAtomicDFT_fractional(QMAtom* uniqueAtom);
             
             void NuclearRepulsion();
+            Eigen::MatrixX3d NuclearRepulsionGradient() const;
+            double FrozenDensityEnergy(const Eigen::MatrixXd& dmat, const Eigen::MatrixXd& energy_dmat);
             double ExternalRepulsion(ctp::Topology* top = NULL);
             double ExternalGridRepulsion(std::vector<double> externalpotential_nuc);
             Eigen::MatrixXd SphericalAverageShells(const Eigen::MatrixXd& dmat, AOBasis& dftbasis);
@@ -117,6 +143,8 @@ namespace votca {
 
             // atoms
             std::vector<QMAtom*> _atoms;
+            // geometry of the last Prepare, orbitals may replace the atoms in between
+            std::vector<QMAtom> _prepared_atoms;
 
             // basis sets
             std::string _auxbasis_name;
@@ -132,11 +160,15 @@ namespace votca {
             bool _with_ecp;
             bool _with_RI;
             
-            std::string _four_center_method; // direct | cache
+            std::string _four_center_method; // direct | cache | disk
+            std::string _four_center_scratch; // directory of the disk scratch file
             
             // Pre-screening
             bool _with_screening;
             double _screening_eps;
+            // direct: contract only the density change between iterations
+            bool _incremental_fock;
+            int _fock_rebuild;
             
             // numerical integration Vxc
             std::string _grid_name;
@@ -168,6 +200,8 @@ namespace votca {
             
             bool _with_guess;
             std::string _initial_guess;
+            // directory of converged atomic densities, empty if not used
+            std::string _atomic_guess_cache;
 
             // Convergence 
             double _mixingparameter;
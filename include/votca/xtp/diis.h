@@ -49,6 +49,9 @@ public:
     Eigen::VectorXd CalcCoeff();
     
     void setHistLength(int length){_histlength=length;}
+    
+    // drops the error history, e.g. if the Fock matrix changes between SCF runs
+    void Reset();
    
     bool Info(){return success;}
     
@@ -37,7 +37,8 @@ namespace votca {
         public:
 
             Forces(GWBSEEngine& gwbse_engine,const Statefilter& filter, Orbitals& orbitals)
-            : _gwbse_engine(gwbse_engine),_filter(filter),_orbitals(orbitals), _remove_total_force(false){};
+            : _gwbse_engine(gwbse_engine),_filter(filter),_orbitals(orbitals), _remove_total_force(false),
+              _concurrent_tasks(1), _threads_per_task(0){};
 
             void Initialize(tools::Property &options);
             void Calculate(double energy);
@@ -53,6 +54,9 @@ namespace votca {
 
         private:
             
+            bool SemiNumericalGradient();
+            bool ConcurrentForces(double energy);
+            void DisplacedOrbitals(Orbitals& displaced, int atom_index, const tools::vec& displacement) const;
             Eigen::Vector3d NumForceForward(double energy, int atom_index);
             Eigen::Vector3d NumForceCentral(double energy, int atom_index);
             void RemoveTotalForce();
@@ -69,6 +73,10 @@ namespace votca {
             Orbitals& _orbitals;
             bool _remove_total_force;
 
+            // displaced calculations running at the same time and OpenMP threads for each
+            int _concurrent_tasks;
+            int _threads_per_task;
+
             Eigen::MatrixX3d _forces;
             ctp::Logger *_pLog;
         };
@@ -24,6 +24,9 @@
 #include <votca/xtp/eigen.h>
 #include <votca/xtp/aomatrix.h>
 #include <votca/xtp/orbitals.h>
+#include <functional>
+#include <memory>
+#include <string>
 
 /**
 * \brief Calculates four center electron overlap integrals for DFT.
@@ -39,13 +42,59 @@ namespace votca { namespace xtp {
       public:
 
         void Fill_4c_small_molecule(const AOBasis& dftbasis); 
+        // out-of-core variant: the shell quartet blocks are appended to filename in
+        // batches, in the order they are computed. Quartets with a Schwarz bound
+        // below eps and blocks without integrals are not stored. An empty
+        // schwarz_shellpairs matrix disables the screening.
+        void Fill_4c_disk(const AOBasis& dftbasis, const std::string& filename,
+                const Eigen::MatrixXd& schwarz_shellpairs, double eps);
 
-        const Eigen::VectorXd& get_4c_vector() { return _4c_vector;}
+        const Eigen::VectorXd& get_4c_vector() const{ return _4c_vector;}
 
+        bool isOnDisk() const{ return bool(_diskfile);}
+        long getDiskQuartets() const{ return _disk_quartets;}
+
+        // shell quartet of the disk file, block holds (12|34) for all functions of
+        // the four shells with the function of shell 4 running fastest
+        struct DiskQuartet {
+          int start[4];
+          int numfunc[4];
+          const double* block;
+        };
+
+        // reads the disk file sequentially, one batch at a time is kept in memory
+        void ReadDiskBatches(const std::function<void(const std::vector<DiskQuartet>&)>& process) const;
+
+        // s,p,d shells use kernels specialised for their angular momenta
         bool FillFourCenterRepBlock(tensor4d& block, const AOShell* _shell_1, const AOShell* _shell_2, const AOShell* _shell_3,const AOShell* _shell_4);
 
+        // same integrals for any angular momenta, loops run up to the lmax of the shells
+        bool FillFourCenterRepBlockGeneric(tensor4d& block, const AOShell* _shell_1, const AOShell* _shell_2, const AOShell* _shell_3,const AOShell* _shell_4);
+
+        // unit of work for the 4c loops: shell pair (3,4) together with all pairs (1,2),
+        // 3<=1<=2, it is combined with. cost estimates the work from the number of
+        // functions and primitives, so that expensive tasks can be started first
+        struct ShellPairTask {
+          int shell_3;
+          int shell_4;
+          double cost;
+        };
+
+        static std::vector<ShellPairTask> SortedShellPairTasks(const AOBasis& dftbasis);
+
+        // buffer that fits the block of any shell quartet of the basis, allocated once per thread
+        static tensor4d QuartetBuffer(const AOBasis& dftbasis);
+
       private:
+        static long PackedSize(const AOBasis& dftbasis);
+        void FillPacked(const AOBasis& dftbasis, double* data);
+
         Eigen::VectorXd _4c_vector;
+        // the file is removed with the last copy
+        std::shared_ptr<const std::string> _diskfile;
+        long _disk_quartets = 0;
+        std::vector<int> _shell_start;
+        std::vector<int> _shell_numfunc;
     };
 
 }}
@@ -23,6 +23,9 @@
 #include <votca/tools/property.h>
 #include <fstream>
 #include <votca/xtp/eigen.h>
+#include <votca/xtp/threecenter.h>
+#include <votca/xtp/ppm.h>
+#include <votca/xtp/bseoperator.h>
 
 
 namespace votca {
@@ -48,7 +51,7 @@ namespace xtp {
 class GWBSE {
  public:
   GWBSE(Orbitals& orbitals)
-      : _orbitals(orbitals){};
+      : _orbitals(orbitals),_keep_bse_data(false){};
 
   void Initialize(tools::Property& options);
 
@@ -56,10 +59,22 @@ class GWBSE {
 
   void setLogger(ctp::Logger* pLog) { _pLog = pLog; }
 
+  /// overrides the openmp option, call after Initialize
+  void setThreads(int threads) { _openmp_threads = threads; }
+
   bool Evaluate();
     
   void addoutput(tools::Property& summary);
 
+  /// keeps Mmn, PPM and Hqp alive after Evaluate instead of storing the dense
+  /// eh interaction in orbitals, the Hamiltonians are then only available via
+  /// getSingletOperator/getTripletOperator
+  void setKeepBSEData(bool keep) { _keep_bse_data = keep; }
+
+  BSEOperator getSingletOperator() const;
+
+  BSEOperator getTripletOperator() const;
+
  private:
      
  void PrintQP_Energies(const Eigen::VectorXd& gwa_energies, const Eigen::VectorXd& qp_diag_energies);
@@ -91,6 +106,11 @@ class GWBSE {
   std::string _grid;
 
   int _openmp_threads;
+  std::string _mmn_scratch;
+
+  // truncation of the aux dimension of Mmn
+  bool _do_auxtruncation;
+  double _auxtruncation_tolerance;
 
   // fragment definitions
   int _fragA;
@@ -98,10 +118,19 @@ class GWBSE {
   // BSE variant
   bool _do_full_BSE;
 
+  // iterative eigensolver for BSE instead of full diagonalisation
+  bool _do_davidson;
+  double _davidson_tolerance;
+  int _davidson_maxiter;
+
+  // compute precision of the dense BSE Hamiltonian and of the Davidson products
+  bool _bse_double;
+  bool _davidson_double;
+  double _bse_tilememory;
+
   // basis sets
   std::string _auxbasis_name;
   std::string _dftbasis_name;
-  int _reset_3c; //how often the 3c integrals in iterate shoudl be rebuild
   double _shift;  // pre-shift of DFT energies
   int _homo;   // HOMO index
   int _rpamin;
@@ -121,6 +150,11 @@ class GWBSE {
   int _bse_maxeigenvectors;
   double _min_print_weight;
 
+  bool _keep_bse_data;
+  TCMatrix_gwbse _Mmn;
+  PPM _ppm;
+  Eigen::MatrixXd _Hqp;
+
 };
 }
 }
@@ -60,6 +60,10 @@ namespace votca {
                 _qmpackage=qmpackage;
             }
 
+            QMPackage* getQMPackage(){
+                return _qmpackage;
+            }
+
             std::string GetDFTLog() {
                 return _dftlog_file;
             };
@@ -71,6 +75,11 @@ namespace votca {
             void setRedirectLogger(bool redirect_logger) {
                 _redirect_logger = redirect_logger;
             };
+
+            /// OpenMP threads of GWBSE, 0 keeps the openmp option of the gwbse options
+            void setThreads(int threads) {
+                _threads = threads;
+            };
             
             
             tools::Property& ReportSummary(){ return _summary;};
@@ -89,6 +98,7 @@ namespace votca {
             bool _do_dft_parse;
             bool _do_gwbse;
             bool _redirect_logger;
+            int _threads=0;
 
             // DFT log and MO file names
             std::string _MO_file; // file containing the MOs from qmpackage...
@@ -79,7 +79,11 @@ namespace votca { namespace xtp {
         private:
             
            void FindSignificantShells(const AOBasis& basis);
-           void EvaluateXC(const double rho,const double sigma,double& f_xc, double& df_drho, double& df_dsigma);          
+           void EvaluateXC(const Eigen::VectorXd& rho,const Eigen::VectorXd& sigma,Eigen::VectorXd& f_xc, Eigen::VectorXd& df_drho, Eigen::VectorXd& df_dsigma);
+           Eigen::MatrixX3d GridPositions(const GridBox& box) const;
+           void EvalAOBlock(const GridBox& box, Eigen::MatrixXd& ao) const;
+           void EvalAOBlock(const GridBox& box, Eigen::MatrixXd& ao, Eigen::MatrixXd& ao_grad_x,
+                            Eigen::MatrixXd& ao_grad_y, Eigen::MatrixXd& ao_grad_z) const;
            double erf1c(double x);
            
            void SortGridpointsintoBlocks(std::vector< std::vector< GridContainers::Cartesian_gridpoint > >& grid);
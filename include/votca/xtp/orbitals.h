@@ -498,6 +498,9 @@ namespace votca {
             // functions for calculating density matrices
             Eigen::MatrixXd DensityMatrixGroundState() const;
             std::vector<Eigen::MatrixXd > DensityMatrixExcitedState(const QMState& state)const;         
+            // hole and electron density matrices for several excitons at once, much cheaper than one call per state
+            std::vector< std::vector<Eigen::MatrixXd> > DensityMatricesExcitedStates(const std::vector<QMState>& states)const;
+            std::vector<Eigen::MatrixXd> TransitionDensityMatrices(const std::vector<QMState>& states)const;
             Eigen::MatrixXd DensityMatrixQuasiParticle(const QMState& state)const;
             Eigen::MatrixXd CalculateQParticleAORepresentation()const;
             double getTotalStateEnergy(const QMState& state)const;//Hartree
@@ -620,8 +623,8 @@ namespace votca {
             
             
             Eigen::MatrixXd TransitionDensityMatrix(const QMState& state)const;
-            std::vector<Eigen::MatrixXd > DensityMatrixExcitedState_R(const QMState& state)const;
-            std::vector<Eigen::MatrixXd >DensityMatrixExcitedState_AR(const QMState& state)const;
+            // BSE coefficients of the states as columns, zero for states without antiresonant part
+            Eigen::MatrixXd BSECoefficients(const std::vector<QMState>& states, bool antiresonant)const;
 
             int _basis_set_size;
             int _occupied_levels;
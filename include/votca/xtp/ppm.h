@@ -53,6 +53,9 @@ double getScreening_i()const{return screening_i;}
  const Eigen::MatrixXd& getPpm_phi() const {
      return _ppm_phi;
  }     
+
+ /// 1-ppm_weight, the screening of the direct eh interaction in the BSE
+ Eigen::VectorXd getScreenedWeights() const;
      
  void FreeMatrix(){
      _ppm_phi.resize(0,0);
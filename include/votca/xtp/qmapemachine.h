@@ -66,6 +66,9 @@ private:
     
     Statefilter _filter;
     QMInterface qminterface;
+    // kept over the iterations, later SCFs start from the last MOs
+    DFTEngine _dftengine;
+    Orbitals orb_iter_input;
     ctp::Logger *_log;
 
     bool _run_ape;
@@ -60,7 +60,23 @@ namespace votca {
             virtual bool ParseOrbitalsFile(Orbitals& orbitals) = 0;
 
             virtual void CleanUp() = 0;
-            
+
+            /// independent copy with the same settings for concurrent runs, NULL if not supported
+            virtual QMPackage* Clone() const {
+                return NULL;
+            }
+
+            /// ground state gradient dE/dR [Hartree/Bohr] for the converged orbitals from energies
+            /// at frozen density on displaced geometries, false if not supported
+            virtual bool CalculateSemiNumericalGradient(Orbitals& orbitals, double displacement, Eigen::MatrixX3d& gradient) {
+                return false;
+            }
+
+            /// reuse the setup of the last Run for the same atoms and start from the MOs in orbitals, ignored if not supported
+            virtual void setWarmStart(bool warm_start) {
+                return;
+            }
+
             
             void setMultipoleBackground( std::vector<std::shared_ptr<ctp::PolarSeg> > PolarSegments);
 
@@ -88,6 +104,10 @@ namespace votca {
                 return _write_guess;
             }
 
+            void setGuessRequested(bool guess_requested) {
+                _write_guess = guess_requested;
+            }
+
             bool ECPRequested() {
                 return _write_pseudopotentials;
             }
@@ -166,7 +186,7 @@ namespace votca {
             
 
             bool _write_guess;
-            bool _write_charges;
+            bool _write_charges=false;
             bool _write_basis_set;
             bool _write_pseudopotentials;
 
@@ -0,0 +1,64 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_SCRATCHFILE_H
+#define _VOTCA_XTP_SCRATCHFILE_H
+
+#include <string>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Zero initialised scratch file mapped into memory
+ *
+ * Backing store for integral arrays which do not fit into RAM. The file is
+ * created sparse, so regions which are never written take no disk space, and
+ * the kernel pages the data in and out on access. The file is removed again
+ * when the object is destroyed, objects are therefore not copyable.
+ */
+class ScratchFile {
+ public:
+  ScratchFile(const std::string& filename, std::size_t bytes);
+  ~ScratchFile();
+
+  ScratchFile(const ScratchFile&) = delete;
+  ScratchFile& operator=(const ScratchFile&) = delete;
+
+  /// remap read only, after all data has been written
+  void FinishWriting();
+
+  void* data() const { return _region.get_address(); }
+  std::size_t bytes() const { return _bytes; }
+  const std::string& filename() const { return _filename; }
+
+ private:
+  void Map(boost::interprocess::mode_t mode);
+
+  std::string _filename;
+  std::size_t _bytes;
+  boost::interprocess::mapped_region _region;
+};
+
+}
+}
+
+#endif /* _VOTCA_XTP_SCRATCHFILE_H */
@@ -0,0 +1,89 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_SHELLPAIRDATA_H
+#define _VOTCA_XTP_SHELLPAIRDATA_H
+
+#include <votca/tools/vec.h>
+#include <vector>
+
+namespace votca {
+namespace xtp {
+class AOShell;
+class AOGaussianPrimitive;
+
+/**
+ * \brief Gaussian product data of all primitive pairs of a basis
+ *
+ * For each shell pair (row,col) with row>=col the primitives a of row and b
+ * of col are stored with zeta=a+b, xi=a*b/(a+b), the product center
+ * P=(a*A+b*B)/zeta and exparg=xi*|A-B|^2. Primitive pairs with
+ * exparg > 40 are dropped, their product distribution is below 1e-17.
+ * The data of all shell pairs lies in one vector, so that the storage grows
+ * with the number of significant primitive pairs only.
+ */
+class ShellPairData {
+ public:
+  struct PrimitivePair {
+    const AOGaussianPrimitive* first;
+    const AOGaussianPrimitive* second;
+    double zeta;
+    double xi;
+    double exparg;
+    tools::vec P;
+  };
+
+  typedef std::vector<PrimitivePair>::const_iterator PairIterator;
+
+  /// primitive pairs of one shell pair, can be used in range based for loops
+  class Pairs {
+   public:
+    Pairs(PairIterator begin, PairIterator end) : _begin(begin), _end(end){};
+    PairIterator begin() const { return _begin; }
+    PairIterator end() const { return _end; }
+    bool empty() const { return _begin == _end; }
+
+   private:
+    PairIterator _begin;
+    PairIterator _end;
+  };
+
+  void Fill(const std::vector<AOShell*>& shells);
+
+  /// row>=col are the indices of the shells in the basis
+  Pairs getPairs(int row, int col) const {
+    const long index = long(row) * (row + 1) / 2 + col;
+    return Pairs(_pairs.begin() + _offsets[index], _pairs.begin() + _offsets[index + 1]);
+  }
+
+  long getNumberOfPairs() const { return _pairs.size(); }
+
+  /// appends the significant primitive pairs of two shells to pairs
+  static void AddPairs(std::vector<PrimitivePair>& pairs, const AOShell* shell_row, const AOShell* shell_col);
+
+ private:
+  std::vector<PrimitivePair> _pairs;
+  // pairs of shell pair i are _pairs[_offsets[i]] to _pairs[_offsets[i+1]-1]
+  std::vector<long> _offsets;
+};
+
+}
+}
+
+#endif /* _VOTCA_XTP_SHELLPAIRDATA_H */
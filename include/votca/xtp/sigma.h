@@ -21,6 +21,7 @@
 #define _VOTCA_XTP_SIGMA_H
 #include <votca/xtp/eigen.h>
 #include <votca/ctp/logger.h>
+#include <vector>
 
 namespace votca {
 namespace xtp {
@@ -71,11 +72,26 @@ void FreeMatrices(){
 
  private:
      
-  void C_diag(const TCMatrix_gwbse& Mmn, const PPM& ppm, const Eigen::VectorXd& qp_old);
+  // PPM poles with non negligible weight, fac = 0.25*weight*freq
+  struct PPMPoles {
+    std::vector<int> index;
+    Eigen::VectorXd freq;
+    Eigen::VectorXd fac;
+  };
+
+  PPMPoles NonzeroPoles(const PPM& ppm) const;
+  // stabilised PPM denominators times fac of poles start..start+cols-1 for all bands (bands x cols)
+  Eigen::MatrixXd CorrelationFactors(double qp_energy, const Eigen::VectorXd& energies,
+          int levelsum, const PPMPoles& poles, int start, int cols) const;
+  // columns of Mmn[level] belonging to poles start..start+cols-1
+  Eigen::MatrixXd PoleColumns(const TCMatrix_gwbse& Mmn, int level, const PPMPoles& poles,
+          int start, int cols) const;
+  int AuxChunkSize(int rows, int auxsize) const;
+
+  void C_diag(const TCMatrix_gwbse& Mmn, const PPMPoles& poles, const Eigen::VectorXd& qp_old);
   void C_offdiag(const TCMatrix_gwbse& Mmn, const PPM& ppm);
   
-  inline double SumSymmetric(real_gwbse Mmn1xMmn2, double qpmin1, double qpmin2, const double gwa_energy);
-  inline double Stabilize(double denom);
+  static double Stabilize(double denom);
 
 
   void X_offdiag(const TCMatrix_gwbse& Mmn);   
@@ -27,6 +27,9 @@
 #include <votca/xtp/aomatrix.h>
 #include <votca/xtp/symmetric_matrix.h>
 #include <votca/xtp/orbitals.h>
+#include <votca/xtp/scratchfile.h>
+#include <memory>
+#include <utility>
 
 
 
@@ -48,8 +51,18 @@ namespace votca {
         protected:
             
             
-            bool FillThreeCenterRepBlock(tensor3d& threec_block, const AOShell* shell, const AOShell* shell_row, const AOShell* shell_col);
+            /// pairs are the primitive pairs of shell_row x shell_col from AOBasis::getShellPairData
+            /// s,p,d DFT shells with s to g aux shells use kernels specialised for their angular momenta
+            bool FillThreeCenterRepBlock(tensor3d& threec_block, const AOShell* shell, const AOShell* shell_row, const AOShell* shell_col,
+                    const ShellPairData::Pairs& pairs);
+
+            /// same integrals for any angular momenta, loops run up to the lmax of the shells
+            bool FillThreeCenterRepBlockGeneric(tensor3d& threec_block, const AOShell* shell, const AOShell* shell_row, const AOShell* shell_col,
+                    const ShellPairData::Pairs& pairs);
             
+            /// pairs (row,col) with row>=col of DFT shells whose product distribution is above threshold
+            static std::vector< std::pair<int, int> > SignificantShellPairs(const AOBasis& dftbasis, double threshold);
+
 
         };
 
@@ -58,41 +71,53 @@ namespace votca {
 
             void Fill(AOBasis& auxbasis, AOBasis& dftbasis,const Eigen::MatrixXd& V_sqrtm1);
 
-            int getSize() {
-                return _matrix.size();
+            /// number of aux functions
+            int getSize() const{
+                return _matrix.cols();
             }
 
-            std::vector< Symmetric_Matrix >& getData() {
-                return _matrix;
+            int getBasisSize() const{
+                return _basissize;
             }
 
-            Symmetric_Matrix& getDatamatrix(int i) {
-                return _matrix[i];
+            /// contiguous storage of all aux functions, column i holds the lower
+            /// triangle of matrix i packed as in Symmetric_Matrix (npair x naux)
+            const Eigen::MatrixXd& getData() const{
+                return _matrix;
             }
 
-            const Symmetric_Matrix& getDatamatrix(int i)const {
-                return _matrix[i];
-            }
+            Symmetric_Matrix getDatamatrix(int i)const;
+
+            /// full matrices of aux functions start...start+count-1 stacked on top of each other
+            Eigen::MatrixXd getStackedMatrices(int start, int count)const;
+
         private:
-            std::vector< Symmetric_Matrix > _matrix;
+            Eigen::MatrixXd _matrix;
+            int _basissize;
 
             void FillBlock(std::vector< Eigen::MatrixXd >& block,int shellindex, const AOBasis& dftbasis, const AOBasis& auxbasis);
 
         };
 
+        /*
+         * All m levels are stored in one contiguous buffer, either in memory or,
+         * if a scratch file is given in Initialize, in a memory mapped file, so
+         * that the kernel pages the levels in and out as RPA, Sigma and BSE
+         * iterate over them. Levels are accessed as Eigen::Map.
+         */
         class TCMatrix_gwbse : public TCMatrix {
         public:
 
-            /// returns one level as a constant reference
+            /// returns one level (ntotal x aux) as a constant view
 
-            const MatrixXfd& operator[](int i) const {
-                return _matrix[i];
+            Eigen::Map<const MatrixXfd> operator[](int i) const {
+                return Eigen::Map<const MatrixXfd>(data() + _offsets[i], _rows[i], basissize);
             }
 
-            /// returns one level as a reference
+            /// returns one level (ntotal x aux) as a view
 
-            MatrixXfd& operator[](int i) {
-                return _matrix[i];
+            Eigen::Map<MatrixXfd> operator[](int i) {
+                return Eigen::Map<MatrixXfd>(data() + _offsets[i], _rows[i], basissize);
             }
 
             int getAuxDimension()const {
@@ -124,20 +149,42 @@ namespace votca {
             }
 
 
-            void Initialize(int _basissize, int mmin, int mmax, int nmin, int nmax);
+            /// with a non empty scratchfile the integrals are kept in that file instead of RAM
+            void Initialize(int _basissize, int mmin, int mmax, int nmin, int nmax,
+                    const std::string& scratchfile = "");
+
+            bool isOnDisk() const {
+                return bool(_scratch);
+            }
 
             void Prune(int min, int max);
             void Print(std::string ident);
             void Fill(const AOBasis& auxbasis, const AOBasis& dftbasis, const Eigen::MatrixXd& dft_orbitals);
 
             void MultiplyRightWithAuxMatrix(const Eigen::MatrixXd& AuxMatrix);
+            void MultiplyRightWithAuxMatrix(const TCMatrix_gwbse& source, const Eigen::MatrixXd& AuxMatrix);
+            /// levels multiplied by an aux x r matrix with r <= aux, the aux dimension becomes r
+            void ReduceAuxDimension(const Eigen::MatrixXd& AuxMatrix);
+            /// orthonormal aux x r matrix, projecting onto it changes Mmn by at most tolerance x ||Mmn|| (Frobenius)
+            Eigen::MatrixXd TruncatedAuxBasis(double tolerance) const;
 
             void Cleanup();
 
         private:
 
-            // store vector of matrices
-            std::vector< MatrixXfd > _matrix;
+            // level i occupies _rows[i] x basissize entries starting at _offsets[i]
+            std::vector<real_gwbse> _storage;
+            std::shared_ptr<ScratchFile> _scratch;
+            std::vector<long> _offsets;
+            std::vector<int> _rows;
+
+            real_gwbse* data() {
+                return _scratch ? static_cast<real_gwbse*> (_scratch->data()) : _storage.data();
+            }
+
+            const real_gwbse* data() const {
+                return _scratch ? static_cast<const real_gwbse*> (_scratch->data()) : _storage.data();
+            }
 
             // band summation indices
             int _mmin;
@@ -148,7 +195,8 @@ namespace votca {
             int _mtotal;
             int basissize;
 
-            void FillBlock(std::vector< Eigen::MatrixXd >& matrix, const AOShell* auxshell, const AOBasis& dftbasis, const Eigen::MatrixXd& dft_orbitals);
+            void FillBlock(std::vector< Eigen::MatrixXd >& matrix, const AOShell* auxshell, const AOBasis& dftbasis,
+                    const std::vector< std::pair<int, int> >& shellpairs, const Eigen::MatrixXd& dftm, const Eigen::MatrixXd& dftn);
 
         };
     
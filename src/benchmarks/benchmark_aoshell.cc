@@ -0,0 +1,128 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <boost/format.hpp>
+#include <votca/xtp/aobasis.h>
+#include <votca/xtp/aoshell.h>
+#include <votca/xtp/basisset.h>
+#include <votca/xtp/qmatom.h>
+
+using namespace votca;
+using namespace votca::xtp;
+
+/*
+ * Throughput of AOShell::EvalAOspace per angular momentum, pointwise versus
+ * batched evaluation on blocks of grid points as used by the grid boxes.
+ * That both agree is checked in test_aobasis.
+ *
+ * usage: benchmark_aoshell [npoints] [batchsize]
+ * defaults are 200000 points in batches of 128.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  int npoints = (argc > 1) ? std::atoi(argv[1]) : 200000;
+  int batchsize = (argc > 2) ? std::atoi(argv[2]) : 128;
+
+  Eigen::MatrixX3d points = 2.0 * Eigen::MatrixX3d::Random(npoints, 3);
+  std::vector<tools::vec> points_vec;
+  for (int p = 0; p < npoints; p++) {
+    points_vec.push_back(tools::vec(points(p, 0), points(p, 1), points(p, 2)));
+  }
+
+  std::cout << boost::format("AOShell::EvalAOspace: %1% points, batches of %2%") % npoints % batchsize << std::endl;
+  std::cout << boost::format("%1$6s %2$16s %3$16s %4$16s %5$16s")
+          % "shell" % "point[pts/s]" % "batch[pts/s]" % "point+grad" % "batch+grad" << std::endl;
+
+  const std::vector<std::string> types = {"S", "P", "D", "F", "G"};
+  for (unsigned l = 0; l < types.size(); l++) {
+    BasisSet bs;
+    Element& element = bs.addElement("C");
+    Shell& shell = element.addShell(types[l], 1.0);
+    std::vector<double> contraction(l + 1, 0.0);
+    const double decays[] = {5.0, 1.2, 0.3};
+    for (double decay : decays) {
+      contraction[l] = 1.0;
+      shell.addGaussian(decay, contraction);
+    }
+    QMAtom atom(0, "C", 0.1, -0.2, 0.3);
+    std::vector<QMAtom*> atoms = {&atom};
+    AOBasis aobasis;
+    aobasis.AOBasisFill(bs, atoms);
+    const AOShell* aoshell = aobasis.getShell(0);
+    const int nfunc = aoshell->getNumFunc();
+
+    auto start = Clock::now();
+    Eigen::VectorXd ao_point = Eigen::VectorXd::Zero(nfunc);
+    for (int p = 0; p < npoints; p++) {
+      ao_point.setZero();
+      Eigen::VectorBlock<Eigen::VectorXd> ao_block = ao_point.segment(0, nfunc);
+      aoshell->EvalAOspace(ao_block, points_vec[p]);
+    }
+    double time_point = Seconds(start);
+
+    start = Clock::now();
+    Eigen::MatrixX3d grad_point = Eigen::MatrixX3d::Zero(nfunc, 3);
+    for (int p = 0; p < npoints; p++) {
+      ao_point.setZero();
+      grad_point.setZero();
+      Eigen::VectorBlock<Eigen::VectorXd> ao_block = ao_point.segment(0, nfunc);
+      Eigen::Block<Eigen::MatrixX3d> grad_block = grad_point.block(0, 0, nfunc, 3);
+      aoshell->EvalAOspace(ao_block, grad_block, points_vec[p]);
+    }
+    double time_point_grad = Seconds(start);
+
+    start = Clock::now();
+    for (int first = 0; first < npoints; first += batchsize) {
+      int size = std::min(batchsize, npoints - first);
+      const Eigen::MatrixX3d batch = points.middleRows(first, size);
+      Eigen::MatrixXd ao = Eigen::MatrixXd::Zero(size, nfunc);
+      Eigen::Block<Eigen::MatrixXd> ao_block = ao.block(0, 0, size, nfunc);
+      aoshell->EvalAOspace(ao_block, batch);
+    }
+    double time_batch = Seconds(start);
+
+    start = Clock::now();
+    for (int first = 0; first < npoints; first += batchsize) {
+      int size = std::min(batchsize, npoints - first);
+      const Eigen::MatrixX3d batch = points.middleRows(first, size);
+      Eigen::MatrixXd ao = Eigen::MatrixXd::Zero(size, nfunc);
+      Eigen::MatrixXd grad_x = Eigen::MatrixXd::Zero(size, nfunc);
+      Eigen::MatrixXd grad_y = Eigen::MatrixXd::Zero(size, nfunc);
+      Eigen::MatrixXd grad_z = Eigen::MatrixXd::Zero(size, nfunc);
+      Eigen::Block<Eigen::MatrixXd> ao_block = ao.block(0, 0, size, nfunc);
+      Eigen::Block<Eigen::MatrixXd> grad_x_block = grad_x.block(0, 0, size, nfunc);
+      Eigen::Block<Eigen::MatrixXd> grad_y_block = grad_y.block(0, 0, size, nfunc);
+      Eigen::Block<Eigen::MatrixXd> grad_z_block = grad_z.block(0, 0, size, nfunc);
+      aoshell->EvalAOspace(ao_block, grad_x_block, grad_y_block, grad_z_block, batch);
+    }
+    double time_batch_grad = Seconds(start);
+
+    std::cout << boost::format("%1$6s %2$16.4e %3$16.4e %4$16.4e %5$16.4e")
+            % types[l] % (npoints / time_point) % (npoints / time_batch)
+            % (npoints / time_point_grad) % (npoints / time_batch_grad) << std::endl;
+  }
+  return 0;
+}
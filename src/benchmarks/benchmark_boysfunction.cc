@@ -0,0 +1,117 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <votca/xtp/boysfunction.h>
+
+using namespace votca::xtp;
+
+/*
+ * Throughput of the Boys function per maximal order: the downward
+ * recursion from m=60 that AOMatrix::XIntegrate used before, the tabulated
+ * BoysFunction per value of U and the batched version. The batch timing
+ * includes writing the full nvalues x (mmax+1) result to memory.
+ *
+ * usage: benchmark_boysfunction [nvalues] [umax]
+ * defaults are 1000000 values of U uniformly distributed in [0,40].
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<double> Recursion(int size, double U) {
+  std::vector<double> FmU(size, 0.0);
+  const int mm = size - 1;
+  const double pi = boost::math::constants::pi<double>();
+  if (U >= 10.0) {
+    FmU[0] = 0.50 * std::sqrt(pi / U) * std::erf(std::sqrt(U));
+    for (int m = 1; m < size; m++) {
+      FmU[m] = (2.0 * m - 1) * FmU[m - 1] / (2.0 * U) - std::exp(-U) / (2.0 * U);
+    }
+  } else if (U < 1e-10) {
+    for (int m = 0; m < size; m++) {
+      FmU[m] = 1.0 / (2.0 * m + 1.0) - U / (2.0 * m + 3.0);
+    }
+  } else {
+    double fm = 0.0;
+    for (int m = 60; m >= mm; m--) {
+      fm = (2.0 * U) / (2.0 * m + 1.0) * (fm + std::exp(-U) / (2.0 * U));
+    }
+    FmU[mm] = fm;
+    for (int m = mm - 1; m >= 0; m--) {
+      FmU[m] = (2.0 * U) / (2.0 * m + 1.0) * (FmU[m + 1] + std::exp(-U) / (2.0 * U));
+    }
+  }
+  return FmU;
+}
+
+int main(int argc, char** argv) {
+  int nvalues = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+  double umax = (argc > 2) ? std::atof(argv[2]) : 40.0;
+
+  const Eigen::VectorXd U = 0.5 * umax * (Eigen::VectorXd::Random(nvalues).array() + 1.0);
+
+  std::cout << boost::format("Boys function: %1% values of U in [0,%2%]") % nvalues % umax << std::endl;
+  std::cout << boost::format("%1$6s %2$16s %3$16s %4$16s %5$12s")
+          % "mmax" % "recursion[1/s]" % "table[1/s]" % "batch[1/s]" % "max.diff" << std::endl;
+  for (int mmax : {0, 2, 4, 8, 12, 16}) {
+    double checksum = 0.0;
+    auto start = Clock::now();
+    for (int i = 0; i < nvalues; i++) {
+      const std::vector<double> FmU = Recursion(mmax + 1, U(i));
+      checksum += FmU[mmax];
+    }
+    double time_recursion = Seconds(start);
+
+    start = Clock::now();
+    BoysFunction::Values FmU;
+    for (int i = 0; i < nvalues; i++) {
+      BoysFunction::Evaluate(FmU, mmax, U(i));
+      checksum -= FmU[mmax];
+    }
+    double time_table = Seconds(start);
+
+    start = Clock::now();
+    Eigen::MatrixXd batch;
+    BoysFunction::Evaluate(batch, mmax, U);
+    double time_batch = Seconds(start);
+
+    double maxdiff = 0.0;
+    for (int i = 0; i < nvalues; i += 97) {
+      const std::vector<double> reference = Recursion(mmax + 1, U(i));
+      for (int m = 0; m <= mmax; m++) {
+        maxdiff = std::max(maxdiff, std::abs(batch(i, m) - reference[m]) / reference[m]);
+      }
+    }
+    std::cout << boost::format("%1$6d %2$16.4e %3$16.4e %4$16.4e %5$12.2e")
+            % mmax % (nvalues / time_recursion) % (nvalues / time_table)
+            % (nvalues / time_batch) % maxdiff << std::endl;
+    if (checksum > 1e300) {
+      std::cout << checksum << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <boost/format.hpp>
+#include <votca/xtp/aobasis.h>
+#include <votca/xtp/basisset.h>
+#include <votca/xtp/fourcenter.h>
+#include <votca/xtp/qmatom.h>
+#include <votca/xtp/threecenter.h>
+
+using namespace votca;
+using namespace votca::xtp;
+
+/*
+ * Throughput of the three- and four-center repulsion kernels per
+ * combination of angular momenta, for contracted shells of three
+ * primitives on two atoms and aux shells of two primitives on a third.
+ * Every combination is timed with the generic kernel and with the one
+ * specialised for its angular momenta, maxdiff is the largest difference
+ * between the two blocks.
+ *
+ * usage: benchmark_eris [repetitions]
+ * default is 200 repetitions of every shell combination.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// gives access to the protected kernels
+class ThreeCenterKernel : public TCMatrix {
+ public:
+  using TCMatrix::FillThreeCenterRepBlock;
+  using TCMatrix::FillThreeCenterRepBlockGeneric;
+};
+
+template <class Tensor>
+double MaxDiff(const Tensor& a, const Tensor& b) {
+  double maxdiff = 0.0;
+  for (std::size_t i = 0; i < a.num_elements(); i++) {
+    maxdiff = std::max(maxdiff, std::abs(a.data()[i] - b.data()[i]));
+  }
+  return maxdiff;
+}
+
+void PrintHeader() {
+  std::cout << boost::format("%1$8s %2$16s %3$16s %4$9s %5$10s") % "shells" % "generic[1/s]"
+          % "specialised[1/s]" % "speedup" % "maxdiff" << std::endl;
+}
+
+void PrintRow(const std::string& name, int repetitions, double time_generic,
+        double time_specialised, double maxdiff) {
+  std::cout << boost::format("%1$8s %2$16.4e %3$16.4e %4$9.2f %5$10.2e") % name
+          % (repetitions / time_generic) % (repetitions / time_specialised)
+          % (time_generic / time_specialised) % maxdiff << std::endl;
+}
+
+int main(int argc, char** argv) {
+  int repetitions = (argc > 1) ? std::atoi(argv[1]) : 200;
+
+  const std::vector<std::string> types = {"S", "P", "D", "F"};
+  BasisSet bs;
+  Element& element = bs.addElement("C");
+  BasisSet auxbs;
+  Element& auxelement = auxbs.addElement("C");
+  for (unsigned l = 0; l < types.size(); l++) {
+    std::vector<double> contraction(l + 1, 0.0);
+    contraction[l] = 1.0;
+    if (l < 3) {
+      Shell& shell = element.addShell(types[l], 1.0);
+      const double decays[] = {8.0, 1.5, 0.35};
+      for (double decay : decays) {
+        shell.addGaussian(decay, contraction);
+      }
+    }
+    Shell& auxshell = auxelement.addShell(types[l], 1.0);
+    const double auxdecays[] = {3.0, 0.6};
+    for (double decay : auxdecays) {
+      auxshell.addGaussian(decay, contraction);
+    }
+  }
+  QMAtom atom_a(0, "C", 0.0, 0.0, 0.0);
+  QMAtom atom_b(1, "C", 1.4, 1.1, -0.3);
+  QMAtom atom_c(2, "C", -0.6, 1.9, 0.8);
+  std::vector<QMAtom*> dftatoms = {&atom_a, &atom_b};
+  std::vector<QMAtom*> auxatoms = {&atom_c};
+  AOBasis dftbasis;
+  dftbasis.AOBasisFill(bs, dftatoms);
+  AOBasis auxbasis;
+  auxbasis.AOBasisFill(auxbs, auxatoms);
+  // shells 0-2 are S,P,D on atom a, 3-5 on atom b
+  const int nl = 3;
+
+  tensor3d::extent_gen extents;
+  ThreeCenterKernel threecenter;
+  double total_generic = 0.0;
+  double total_specialised = 0.0;
+  std::cout << "three-center (ab|c), blocks per second" << std::endl;
+  PrintHeader();
+  for (int la = 0; la < nl; la++) {
+    for (int lb = 0; lb < nl; lb++) {
+      const AOShell* shell_row = dftbasis.getShell(nl + la);
+      const AOShell* shell_col = dftbasis.getShell(lb);
+      const ShellPairData::Pairs pairs = dftbasis.getShellPairData().getPairs(nl + la, lb);
+      for (const AOShell* auxshell : auxbasis) {
+        tensor3d block_generic(extents[auxshell->getNumFunc()][shell_row->getNumFunc()][shell_col->getNumFunc()]);
+        tensor3d block(extents[auxshell->getNumFunc()][shell_row->getNumFunc()][shell_col->getNumFunc()]);
+        std::fill_n(block_generic.data(), block_generic.num_elements(), 0.0);
+        std::fill_n(block.data(), block.num_elements(), 0.0);
+        auto start = Clock::now();
+        for (int r = 0; r < repetitions; r++) {
+          threecenter.FillThreeCenterRepBlockGeneric(block_generic, auxshell, shell_row, shell_col, pairs);
+        }
+        double time_generic = Seconds(start);
+        start = Clock::now();
+        for (int r = 0; r < repetitions; r++) {
+          threecenter.FillThreeCenterRepBlock(block, auxshell, shell_row, shell_col, pairs);
+        }
+        double time_specialised = Seconds(start);
+        total_generic += time_generic;
+        total_specialised += time_specialised;
+        std::string name = types[la] + types[lb] + "|" + auxshell->getType();
+        PrintRow(name, repetitions, time_generic, time_specialised, MaxDiff(block, block_generic));
+      }
+    }
+  }
+
+  std::cout << boost::format("total speedup %1$.2f") % (total_generic / total_specialised) << std::endl;
+
+  tensor4d::extent_gen extents4;
+  FCMatrix fourcenter;
+  total_generic = 0.0;
+  total_specialised = 0.0;
+  std::cout << "four-center (ab|cd), blocks per second" << std::endl;
+  PrintHeader();
+  for (int la = 0; la < nl; la++) {
+    for (int lb = 0; lb <= la; lb++) {
+      for (int lc = 0; lc < nl; lc++) {
+        for (int ld = 0; ld <= lc; ld++) {
+          const AOShell* shell_1 = dftbasis.getShell(la);
+          const AOShell* shell_2 = dftbasis.getShell(nl + lb);
+          const AOShell* shell_3 = dftbasis.getShell(nl + lc);
+          const AOShell* shell_4 = dftbasis.getShell(ld);
+          tensor4d block_generic(extents4[shell_1->getNumFunc()][shell_2->getNumFunc()]
+                  [shell_3->getNumFunc()][shell_4->getNumFunc()]);
+          tensor4d block(extents4[shell_1->getNumFunc()][shell_2->getNumFunc()]
+                  [shell_3->getNumFunc()][shell_4->getNumFunc()]);
+          std::fill_n(block_generic.data(), block_generic.num_elements(), 0.0);
+          std::fill_n(block.data(), block.num_elements(), 0.0);
+          auto start = Clock::now();
+          for (int r = 0; r < repetitions; r++) {
+            fourcenter.FillFourCenterRepBlockGeneric(block_generic, shell_1, shell_2, shell_3, shell_4);
+          }
+          double time_generic = Seconds(start);
+          start = Clock::now();
+          for (int r = 0; r < repetitions; r++) {
+            fourcenter.FillFourCenterRepBlock(block, shell_1, shell_2, shell_3, shell_4);
+          }
+          double time_specialised = Seconds(start);
+          total_generic += time_generic;
+          total_specialised += time_specialised;
+          std::string name = types[la] + types[lb] + "|" + types[lc] + types[ld];
+          PrintRow(name, repetitions, time_generic, time_specialised, MaxDiff(block, block_generic));
+        }
+      }
+    }
+  }
+  std::cout << boost::format("total speedup %1$.2f") % (total_generic / total_specialised) << std::endl;
+  return 0;
+}
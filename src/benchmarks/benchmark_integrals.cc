@@ -0,0 +1,152 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <boost/format.hpp>
+#include <votca/xtp/aobasis.h>
+#include <votca/xtp/aomatrix.h>
+#include <votca/xtp/basisset.h>
+#include <votca/xtp/qmatom.h>
+#include <votca/xtp/threecenter.h>
+
+using namespace votca;
+using namespace votca::xtp;
+
+/*
+ * Cost of the AO integrals on a cubic cluster of carbon atoms with a
+ * 3s3p3d basis and a 2s2p2d2f aux basis: the one electron matrices of
+ * DFTEngine::SetupInvariantMatrices, TCMatrix_gwbse::Fill and the
+ * spherical transformations of all primitive pairs, recalculated as before
+ * the cache in AOGaussianPrimitive and read from the cache.
+ *
+ * usage: benchmark_integrals [atoms_per_edge] [levels]
+ * defaults are 3x3x3 atoms and 20 m levels in TCMatrix_gwbse.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  int edge = (argc > 1) ? std::atoi(argv[1]) : 3;
+  int levels = (argc > 2) ? std::atoi(argv[2]) : 20;
+
+  BasisSet bs;
+  Element& element = bs.addElement("C");
+  BasisSet auxbs;
+  Element& auxelement = auxbs.addElement("C");
+  const std::vector<std::string> types = {"S", "P", "D", "F"};
+  for (unsigned l = 0; l < types.size(); l++) {
+    std::vector<double> contraction(l + 1, 0.0);
+    contraction[l] = 1.0;
+    if (l < 3) {
+      Shell& shell = element.addShell(types[l], 1.0);
+      const double decays[] = {8.0, 1.5, 0.35};
+      for (double decay : decays) {
+        shell.addGaussian(decay, contraction);
+      }
+    }
+    const double auxdecays[] = {3.0, 0.6};
+    for (double decay : auxdecays) {
+      Shell& auxshell = auxelement.addShell(types[l], 1.0);
+      auxshell.addGaussian(decay, contraction);
+    }
+  }
+
+  std::vector<QMAtom*> atoms;
+  for (int i = 0; i < edge; i++) {
+    for (int j = 0; j < edge; j++) {
+      for (int k = 0; k < edge; k++) {
+        atoms.push_back(new QMAtom(atoms.size(), "C", 2.9 * i, 2.9 * j, 2.9 * k));
+      }
+    }
+  }
+
+  auto start = Clock::now();
+  AOBasis dftbasis;
+  dftbasis.AOBasisFill(bs, atoms);
+  double time_basis = Seconds(start);
+  AOBasis auxbasis;
+  auxbasis.AOBasisFill(auxbs, atoms);
+  levels = std::min(levels, dftbasis.AOBasisSize());
+
+  std::cout << boost::format("AO integrals: %1% atoms, %2% basis functions, %3% aux functions")
+          % atoms.size() % dftbasis.AOBasisSize() % auxbasis.AOBasisSize() << std::endl;
+  std::cout << boost::format("AOBasisFill with shell pair data: %1$.4f s, %2% primitive pairs")
+          % time_basis % dftbasis.getShellPairData().getNumberOfPairs() << std::endl;
+
+  // every FillBlock used to rebuild the transformation of both primitives
+  const ShellPairData& shellpairs = dftbasis.getShellPairData();
+  double checksum = 0.0;
+  start = Clock::now();
+  for (unsigned row = 0; row < dftbasis.getNumofShells(); row++) {
+    for (unsigned col = 0; col <= row; col++) {
+      for (const ShellPairData::PrimitivePair& pair : shellpairs.getPairs(row, col)) {
+        const Eigen::MatrixXd trafo_row = AOSuperMatrix::CalcTrafo(*pair.first);
+        const Eigen::MatrixXd trafo_col = AOSuperMatrix::CalcTrafo(*pair.second);
+        checksum += trafo_row(0, 0) * trafo_col(0, 0);
+      }
+    }
+  }
+  double time_calc = Seconds(start);
+  start = Clock::now();
+  for (unsigned row = 0; row < dftbasis.getNumofShells(); row++) {
+    for (unsigned col = 0; col <= row; col++) {
+      for (const ShellPairData::PrimitivePair& pair : shellpairs.getPairs(row, col)) {
+        const Eigen::MatrixXd& trafo_row = AOSuperMatrix::getTrafo(*pair.first);
+        const Eigen::MatrixXd& trafo_col = AOSuperMatrix::getTrafo(*pair.second);
+        checksum -= trafo_row(0, 0) * trafo_col(0, 0);
+      }
+    }
+  }
+  double time_cached = Seconds(start);
+  std::cout << boost::format("%1$-28s %2$12s") % "step" % "time[s]" << std::endl;
+  std::cout << boost::format("%1$-28s %2$12.4f") % "trafos recalculated" % time_calc << std::endl;
+  std::cout << boost::format("%1$-28s %2$12.4f") % "trafos cached" % time_cached << std::endl;
+
+  start = Clock::now();
+  AOOverlap overlap;
+  overlap.Fill(dftbasis);
+  std::cout << boost::format("%1$-28s %2$12.4f") % "AOOverlap::Fill" % Seconds(start) << std::endl;
+
+  start = Clock::now();
+  AOKinetic kinetic;
+  kinetic.Fill(dftbasis);
+  std::cout << boost::format("%1$-28s %2$12.4f") % "AOKinetic::Fill" % Seconds(start) << std::endl;
+
+  start = Clock::now();
+  AOESP esp;
+  esp.Fillnucpotential(dftbasis, atoms);
+  std::cout << boost::format("%1$-28s %2$12.4f") % "AOESP::Fillnucpotential" % Seconds(start) << std::endl;
+
+  Eigen::MatrixXd mos = Eigen::MatrixXd::Random(dftbasis.AOBasisSize(), dftbasis.AOBasisSize());
+  TCMatrix_gwbse Mmn;
+  Mmn.Initialize(auxbasis.AOBasisSize(), 0, levels - 1, 0, dftbasis.AOBasisSize() - 1);
+  start = Clock::now();
+  Mmn.Fill(auxbasis, dftbasis, mos);
+  std::cout << boost::format("%1$-28s %2$12.4f") % "TCMatrix_gwbse::Fill" % Seconds(start) << std::endl;
+
+  std::cout << "checksum " << checksum + overlap.Matrix().sum() << std::endl;
+  for (QMAtom* atom : atoms) {
+    delete atom;
+  }
+  return 0;
+}
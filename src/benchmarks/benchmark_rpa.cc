@@ -0,0 +1,81 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <boost/format.hpp>
+#include <votca/xtp/rpa.h>
+#include <votca/xtp/threecenter.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace votca::xtp;
+
+/*
+ * Thread scaling of RPA::calculate_epsilon on random three-center integrals.
+ *
+ * usage: benchmark_rpa [n_occ] [n_unocc] [auxsize] [max_threads]
+ * defaults are 100 occupied, 400 unoccupied levels, 1000 aux functions and
+ * all available threads. Threads are doubled starting from 1.
+ */
+int main(int argc, char** argv) {
+  int n_occ = (argc > 1) ? std::atoi(argv[1]) : 100;
+  int n_unocc = (argc > 2) ? std::atoi(argv[2]) : 400;
+  int auxsize = (argc > 3) ? std::atoi(argv[3]) : 1000;
+  int max_threads = 1;
+#ifdef _OPENMP
+  max_threads = omp_get_max_threads();
+#endif
+  if (argc > 4) {
+    max_threads = std::atoi(argv[4]);
+  }
+
+  int levels = n_occ + n_unocc;
+  TCMatrix_gwbse Mmn;
+  Mmn.Initialize(auxsize, 0, levels - 1, 0, levels - 1);
+  for (int i = 0; i < levels; i++) {
+    Mmn[i] = MatrixXfd::Random(levels, auxsize);
+  }
+  Eigen::VectorXd energies(levels);
+  for (int i = 0; i < levels; i++) {
+    energies(i) = -0.5 + 0.01 * i + ((i < n_occ) ? 0.0 : 0.3);
+  }
+  Eigen::VectorXd screen_r = Eigen::VectorXd::Zero(1);
+  Eigen::VectorXd screen_i = Eigen::VectorXd::Constant(1, 0.5);
+
+  std::cout << boost::format("RPA epsilon: occ %1% unocc %2% aux %3%") % n_occ % n_unocc % auxsize << std::endl;
+  std::cout << boost::format("%1$8s %2$12s %3$10s") % "threads" % "time[s]" % "speedup" << std::endl;
+  double time_serial = 0.0;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    RPA rpa;
+    rpa.configure(n_occ - 1, 0, levels - 1);
+    rpa.setScreening(screen_r, screen_i);
+    auto start = std::chrono::steady_clock::now();
+    rpa.calculate_epsilon(energies, Mmn);
+    auto end = std::chrono::steady_clock::now();
+    double time = std::chrono::duration<double>(end - start).count();
+    if (threads == 1) {
+      time_serial = time;
+    }
+    std::cout << boost::format("%1$8d %2$12.4f %3$10.2f") % threads % time % (time_serial / time) << std::endl;
+  }
+  return 0;
+}
@@ -20,6 +20,7 @@
 
 #include <votca/xtp/ERIs.h>
 #include <votca/xtp/symmetric_matrix.h>
+#include <algorithm>
 
 namespace votca {
     namespace xtp {
@@ -38,73 +39,76 @@ namespace votca {
         }
 
         
+        void ERIs::Initialize_4c_disk(AOBasis &dftbasis, const std::string& filename) {
+          // with screening enabled beforehand the negligible quartets are not written
+          if (_with_screening) {
+            _fourcenter.Fill_4c_disk(dftbasis, filename, _schwarz_shellpairs, _screening_eps);
+          } else {
+            _fourcenter.Fill_4c_disk(dftbasis, filename, Eigen::MatrixXd(), 0.0);
+          }
+          return;
+        }
+
+        
         void ERIs::Initialize_4c_screening(AOBasis &dftbasis, double eps) {
           
           _with_screening = true;
           _screening_eps = eps;
-          CalculateERIsDiagonals(dftbasis);
+          CalculateSchwarzShellpairs(dftbasis);
           return;
         }
         
         
         void ERIs::CalculateERIs(const Eigen::MatrixXd &DMAT) {
-
-          unsigned nthreads = 1;
-          #ifdef _OPENMP
-            nthreads = omp_get_max_threads();
-          #endif
-          std::vector<Eigen::MatrixXd >ERIS_thread;
-
-          for (unsigned i = 0; i < nthreads; ++i) {
-            Eigen::MatrixXd thread = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-            ERIS_thread.push_back(thread);
-          }
-
-          #pragma omp parallel for
-          for (unsigned thread = 0; thread < nthreads; ++thread) {
-            Symmetric_Matrix dmat_sym = Symmetric_Matrix(DMAT);
-            for (int _i = thread; _i < _threecenter.getSize(); _i += nthreads) {
-              const Symmetric_Matrix &threecenter = _threecenter.getDatamatrix(_i);
-              // Trace over prod::DMAT,I(l)=componentwise product over 
-              double factor = threecenter.TraceofProd(dmat_sym);
-              threecenter.AddtoEigenMatrix(ERIS_thread[thread], factor);
+          // J = sum_P B_P Tr(B_P D), with all B_P packed into one matrix this is two GEMVs
+          const int size = DMAT.rows();
+          const Eigen::MatrixXd& threecenter = _threecenter.getData();
+          Eigen::VectorXd dmat_packed(threecenter.rows());
+          for (int i = 0; i < size; ++i) {
+            const int start = (i * (i + 1)) / 2;
+            for (int j = 0; j < i; ++j) {
+              dmat_packed(start + j) = 2.0 * DMAT(i, j);
             }
+            dmat_packed(start + i) = DMAT(i, i);
           }
-
-          _ERIs = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-          for (const auto& thread : ERIS_thread) {
-            _ERIs += thread;
+          const Eigen::VectorXd factors = threecenter.transpose() * dmat_packed;
+          const Eigen::VectorXd eris_packed = threecenter * factors;
+
+          _ERIs = Eigen::MatrixXd(size, size);
+          for (int i = 0; i < size; ++i) {
+            const int start = (i * (i + 1)) / 2;
+            for (int j = 0; j <= i; ++j) {
+              _ERIs(i, j) = eris_packed(start + j);
+              _ERIs(j, i) = eris_packed(start + j);
+            }
           }
 
           CalculateEnergy(DMAT);
           return;
         }
 
-        
-        void ERIs::CalculateEXX(const Eigen::MatrixXd &DMAT) {
-      
-          int nthreads = 1;
-          #ifdef _OPENMP
-            nthreads = omp_get_max_threads();
-          #endif
-          std::vector<Eigen::MatrixXd >EXX_thread;
-
-          for (int i = 0; i < nthreads; ++i) {
-            Eigen::MatrixXd thread = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-            EXX_thread.push_back(thread);
-          }
+        int ERIs::EXXBatchSize() const {
+          // aux functions per batch, so that a batch of full matrices is about 128MB
+          const int basissize = _threecenter.getBasisSize();
+          const int batchsize = 16000000 / (basissize * basissize);
+          return std::max(1, std::min(batchsize, _threecenter.getSize()));
+        }
 
-          #pragma omp parallel for
-          for (int thread = 0; thread < nthreads; ++thread) {
-            Eigen::MatrixXd D=DMAT;
-            for(int i=thread;i<_threecenter.getSize();i+= nthreads){
-              const Eigen::MatrixXd threecenter = _threecenter.getDatamatrix(i).FullMatrix();
-              EXX_thread[thread].noalias()+=threecenter*D*threecenter;
+        void ERIs::CalculateEXX(const Eigen::MatrixXd &DMAT) {
+          // K = sum_P B_P D B_P, done for batches of aux functions with two large GEMMs
+          const int size = DMAT.rows();
+          const int batchsize = EXXBatchSize();
+          _EXXs = Eigen::MatrixXd::Zero(size, size);
+          for (int start = 0; start < _threecenter.getSize(); start += batchsize) {
+            const int count = std::min(batchsize, _threecenter.getSize() - start);
+            const Eigen::MatrixXd stacked = _threecenter.getStackedMatrices(start, count);
+            // blocks B_P*D are transposed to D*B_P in place
+            Eigen::MatrixXd BxD = stacked * DMAT;
+            #pragma omp parallel for
+            for (int i = 0; i < count; ++i) {
+              BxD.middleRows(i * size, size).transposeInPlace();
             }
-          }
-          _EXXs = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-          for (const auto& thread : EXX_thread) {
-            _EXXs += thread;
+            _EXXs.noalias() += stacked.transpose() * BxD;
           }
 
           CalculateEXXEnergy(DMAT);
@@ -113,30 +117,23 @@ namespace votca {
     
         
         void ERIs::CalculateEXX(const Eigen::Block<Eigen::MatrixXd>& occMos,const Eigen::MatrixXd  &DMAT) {
-
-          int nthreads = 1;
-          #ifdef _OPENMP
-            nthreads = omp_get_max_threads();
-          #endif
-          std::vector<Eigen::MatrixXd >EXX_thread;
-
-          for (int i = 0; i < nthreads; ++i) {
-            Eigen::MatrixXd thread = Eigen::MatrixXd::Zero(occMos.rows(), occMos.rows());
-            EXX_thread.push_back(thread);
-          }
-
-          #pragma omp parallel for
-          for (int thread = 0; thread < nthreads; ++thread) {
-            Eigen::MatrixXd occ=occMos;
-            for(int i=thread;i<_threecenter.getSize();i+= nthreads){
-              const Eigen::MatrixXd TCxMOs_T = occ.transpose()*_threecenter.getDatamatrix(i).FullMatrix();
-              EXX_thread[thread].noalias()+=TCxMOs_T.transpose()*TCxMOs_T;
+          // K = 2 sum_P (B_P C)(B_P C)^T, done for batches of aux functions as one GEMM and one rank update
+          const int size = occMos.rows();
+          const int occ = occMos.cols();
+          const int batchsize = EXXBatchSize();
+          const Eigen::MatrixXd C = occMos;
+          _EXXs = Eigen::MatrixXd::Zero(size, size);
+          for (int start = 0; start < _threecenter.getSize(); start += batchsize) {
+            const int count = std::min(batchsize, _threecenter.getSize() - start);
+            const Eigen::MatrixXd BxC = _threecenter.getStackedMatrices(start, count) * C;
+            Eigen::MatrixXd BxC_row(size, count * occ);
+            #pragma omp parallel for
+            for (int i = 0; i < count; ++i) {
+              BxC_row.middleCols(i * occ, occ) = BxC.middleRows(i * size, size);
             }
+            _EXXs.selfadjointView<Eigen::Lower>().rankUpdate(BxC_row, 2.0);
           }
-          _EXXs = Eigen::MatrixXd::Zero(occMos.rows(), occMos.rows());
-          for (const auto& thread : EXX_thread) {
-            _EXXs += 2*thread;
-          }
+          _EXXs.triangularView<Eigen::StrictlyUpper>() = _EXXs.transpose();
 
           CalculateEXXEnergy(DMAT);
           return;
@@ -145,24 +142,31 @@ namespace votca {
         
         void ERIs::CalculateERIs_4c_small_molecule(const Eigen::MatrixXd  &DMAT) {
 
+          if (_fourcenter.isOnDisk()) {
+            _ERIs = ContractFourCenterDisk(DMAT, false);
+            CalculateEnergy(DMAT);
+            return;
+          }
+
           _ERIs = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
           
           const Eigen::VectorXd& _4c_vector = _fourcenter.get_4c_vector();
 
           int dftBasisSize = DMAT.rows();
-          int vectorSize = (dftBasisSize*(dftBasisSize+1))/2;
+          // packed indices exceed the int range for a few hundred basis functions
+          long vectorSize = (long(dftBasisSize)*(dftBasisSize+1))/2;
           #pragma omp parallel for
           for (int _i = 0; _i < dftBasisSize; _i++) {
-            int sum_i = (_i*(_i+1))/2;
+            long sum_i = (_i*(_i+1))/2;
             for (int _j = _i; _j < dftBasisSize; _j++) {
-              int _index_ij = dftBasisSize * _i - sum_i + _j;
-              int _index_ij_kl_a = vectorSize * _index_ij - (_index_ij*(_index_ij+1))/2;
+              long _index_ij = dftBasisSize * _i - sum_i + _j;
+              long _index_ij_kl_a = vectorSize * _index_ij - (_index_ij*(_index_ij+1))/2;
               for (int _k = 0; _k < dftBasisSize; _k++) {
-                int sum_k = (_k*(_k+1))/2;
+                long sum_k = (_k*(_k+1))/2;
                 for (int _l = _k; _l < dftBasisSize; _l++) {
-                  int _index_kl = dftBasisSize * _k - sum_k + _l;
+                  long _index_kl = dftBasisSize * _k - sum_k + _l;
 
-                  unsigned _index_ij_kl = _index_ij_kl_a + _index_kl;
+                  long _index_ij_kl = _index_ij_kl_a + _index_kl;
                   if (_index_ij > _index_kl) _index_ij_kl = vectorSize * _index_kl - (_index_kl*(_index_kl+1))/2 + _index_ij;
 
                   if (_l == _k) {
@@ -183,6 +187,11 @@ namespace votca {
         
         
         void ERIs::CalculateEXX_4c_small_molecule(const Eigen::MatrixXd &DMAT) {
+          if (_fourcenter.isOnDisk()) {
+            _EXXs = ContractFourCenterDisk(DMAT, true);
+            CalculateEXXEnergy(DMAT);
+            return;
+          }
           int nthreads = 1;
           #ifdef _OPENMP
             nthreads = omp_get_max_threads();
@@ -198,20 +207,20 @@ namespace votca {
           const Eigen::VectorXd& _4c_vector = _fourcenter.get_4c_vector();
 
           int dftBasisSize = DMAT.rows();
-          int vectorSize = (dftBasisSize*(dftBasisSize+1))/2;
+          long vectorSize = (long(dftBasisSize)*(dftBasisSize+1))/2;
           #pragma omp parallel for
           for (int thread = 0; thread < nthreads; ++thread) {
             for (int _i = thread; _i < dftBasisSize; _i+= nthreads) {
-              int sum_i = (_i*(_i+1))/2;
+              long sum_i = (_i*(_i+1))/2;
               for (int _j = _i; _j < dftBasisSize; _j++) {
-                int _index_ij = DMAT.cols() * _i - sum_i + _j;
-                int _index_ij_kl_a = vectorSize * _index_ij - (_index_ij*(_index_ij+1))/2;
+                long _index_ij = DMAT.cols() * _i - sum_i + _j;
+                long _index_ij_kl_a = vectorSize * _index_ij - (_index_ij*(_index_ij+1))/2;
                 for (int _k = 0; _k < dftBasisSize; _k++) {
-                  int sum_k = (_k*(_k+1))/2;
+                  long sum_k = (_k*(_k+1))/2;
                   for (int _l = _k; _l < dftBasisSize; _l++) {
-                    int _index_kl = DMAT.cols() * _k - sum_k + _l;
+                    long _index_kl = DMAT.cols() * _k - sum_k + _l;
 
-                    int _index_ij_kl = _index_ij_kl_a + _index_kl;
+                    long _index_ij_kl = _index_ij_kl_a + _index_kl;
                     if (_index_ij > _index_kl) _index_ij_kl = vectorSize * _index_kl - (_index_kl*(_index_kl+1))/2 + _index_ij;
                     double factorij=1;
                     if(_i==_j){factorij=0.5;}
@@ -235,125 +244,261 @@ namespace votca {
           CalculateEXXEnergy(DMAT);
           return;
         }
+
+
+        Eigen::MatrixXd ERIs::ContractFourCenterDisk(const Eigen::MatrixXd& DMAT, bool exchange) const {
+          int nthreads = 1;
+          #ifdef _OPENMP
+            nthreads = omp_get_max_threads();
+          #endif
+          std::vector<Eigen::MatrixXd> result_thread(nthreads, Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols()));
+          const long dftBasisSize = DMAT.rows();
+
+          // every quartet of the file is read once, only the unique (12|34) with
+          // 1<=2, 3<=4 and pair 34<=12 of each block are contracted. The integral
+          // also stands for (34|12), which is added unless both pairs coincide.
+          _fourcenter.ReadDiskBatches([&](const std::vector<FCMatrix::DiskQuartet>& quartets) {
+            const int nquartets = quartets.size();
+            #pragma omp parallel for schedule(dynamic)
+            for (int q = 0; q < nquartets; ++q) {
+              int thread = 0;
+              #ifdef _OPENMP
+                thread = omp_get_thread_num();
+              #endif
+              Eigen::MatrixXd& result = result_thread[thread];
+              const FCMatrix::DiskQuartet& quartet = quartets[q];
+              const double* value = quartet.block;
+              for (int i_1 = 0; i_1 < quartet.numfunc[0]; ++i_1) {
+                const long ind_1 = quartet.start[0] + i_1;
+                for (int i_2 = 0; i_2 < quartet.numfunc[1]; ++i_2) {
+                  const long ind_2 = quartet.start[1] + i_2;
+                  const long index_12 = dftBasisSize * ind_1 - (ind_1 * (ind_1 + 1)) / 2 + ind_2;
+                  for (int i_3 = 0; i_3 < quartet.numfunc[2]; ++i_3) {
+                    const long ind_3 = quartet.start[2] + i_3;
+                    for (int i_4 = 0; i_4 < quartet.numfunc[3]; ++i_4, ++value) {
+                      const long ind_4 = quartet.start[3] + i_4;
+                      if (ind_1 > ind_2 || ind_3 > ind_4) continue;
+                      const long index_34 = dftBasisSize * ind_3 - (ind_3 * (ind_3 + 1)) / 2 + ind_4;
+                      if (index_34 > index_12) continue;
+                      const bool swapped = (index_34 != index_12);
+                      const double eri = *value;
+                      if (exchange) {
+                        double factor = eri;
+                        if (ind_1 == ind_2) factor *= 0.5;
+                        if (ind_3 == ind_4) factor *= 0.5;
+                        result(ind_1, ind_4) += factor * DMAT(ind_2, ind_3);
+                        result(ind_2, ind_4) += factor * DMAT(ind_1, ind_3);
+                        result(ind_1, ind_3) += factor * DMAT(ind_2, ind_4);
+                        result(ind_2, ind_3) += factor * DMAT(ind_1, ind_4);
+                        if (swapped) {
+                          result(ind_4, ind_1) += factor * DMAT(ind_3, ind_2);
+                          result(ind_4, ind_2) += factor * DMAT(ind_3, ind_1);
+                          result(ind_3, ind_1) += factor * DMAT(ind_4, ind_2);
+                          result(ind_3, ind_2) += factor * DMAT(ind_4, ind_1);
+                        }
+                      } else {
+                        result(ind_1, ind_2) += ((ind_3 == ind_4) ? 1.0 : 2.0) * DMAT(ind_3, ind_4) * eri;
+                        if (swapped) {
+                          result(ind_3, ind_4) += ((ind_1 == ind_2) ? 1.0 : 2.0) * DMAT(ind_1, ind_2) * eri;
+                        }
+                      }
+                    }
+                  }
+                }
+              }
+            }
+          });
+
+          Eigen::MatrixXd result = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+          for (const auto& thread : result_thread) {
+            result += thread;
+          }
+          if (!exchange) {
+            // only the upper triangle of J was accumulated
+            result.triangularView<Eigen::StrictlyLower>() = result.transpose();
+          }
+          return result;
+        }
         
         
         void ERIs::CalculateERIs_4c_direct(const AOBasis& dftbasis, const Eigen::MatrixXd &DMAT) {
+          _ERIs = ContractFourCenterDirect(dftbasis, DMAT);
+          CalculateEnergy(DMAT);
+          return;
+        }
+
+
+        void ERIs::CalculateERIs_4c_direct_incremental(const AOBasis& dftbasis, const Eigen::MatrixXd &DMAT) {
+          // J is linear in D, so J[D] = J[D_old] + J[D - D_old]. Close to convergence
+          // the density change is small and most quartets fail the density
+          // weighted Schwarz test. Screening errors accumulate, so the full
+          // density is contracted again every _incremental_rebuild builds.
+          bool full_build = (_dmat_previous.rows() != DMAT.rows()
+                  || _incremental_steps >= _incremental_rebuild);
+          if (full_build) {
+            _ERIs = ContractFourCenterDirect(dftbasis, DMAT);
+            _incremental_steps = 0;
+          } else {
+            _ERIs += ContractFourCenterDirect(dftbasis, DMAT - _dmat_previous);
+            _incremental_steps++;
+          }
+          _dmat_previous = DMAT;
+          CalculateEnergy(DMAT);
+          return;
+        }
+
+
+        Eigen::MatrixXd ERIs::ShellDensityMaxima(const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT) const {
+          int numShells = dftbasis.getNumofShells();
+          Eigen::MatrixXd dmax = Eigen::MatrixXd::Zero(numShells, numShells);
+          for (int iShell_1 = 0; iShell_1 < numShells; iShell_1++) {
+            const AOShell& shell_1 = *dftbasis.getShell(iShell_1);
+            for (int iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
+              const AOShell& shell_2 = *dftbasis.getShell(iShell_2);
+              dmax(iShell_1, iShell_2) = DMAT.block(shell_1.getStartIndex(), shell_2.getStartIndex(),
+                      shell_1.getNumFunc(), shell_2.getNumFunc()).cwiseAbs().maxCoeff();
+              dmax(iShell_2, iShell_1) = dmax(iShell_1, iShell_2);
+            }
+          }
+          return dmax;
+        }
+
+
+        Eigen::MatrixXd ERIs::ContractFourCenterDirect(const AOBasis& dftbasis, const Eigen::MatrixXd &DMAT) {
 
-          tensor4d::extent_gen extents;
-          
           // Number of shells
           int numShells = dftbasis.getNumofShells();
           
-          // Initialize ERIs matrix
-          _ERIs = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+          Eigen::MatrixXd result = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+
+          // shell pairs (3,4) sorted by cost, handed out dynamically
+          const std::vector<FCMatrix::ShellPairTask> tasks = FCMatrix::SortedShellPairTasks(dftbasis);
+          const int ntasks = tasks.size();
+
+          // (12|34) enters J_34 with D_12 and J_12 with D_34
+          Eigen::MatrixXd dmax;
+          if (_with_screening) {
+            dmax = ShellDensityMaxima(dftbasis, DMAT);
+          }
+          long computed = 0;
+          long skipped = 0;
 
           #pragma omp parallel
           { // Begin omp parallel
 
             Eigen::MatrixXd ERIs_thread = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+            // reused for every quartet, only the leading numFunc entries are touched
+            tensor4d block = FCMatrix::QuartetBuffer(dftbasis);
+            tensor4d block2 = FCMatrix::QuartetBuffer(dftbasis);
             
-            #pragma omp for
-            for (int iShell_3 = 0; iShell_3 < numShells; iShell_3++) {
+            #pragma omp for schedule(dynamic) reduction(+:computed,skipped)
+            for (int task = 0; task < ntasks; task++) {
+              const int iShell_3 = tasks[task].shell_3;
+              const int iShell_4 = tasks[task].shell_4;
               const AOShell& shell_3 = *dftbasis.getShell(iShell_3);
               int numFunc_3 = shell_3.getNumFunc();
-              for (int iShell_4 = iShell_3; iShell_4 < numShells; iShell_4++) {
-                const AOShell& shell_4 = *dftbasis.getShell(iShell_4);
-                int numFunc_4 = shell_4.getNumFunc();    
-                for (int iShell_1 = iShell_3; iShell_1 < numShells; iShell_1++) {
-                  const AOShell& shell_1 = *dftbasis.getShell(iShell_1);
-                  int numFunc_1 = shell_1.getNumFunc();
-                  for (int iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
-                    const AOShell& shell_2 = *dftbasis.getShell(iShell_2);
-                    int numFunc_2 = shell_2.getNumFunc();
-
-                    // Pre-screening
-                    if (_with_screening && CheckScreen(_screening_eps, shell_1, shell_2, shell_3, shell_4))
+              const AOShell& shell_4 = *dftbasis.getShell(iShell_4);
+              int numFunc_4 = shell_4.getNumFunc();    
+              for (int iShell_1 = iShell_3; iShell_1 < numShells; iShell_1++) {
+                const AOShell& shell_1 = *dftbasis.getShell(iShell_1);
+                int numFunc_1 = shell_1.getNumFunc();
+                for (int iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
+                  const AOShell& shell_2 = *dftbasis.getShell(iShell_2);
+                  int numFunc_2 = shell_2.getNumFunc();
+
+                  // Density weighted Cauchy-Schwarz screening
+                  // |(12|34) D| <= sqrt((12|12)) sqrt((34|34)) max(|D_12|,|D_34|)
+                  if (_with_screening) {
+                    double bound = _schwarz_shellpairs(iShell_1, iShell_2) * _schwarz_shellpairs(iShell_3, iShell_4)
+                            * std::max(dmax(iShell_1, iShell_2), dmax(iShell_3, iShell_4));
+                    if (bound < _screening_eps) {
+                      skipped++;
                       continue;
+                    }
+                  }
+                  computed++;
+                  // Get the current 4c block
+                  for (int i = 0; i < numFunc_1; ++i) {
+                    for (int j = 0; j < numFunc_2; ++j) {
+                      for (int k = 0; k < numFunc_3; ++k) {
+                        for (int l = 0; l < numFunc_4; ++l) {
+                          block[i][j][k][l] = 0.0;
+                        }
+                      }
+                    }
+                  }
+                  bool nonzero=_fourcenter.FillFourCenterRepBlock(block, &shell_1, &shell_2, &shell_3, &shell_4);
+                  
+                  // If there are only zeros, we don't need to put anything in the ERIs matrix
+                  if (!nonzero)
+                    continue;
+
+                  // Begin fill ERIs matrix
 
-                    // Get the current 4c block
-                    tensor4d block(extents[ range(0, numFunc_1) ][ range(0, numFunc_2) ][ range(0, numFunc_3)][ range(0, numFunc_4)]);
+                  FillERIsBlock(ERIs_thread, DMAT, block, shell_1, shell_2, shell_3, shell_4);
+
+                  // Symmetry 1 <--> 2
+                  if (iShell_1 != iShell_2)
+                    FillERIsBlock(ERIs_thread, DMAT, block, shell_2, shell_1, shell_3, shell_4);
+
+                  // Symmetry 3 <--> 4
+                  if (iShell_3 != iShell_4)
+                    FillERIsBlock(ERIs_thread, DMAT, block, shell_1, shell_2, shell_4, shell_3);
+
+                  // Symmetry 1 <--> 2 and 3 <--> 4
+                  if (iShell_1 != iShell_2 && iShell_3 != iShell_4)
+                    FillERIsBlock(ERIs_thread, DMAT, block, shell_2, shell_1, shell_4, shell_3);
+
+                  // Symmetry (1, 2) <--> (3, 4)
+                  if (iShell_1 != iShell_3) {
+
+                    // We need the 'transpose' of block
                     for (int i = 0; i < numFunc_1; ++i) {
                       for (int j = 0; j < numFunc_2; ++j) {
                         for (int k = 0; k < numFunc_3; ++k) {
                           for (int l = 0; l < numFunc_4; ++l) {
-                            block[i][j][k][l] = 0.0;
+                            block2[k][l][i][j] = block[i][j][k][l];
                           }
                         }
                       }
                     }
-                    bool nonzero=_fourcenter.FillFourCenterRepBlock(block, &shell_1, &shell_2, &shell_3, &shell_4);
-                    
-                    // If there are only zeros, we don't need to put anything in the ERIs matrix
-                    if (!nonzero)
-                      continue;
 
-                    // Begin fill ERIs matrix
-
-                    FillERIsBlock(ERIs_thread, DMAT, block, shell_1, shell_2, shell_3, shell_4);
+                    FillERIsBlock(ERIs_thread, DMAT, block2, shell_3, shell_4, shell_1, shell_2);
 
                     // Symmetry 1 <--> 2
                     if (iShell_1 != iShell_2)
-                      FillERIsBlock(ERIs_thread, DMAT, block, shell_2, shell_1, shell_3, shell_4);
+                      FillERIsBlock(ERIs_thread, DMAT, block2, shell_3, shell_4, shell_2, shell_1);
 
                     // Symmetry 3 <--> 4
                     if (iShell_3 != iShell_4)
-                      FillERIsBlock(ERIs_thread, DMAT, block, shell_1, shell_2, shell_4, shell_3);
+                      FillERIsBlock(ERIs_thread, DMAT, block2, shell_4, shell_3, shell_1, shell_2);
 
                     // Symmetry 1 <--> 2 and 3 <--> 4
                     if (iShell_1 != iShell_2 && iShell_3 != iShell_4)
-                      FillERIsBlock(ERIs_thread, DMAT, block, shell_2, shell_1, shell_4, shell_3);
-
-                    // Symmetry (1, 2) <--> (3, 4)
-                    if (iShell_1 != iShell_3) {
-
-                      // We need the 'transpose' of block
-                      tensor4d block2(extents[ range(0, numFunc_3) ][ range(0, numFunc_4) ][ range(0, numFunc_1)][ range(0, numFunc_2)]);
-                      for (int i = 0; i < numFunc_1; ++i) {
-                        for (int j = 0; j < numFunc_2; ++j) {
-                          for (int k = 0; k < numFunc_3; ++k) {
-                            for (int l = 0; l < numFunc_4; ++l) {
-                              block2[k][l][i][j] = block[i][j][k][l];
-                            }
-                          }
-                        }
-                      }
-
-                      FillERIsBlock(ERIs_thread, DMAT, block2, shell_3, shell_4, shell_1, shell_2);
-
-                      // Symmetry 1 <--> 2
-                      if (iShell_1 != iShell_2)
-                        FillERIsBlock(ERIs_thread, DMAT, block2, shell_3, shell_4, shell_2, shell_1);
-
-                      // Symmetry 3 <--> 4
-                      if (iShell_3 != iShell_4)
-                        FillERIsBlock(ERIs_thread, DMAT, block2, shell_4, shell_3, shell_1, shell_2);
-
-                      // Symmetry 1 <--> 2 and 3 <--> 4
-                      if (iShell_1 != iShell_2 && iShell_3 != iShell_4)
-                        FillERIsBlock(ERIs_thread, DMAT, block2, shell_4, shell_3, shell_2, shell_1);
-                    }
+                      FillERIsBlock(ERIs_thread, DMAT, block2, shell_4, shell_3, shell_2, shell_1);
+                  }
 
-                    // End fill ERIs matrix
-                  } // End loop over shell 2
-                } // End loop over shell 1
-              } // End loop over shell 4
-            } // End loop over shell 3
+                  // End fill ERIs matrix
+                } // End loop over shell 2
+              } // End loop over shell 1
+            } // End loop over shell pair tasks (3,4)
             
             #pragma omp critical
             {    
-              _ERIs += ERIs_thread;
+              result += ERIs_thread;
             }
           } 
 
           // Fill lower triangular part using symmetry
           for (int i = 0; i < DMAT.cols(); i++){
             for (int j = i + 1; j < DMAT.rows(); j++){
-              _ERIs(j, i) = _ERIs(i, j);
+              result(j, i) = result(i, j);
             }
           }
 
-          CalculateEnergy(DMAT);
-          return;
+          _quartets_computed = computed;
+          _quartets_skipped = skipped;
+          return result;
         }
         
         
@@ -396,16 +541,14 @@ namespace votca {
         }
         
         
-        void ERIs::CalculateERIsDiagonals(const AOBasis& dftbasis) {
+        void ERIs::CalculateSchwarzShellpairs(const AOBasis& dftbasis) {
           
           tensor4d::extent_gen extents;
           
           // Number of shells
           int numShells = dftbasis.getNumofShells();
-          // Total number of functions
-          int dftBasisSize = dftbasis.AOBasisSize();
           
-          _diagonals = Eigen::MatrixXd::Zero(dftBasisSize,dftBasisSize);
+          _schwarz_shellpairs = Eigen::MatrixXd::Zero(numShells, numShells);
           
           for (int iShell_1 = 0; iShell_1 < numShells; iShell_1++) {
             const AOShell& shell_1 = *dftbasis.getShell(iShell_1);
@@ -431,25 +574,15 @@ namespace votca {
                 continue;
               }
 
-              for (int iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
-                int ind_1 = shell_1.getStartIndex() + iFunc_1;
-                for (int iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
-                  int ind_2 = shell_2.getStartIndex() + iFunc_2;
-
-                  // Symmetry
-                  if (ind_1 > ind_2) {
-                    continue;
-                  }
-    
-                  _diagonals(ind_1, ind_2) = block[iFunc_1][iFunc_2][iFunc_1][iFunc_2];
-                  
-                  // Symmetry
-                  if (ind_1 != ind_2) {
-                    _diagonals(ind_2, ind_1) = _diagonals(ind_1, ind_2);
-                  }
-
+              // largest sqrt(<ab|ab>) of the shell pair
+              double maxdiagonal = 0.0;
+              for (int iFunc_1 = 0; iFunc_1 < numFunc_1; iFunc_1++) {
+                for (int iFunc_2 = 0; iFunc_2 < numFunc_2; iFunc_2++) {
+                  maxdiagonal = std::max(maxdiagonal, std::abs(block[iFunc_1][iFunc_2][iFunc_1][iFunc_2]));
                 }
               }
+              _schwarz_shellpairs(iShell_1, iShell_2) = std::sqrt(maxdiagonal);
+              _schwarz_shellpairs(iShell_2, iShell_1) = _schwarz_shellpairs(iShell_1, iShell_2);
             }
           }
           
@@ -457,50 +590,6 @@ namespace votca {
         }
         
         
-        bool ERIs::CheckScreen(double eps,
-            const AOShell& shell_1, const AOShell& shell_2,
-            const AOShell& shell_3, const AOShell& shell_4) {
-          
-          const double eps2=eps * eps;
-          
-          for (int iFunc_3 = 0; iFunc_3 < shell_3.getNumFunc(); iFunc_3++) {
-            int ind_3 = shell_3.getStartIndex() + iFunc_3;
-            for (int iFunc_4 = 0; iFunc_4 < shell_4.getNumFunc(); iFunc_4++) {
-              int ind_4 = shell_4.getStartIndex() + iFunc_4;
-
-              // Symmetry
-              if (ind_3 > ind_4) {
-                continue;
-              }
-              
-              for (int iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
-                int ind_1 = shell_1.getStartIndex() + iFunc_1;
-                for (int iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
-                  int ind_2 = shell_2.getStartIndex() + iFunc_2;
-
-                  // Symmetry
-                  if (ind_1 > ind_2) {
-                    continue;
-                  }
-                  
-                  // Cauchy–Schwarz
-                  // <ab|cd> <= sqrt(<ab|ab>) * sqrt(<cd|cd>)
-                  double ub = _diagonals(ind_1, ind_2) * _diagonals(ind_3, ind_4);
-                  
-                  // Compare with tolerance
-                  if (ub > eps2) {
-                    return false; // We must compute ERIS for the whole block
-                  }
-                  
-                }
-              }
-            }
-          }
-          
-          return true; // We can skip the whole block
-        }
-        
-        
         void ERIs::CalculateEnergy(const Eigen::MatrixXd &DMAT){
           _ERIsenergy=_ERIs.cwiseProduct(DMAT).sum();
           return;
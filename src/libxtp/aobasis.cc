@@ -22,6 +22,7 @@
 #include "votca/tools/elements.h"
 #include "votca/xtp/aomatrix.h"
 #include <votca/tools/constants.h>
+#include <mutex>
 
 
 
@@ -33,6 +34,23 @@ namespace votca { namespace xtp {
         _aoshells.clear();
          }
 
+const ShellPairData& AOBasis::getShellPairData()const{
+  std::shared_ptr<const ShellPairData> pairs=std::atomic_load(&_shellpairs);
+  if(!pairs){
+    // callers sit inside parallel loops, so only one thread builds the list
+    static std::mutex fill_mutex;
+    std::lock_guard<std::mutex> lock(fill_mutex);
+    pairs=std::atomic_load(&_shellpairs);
+    if(!pairs){
+      std::shared_ptr<ShellPairData> newpairs=std::make_shared<ShellPairData>();
+      newpairs->Fill(_aoshells);
+      pairs=newpairs;
+      std::atomic_store(&_shellpairs,pairs);
+    }
+  }
+  return *pairs;
+}
+
 AOShell* AOBasis::addShell( const Shell& shell, const QMAtom& atom, int startIndex ){
         AOShell* aoshell = new AOShell( shell, atom, startIndex );
         _aoshells.push_back(aoshell);
@@ -527,6 +545,7 @@ std::vector<int> AOBasis::invertOrder(const std::vector<int>& order ){
       } else {
         _AOBasisFragB = _AOBasisSize - _AOBasisFragA;
       }
+      _shellpairs.reset();
       return;
     }
 
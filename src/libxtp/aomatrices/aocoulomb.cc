@@ -171,7 +171,8 @@ namespace votca { namespace xtp {
             fak = fak *  powfactor_col*powfactor_row;
 
          
-            const std::vector<double> FmT=XIntegrate(nextra, T);
+            BoysFunction::Values FmT;
+            BoysFunction::Evaluate(FmT, mmax, T);
 
             // get initial data from FmT -> s-s element
             for (index3d i = 0; i != nextra; ++i) {
@@ -558,8 +558,8 @@ if (lmax_col > 3) {
 
        
         
-        Eigen::MatrixXd trafo_row = getTrafo(*itr);
-        Eigen::MatrixXd trafo_col= getTrafo(*itc);       
+        const Eigen::MatrixXd& trafo_row = getTrafo(*itr);
+        const Eigen::MatrixXd& trafo_col = getTrafo(*itc);       
        
         // cartesian -> spherical
        
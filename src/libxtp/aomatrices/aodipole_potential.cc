@@ -132,7 +132,8 @@ namespace votca { namespace xtp {
 
         const double U = zeta*(PmC0*PmC0+PmC1*PmC1+PmC2*PmC2);
 
-        const std::vector<double> FmU=XIntegrate(lsum+2, U );
+        BoysFunction::Values FmU;
+        BoysFunction::Evaluate(FmU, lsum+1, U);
 
         typedef boost::multi_array<double, 3> ma_type;
         typedef boost::multi_array<double, 4> ma4_type; //////////////////
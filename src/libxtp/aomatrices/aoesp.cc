@@ -154,7 +154,8 @@ namespace votca { namespace xtp {
         const double U = zeta*(PmC0*PmC0+PmC1*PmC1+PmC2*PmC2);
         
        
-        const std::vector<double>_FmU=XIntegrate(lsum+1,U );
+        BoysFunction::Values _FmU;
+        BoysFunction::Evaluate(_FmU, lsum, U);
         //cout << endl;
         
         
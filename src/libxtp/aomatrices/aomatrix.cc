@@ -124,7 +124,7 @@ namespace votca {
             }
         }
 
-       Eigen::MatrixXd AOSuperMatrix::getTrafo(const AOGaussianPrimitive& gaussian){
+       Eigen::MatrixXd AOSuperMatrix::CalcTrafo(const AOGaussianPrimitive& gaussian){
             ///         0    1  2  3    4  5  6  7  8  9   10  11  12  13  14  15  16  17  18  19       20    21    22    23    24    25    26    27    28    29    30    31    32    33    34 
             ///         s,   x, y, z,   xy xz yz xx yy zz, xxy xyy xyz xxz xzz yyz yzz xxx yyy zzz,    xxxy, xxxz, xxyy, xxyz, xxzz, xyyy, xyyz, xyzz, xzzz, yyyz, yyzz, yzzz, xxxx, yyyy, zzzz,
             const AOShell* shell = gaussian.getShell();
@@ -403,52 +403,6 @@ namespace votca {
         }
 
 
-        template<class T> 
-        std::vector<double> AOMatrix<T>::XIntegrate(int size, double U) {
-            std::vector<double> FmU = std::vector<double>(size, 0.0);
-            const int mm = FmU.size() - 1;
-            const double pi = boost::math::constants::pi<double>();
-            if (mm < 0) {
-                std::cerr << "mm is: " << mm << " This should not have happened!" << std::flush;
-                exit(1);
-            }
-
-            if (U < 0.0) {
-                std::cerr << "U is: " << U << " This should not have happened!" << std::flush;
-                exit(1);
-            }
-
-            if (U >= 10.0) {
-                // forward iteration
-                FmU[0] = 0.50 * sqrt(pi / U) * erf(sqrt(U));
-
-                for (unsigned m = 1; m < FmU.size(); m++) {
-                    FmU[m] = (2.0 * m - 1) * FmU[m - 1] / (2.0 * U) - exp(-U) / (2.0 * U);
-                }
-            }
-
-            if (U < 1e-10) {
-                for (unsigned m = 0; m < FmU.size(); m++) {
-                    FmU[m] = 1.0 / (2.0 * m + 1.0) - U / (2.0 * m + 3.0);
-                }
-            }
-
-
-            if (U >= 1e-10 && U < 10.0) {
-                // backward iteration
-                double fm = 0.0;
-                for (int m = 60; m >= mm; m--) {
-                    fm = (2.0 * U) / (2.0 * m + 1.0) * (fm + exp(-U) / (2.0 * U));
-                }
-                FmU[mm] = fm;
-                for (int m = mm - 1; m >= 0; m--) {
-                    FmU[m] = (2.0 * U) / (2.0 * m + 1.0) * (FmU[m + 1] + exp(-U) / (2.0 * U));
-                }
-            }
-
-            return FmU;
-        }
-        
 int AOSuperMatrix::getBlockSize(int lmax) {
       //Each cartesian shells has (l+1)(l+2)/2 elements
       //Sum of all shells up to _lmax leads to blocksize=1+11/6 l+l^2+1/6 l^3
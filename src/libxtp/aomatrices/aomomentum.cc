@@ -561,8 +561,8 @@ for (int i = 0; i < ncols; i++) {
   }
 }
 
-      Eigen::MatrixXd trafo_row = getTrafo(*itr);
-      Eigen::MatrixXd trafo_col = getTrafo(*itc);
+      const Eigen::MatrixXd& trafo_row = getTrafo(*itr);
+      const Eigen::MatrixXd& trafo_col = getTrafo(*itc);
           // cartesian -> spherical
       for (int i_comp = 0; i_comp < 3; i_comp++) {
         Eigen::MatrixXd mom_sph = trafo_row.transpose() * mom[ i_comp ] * trafo_col;
@@ -539,8 +539,8 @@ namespace votca {
 
                     } // end if (lmax_col > 5)        
 
-                    Eigen::MatrixXd trafo_row = getTrafo(*itr);
-                    Eigen::MatrixXd trafo_col = getTrafo(*itc);
+                    const Eigen::MatrixXd& trafo_row = getTrafo(*itr);
+                    const Eigen::MatrixXd& trafo_col = getTrafo(*itc);
 
                     // cartesian -> spherical
                     Eigen::MatrixXcd olk_sph=trafo_row.transpose()*olk*trafo_col;
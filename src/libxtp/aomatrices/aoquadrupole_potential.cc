@@ -157,7 +157,8 @@ namespace votca { namespace xtp {
         const double U = zeta*(PmC0*PmC0+PmC1*PmC1+PmC2*PmC2);
 
         // +3 quadrupole, +2 dipole, +1 nuclear attraction integrals
-        const std::vector<double> FmU=XIntegrate(lsum+3, U );
+        BoysFunction::Values FmU;
+        BoysFunction::Evaluate(FmU, lsum+2, U);
 
         typedef boost::multi_array<double, 3> ma_type;
         typedef boost::multi_array<double, 4> ma4_type; //////////////////
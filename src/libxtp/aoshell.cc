@@ -21,8 +21,264 @@
 #include <votca/xtp/aomatrix.h>
 
 namespace votca { namespace xtp {
-    
+
+namespace {
+
+  // shell centred coordinates of a batch of grid points as structure of arrays,
+  // so that the kernels below run over contiguous memory and vectorise
+  struct ShellCoords {
+
+    ShellCoords(const Eigen::MatrixX3d& grid_pos, const tools::vec& shellpos) {
+      x = grid_pos.col(0).array() - shellpos.getX();
+      y = grid_pos.col(1).array() - shellpos.getY();
+      z = grid_pos.col(2).array() - shellpos.getZ();
+      xx = x*x;
+      yy = y*y;
+      zz = z*z;
+      xy = x*y;
+      xz = x*z;
+      yz = y*z;
+      distsq = xx + yy + zz;
+    }
+
+    Eigen::ArrayXd::ConstantReturnType Const(double value) const {
+      return Eigen::ArrayXd::Constant(x.size(), value);
+    }
+
+    Eigen::ArrayXd x, y, z;
+    Eigen::ArrayXd xx, yy, zz, xy, xz, yz;
+    Eigen::ArrayXd distsq;
+  };
+
+  /*
+   * The kernels hand every function as polynomial P and its derivatives dP/dx,
+   * dP/dy, dP/dz to an accumulator, which multiplies with the radial part.
+   * The derivatives are expression templates, so they cost nothing if only
+   * values are requested.
+   */
+  class AOValueAccumulator {
+  public:
+
+    AOValueAccumulator(Eigen::Block<Eigen::MatrixXd>& AOvalues, const ShellCoords& coords)
+    : _AOvalues(AOvalues), _coords(coords) {
+    }
+
+    void setPrimitive(double powfactor, double alpha) {
+      _expo = powfactor * (-alpha * _coords.distsq).exp();
+    }
+
+    template <class P, class DX, class DY, class DZ>
+    void Add(int col, const P& poly, const DX&, const DY&, const DZ&) {
+      _AOvalues.col(col).array() += poly*_expo;
+    }
+
+  private:
+    Eigen::Block<Eigen::MatrixXd>& _AOvalues;
+    const ShellCoords& _coords;
+    Eigen::ArrayXd _expo;
+  };
+
+  class AOGradientAccumulator {
+  public:
+
+    AOGradientAccumulator(Eigen::Block<Eigen::MatrixXd>& AOvalues, Eigen::Block<Eigen::MatrixXd>& AODer_x,
+            Eigen::Block<Eigen::MatrixXd>& AODer_y, Eigen::Block<Eigen::MatrixXd>& AODer_z, const ShellCoords& coords)
+    : _AOvalues(AOvalues), _AODer_x(AODer_x), _AODer_y(AODer_y), _AODer_z(AODer_z), _coords(coords) {
+    }
+
+    void setPrimitive(double powfactor, double alpha) {
+      _twoalpha = 2.0 * alpha;
+      _expo = powfactor * (-alpha * _coords.distsq).exp();
+    }
+
+    template <class P, class DX, class DY, class DZ>
+    void Add(int col, const P& poly, const DX& dpoly_x, const DY& dpoly_y, const DZ& dpoly_z) {
+      _value = poly*_expo;
+      _AOvalues.col(col).array() += _value;
+      _AODer_x.col(col).array() += dpoly_x * _expo - _twoalpha * _coords.x*_value;
+      _AODer_y.col(col).array() += dpoly_y * _expo - _twoalpha * _coords.y*_value;
+      _AODer_z.col(col).array() += dpoly_z * _expo - _twoalpha * _coords.z*_value;
+    }
+
+  private:
+    Eigen::Block<Eigen::MatrixXd>& _AOvalues;
+    Eigen::Block<Eigen::MatrixXd>& _AODer_x;
+    Eigen::Block<Eigen::MatrixXd>& _AODer_y;
+    Eigen::Block<Eigen::MatrixXd>& _AODer_z;
+    const ShellCoords& _coords;
+    double _twoalpha;
+    Eigen::ArrayXd _expo;
+    Eigen::ArrayXd _value;
+  };
+
+  // real spherical harmonics of a single subshell with angular momentum L,
+  // same order and normalisation as the pointwise EvalAOspace
+  template <int L> struct AOKernel;
+
+  template <> struct AOKernel<0> {
+
+    template <class Accumulator>
+    static void Eval(Accumulator& acc, int i_func, const ShellCoords& c, double, const std::vector<double>& contractions) {
+      const double factor = contractions[0];
+      acc.Add(i_func, c.Const(factor), c.Const(0.0), c.Const(0.0), c.Const(0.0));
+    }
+  };
+
+  template <> struct AOKernel<1> {
+
+    template <class Accumulator>
+    static void Eval(Accumulator& acc, int i_func, const ShellCoords& c, double alpha, const std::vector<double>& contractions) {
+      const double factor = 2. * std::sqrt(alpha) * contractions[1];
+      acc.Add(i_func, factor * c.z, c.Const(0.0), c.Const(0.0), c.Const(factor)); // Y 1,0
+      acc.Add(i_func + 1, factor * c.y, c.Const(0.0), c.Const(factor), c.Const(0.0)); // Y 1,-1
+      acc.Add(i_func + 2, factor * c.x, c.Const(factor), c.Const(0.0), c.Const(0.0)); // Y 1,1
+    }
+  };
+
+  template <> struct AOKernel<2> {
+
+    template <class Accumulator>
+    static void Eval(Accumulator& acc, int i_func, const ShellCoords& c, double alpha, const std::vector<double>& contractions) {
+      const double factor = 2. * alpha * contractions[2];
+      const double factor_1 = factor / std::sqrt(3.);
+      acc.Add(i_func, factor_1 * (3. * c.zz - c.distsq),
+              -2. * factor_1 * c.x, -2. * factor_1 * c.y, 4. * factor_1 * c.z); // Y 2,0
+      acc.Add(i_func + 1, 2. * factor * c.yz,
+              c.Const(0.0), 2. * factor * c.z, 2. * factor * c.y); // Y 2,-1
+      acc.Add(i_func + 2, 2. * factor * c.xz,
+              2. * factor * c.z, c.Const(0.0), 2. * factor * c.x); // Y 2,1
+      acc.Add(i_func + 3, 2. * factor * c.xy,
+              2. * factor * c.y, 2. * factor * c.x, c.Const(0.0)); // Y 2,-2
+      acc.Add(i_func + 4, factor * (c.xx - c.yy),
+              2. * factor * c.x, -2. * factor * c.y, c.Const(0.0)); // Y 2,2
+    }
+  };
+
+  template <> struct AOKernel<3> {
+
+    template <class Accumulator>
+    static void Eval(Accumulator& acc, int i_func, const ShellCoords& c, double alpha, const std::vector<double>& contractions) {
+      const double factor = 2. * std::pow(alpha, 1.5) * contractions[3];
+      const double factor_1 = factor * 2. / std::sqrt(15.);
+      const double factor_2 = factor * std::sqrt(2.) / std::sqrt(5.);
+      const double factor_3 = factor * std::sqrt(2.) / std::sqrt(3.);
+      acc.Add(i_func, factor_1 * c.z * (5. * c.zz - 3. * c.distsq),
+              -6. * factor_1 * c.xz, -6. * factor_1 * c.yz,
+              3. * factor_1 * (3. * c.zz - c.distsq)); // Y 3,0
+      acc.Add(i_func + 1, factor_2 * c.y * (5. * c.zz - c.distsq),
+              -2. * factor_2 * c.xy, factor_2 * (4. * c.zz - c.xx - 3. * c.yy),
+              8. * factor_2 * c.yz); // Y 3,-1
+      acc.Add(i_func + 2, factor_2 * c.x * (5. * c.zz - c.distsq),
+              factor_2 * (4. * c.zz - c.yy - 3. * c.xx), -2. * factor_2 * c.xy,
+              8. * factor_2 * c.xz); // Y 3,1
+      acc.Add(i_func + 3, 4. * factor * c.xy * c.z,
+              4. * factor * c.yz, 4. * factor * c.xz, 4. * factor * c.xy); // Y 3,-2
+      acc.Add(i_func + 4, 2. * factor * c.z * (c.xx - c.yy),
+              4. * factor * c.xz, -4. * factor * c.yz, 2. * factor * (c.xx - c.yy)); // Y 3,2
+      acc.Add(i_func + 5, factor_3 * c.y * (3. * c.xx - c.yy),
+              6. * factor_3 * c.xy, 3. * factor_3 * (c.xx - c.yy), c.Const(0.0)); // Y 3,-3
+      acc.Add(i_func + 6, factor_3 * c.x * (c.xx - 3. * c.yy),
+              3. * factor_3 * (c.xx - c.yy), -6. * factor_3 * c.xy, c.Const(0.0)); // Y 3,3
+    }
+  };
+
+  template <> struct AOKernel<4> {
+
+    template <class Accumulator>
+    static void Eval(Accumulator& acc, int i_func, const ShellCoords& c, double alpha, const std::vector<double>& contractions) {
+      const double factor = 2. / std::sqrt(3.) * alpha * alpha * contractions[4];
+      const double factor_1 = factor / std::sqrt(35.);
+      const double factor_2 = factor * 4. / std::sqrt(14.);
+      const double factor_3 = factor * 2. / std::sqrt(7.);
+      const double factor_4 = factor * 2. * std::sqrt(2.);
+      acc.Add(i_func, factor_1 * (35. * c.zz * c.zz - 30. * c.zz * c.distsq + 3. * c.distsq * c.distsq),
+              12. * factor_1 * c.x * (c.distsq - 5. * c.zz),
+              12. * factor_1 * c.y * (c.distsq - 5. * c.zz),
+              16. * factor_1 * c.z * (5. * c.zz - 3. * c.distsq)); // Y 4,0
+      acc.Add(i_func + 1, factor_2 * c.yz * (7. * c.zz - 3. * c.distsq),
+              -6. * factor_2 * c.x * c.yz,
+              factor_2 * c.z * (4. * c.zz - 3. * c.xx - 9. * c.yy),
+              3. * factor_2 * c.y * (5. * c.zz - c.distsq)); // Y 4,-1
+      acc.Add(i_func + 2, factor_2 * c.xz * (7. * c.zz - 3. * c.distsq),
+              factor_2 * c.z * (4. * c.zz - 9. * c.xx - 3. * c.yy),
+              -6. * factor_2 * c.y * c.xz,
+              3. * factor_2 * c.x * (5. * c.zz - c.distsq)); // Y 4,1
+      acc.Add(i_func + 3, 2. * factor_3 * c.xy * (7. * c.zz - c.distsq),
+              2. * factor_3 * c.y * (6. * c.zz - 3. * c.xx - c.yy),
+              2. * factor_3 * c.x * (6. * c.zz - c.xx - 3. * c.yy),
+              24. * factor_3 * c.z * c.xy); // Y 4,-2
+      acc.Add(i_func + 4, factor_3 * (c.xx - c.yy) * (7. * c.zz - c.distsq),
+              4. * factor_3 * c.x * (3. * c.zz - c.xx),
+              4. * factor_3 * c.y * (c.yy - 3. * c.zz),
+              12. * factor_3 * c.z * (c.xx - c.yy)); // Y 4,2
+      acc.Add(i_func + 5, factor_4 * c.yz * (3. * c.xx - c.yy),
+              6. * factor_4 * c.x * c.yz,
+              3. * factor_4 * c.z * (c.xx - c.yy),
+              factor_4 * c.y * (3. * c.xx - c.yy)); // Y 4,-3
+      acc.Add(i_func + 6, factor_4 * c.xz * (c.xx - 3. * c.yy),
+              3. * factor_4 * c.z * (c.xx - c.yy),
+              -6. * factor_4 * c.y * c.xz,
+              factor_4 * c.x * (c.xx - 3. * c.yy)); // Y 4,3
+      acc.Add(i_func + 7, 4. * factor * c.xy * (c.xx - c.yy),
+              4. * factor * c.y * (3. * c.xx - c.yy),
+              4. * factor * c.x * (c.xx - 3. * c.yy), c.Const(0.0)); // Y 4,-4
+      acc.Add(i_func + 8, factor * (c.xx * c.xx - 6. * c.xx * c.yy + c.yy * c.yy),
+              4. * factor * c.x * (c.xx - 3. * c.yy),
+              4. * factor * c.y * (c.yy - 3. * c.xx), c.Const(0.0)); // Y 4,4
+    }
+  };
+
+  // the subshell type is resolved once per primitive, not per grid point
+  template <class Accumulator>
+  void EvalShellBatch(Accumulator& acc, const std::string& type, const std::vector<AOGaussianPrimitive>& gaussians,
+          const ShellCoords& coords) {
+    for (const AOGaussianPrimitive& gaussian : gaussians) {
+      const double alpha = gaussian.getDecay();
+      const std::vector<double>& contractions = gaussian.getContraction();
+      acc.setPrimitive(gaussian.getPowfactor(), alpha);
+      int i_func = 0;
+      for (const char& single_shell : type) {
+        switch (single_shell) {
+          case 'S':
+            AOKernel<0>::Eval(acc, i_func, coords, alpha, contractions);
+            i_func += 1;
+            break;
+          case 'P':
+            AOKernel<1>::Eval(acc, i_func, coords, alpha, contractions);
+            i_func += 3;
+            break;
+          case 'D':
+            AOKernel<2>::Eval(acc, i_func, coords, alpha, contractions);
+            i_func += 5;
+            break;
+          case 'F':
+            AOKernel<3>::Eval(acc, i_func, coords, alpha, contractions);
+            i_func += 7;
+            break;
+          case 'G':
+            AOKernel<4>::Eval(acc, i_func, coords, alpha, contractions);
+            i_func += 9;
+            break;
+          default:
+            std::cerr << "Single shell type" << single_shell << " not known " << std::endl;
+            exit(1);
+        }
+      }
+    }
+    return;
+  }
+
+}
+
+  void AOShell::CalcTrafos(){
+    for (auto& gaussian:_gaussians){
+      gaussian._trafo=AOSuperMatrix::CalcTrafo(gaussian);
+    }
+    return;
+  }
+
   void AOShell::normalizeContraction(){   
+    CalcTrafos();
     AOOverlap overlap;
     Eigen::MatrixXd block=overlap.FillShell(this);
     std::vector<int> numsubshells=NumFuncSubShell(_type);
@@ -36,6 +292,7 @@ namespace votca { namespace xtp {
       aoindex+=numsubshell;
       contraction_index++;
     }
+    CalcTrafos();
     return;
   }
   
@@ -392,6 +649,22 @@ void AOShell::EvalAOspace(Eigen::VectorBlock<Eigen::VectorXd>& AOvalues, const t
             return;
         }
 
+void AOShell::EvalAOspace(Eigen::Block<Eigen::MatrixXd>& AOvalues, const Eigen::MatrixX3d& grid_pos) const {
+  const ShellCoords coords(grid_pos, _pos);
+  AOValueAccumulator acc(AOvalues, coords);
+  EvalShellBatch(acc, _type, _gaussians, coords);
+  return;
+}
+
+void AOShell::EvalAOspace(Eigen::Block<Eigen::MatrixXd>& AOvalues, Eigen::Block<Eigen::MatrixXd>& AODer_x,
+        Eigen::Block<Eigen::MatrixXd>& AODer_y, Eigen::Block<Eigen::MatrixXd>& AODer_z,
+        const Eigen::MatrixX3d& grid_pos) const {
+  const ShellCoords coords(grid_pos, _pos);
+  AOGradientAccumulator acc(AOvalues, AODer_x, AODer_y, AODer_z, coords);
+  EvalShellBatch(acc, _type, _gaussians, coords);
+  return;
+}
+
 std::ostream &operator<<(std::ostream &out, const AOShell& shell) {
     out <<"AtomIndex:"<<shell.getAtomIndex() <<" Atomtype:"<<shell.getAtomType();
     out <<" Shelltype:"<<shell.getType() <<" Scale:"<<shell.getScale()
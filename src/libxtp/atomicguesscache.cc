@@ -0,0 +1,115 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <votca/xtp/atomicguesscache.h>
+#include <boost/filesystem.hpp>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+
+namespace votca {
+  namespace xtp {
+
+    namespace {
+      const std::string header = "# votca-xtp atomic guess";
+    }
+
+    std::string AtomicGuessCache::Key(const std::string& element, const std::string& basis,
+            const std::string& ecp, const std::string& functional, const std::string& grid) {
+      return element + "|" + basis + "|" + ecp + "|" + functional + "|" + grid;
+    }
+
+    std::string AtomicGuessCache::Filename(const std::string& key) const {
+      std::string name = key;
+      for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char> (c)) && c != '-' && c != '+' && c != '.') {
+          c = '_';
+        }
+      }
+      return (boost::filesystem::path(_directory) / (name + ".dmat")).string();
+    }
+
+    bool AtomicGuessCache::Load(const std::string& key, Eigen::MatrixXd& dmat) const {
+      std::ifstream file(Filename(key).c_str());
+      if (!file.is_open()) {
+        return false;
+      }
+      std::string line;
+      std::getline(file, line);
+      if (line != header) {
+        return false;
+      }
+      std::getline(file, line);
+      if (line != key) {
+        return false;
+      }
+      int rows = 0;
+      int cols = 0;
+      file >> rows >> cols;
+      if (!file || rows < 1 || cols < 1) {
+        return false;
+      }
+      Eigen::MatrixXd result(rows, cols);
+      for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+          file >> result(i, j);
+        }
+      }
+      if (!file) {
+        return false;
+      }
+      dmat = result;
+      return true;
+    }
+
+    bool AtomicGuessCache::Store(const std::string& key, const Eigen::MatrixXd& dmat) const {
+      namespace fs = boost::filesystem;
+      const fs::path filename(Filename(key));
+      boost::system::error_code error;
+      fs::create_directories(filename.parent_path(), error);
+      const fs::path tempname = filename.parent_path()
+              / fs::unique_path(filename.filename().string() + ".%%%%-%%%%-%%%%.tmp");
+      {
+        std::ofstream file(tempname.string().c_str());
+        if (!file.is_open()) {
+          return false;
+        }
+        file << header << "\n" << key << "\n" << dmat.rows() << " " << dmat.cols() << "\n";
+        file << std::scientific << std::setprecision(17);
+        for (int i = 0; i < dmat.rows(); i++) {
+          for (int j = 0; j < dmat.cols(); j++) {
+            file << dmat(i, j) << ((j + 1 < dmat.cols()) ? " " : "\n");
+          }
+        }
+        if (!file) {
+          file.close();
+          fs::remove(tempname, error);
+          return false;
+        }
+      }
+      fs::rename(tempname, filename, error);
+      if (error) {
+        fs::remove(tempname, error);
+        return false;
+      }
+      return true;
+    }
+
+  }
+}
@@ -0,0 +1,167 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <votca/xtp/boysfunction.h>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace votca {
+  namespace xtp {
+
+    namespace {
+      const double step = 0.1;
+      const double inv_step = 10.0;
+      // table ends at (_tablepoints-1)*step
+      const double umax = 36.0;
+    }
+
+    const BoysFunction& BoysFunction::Instance() {
+      static const BoysFunction boys;
+      return boys;
+    }
+
+    /*
+     * The highest order of the table is summed from the series
+     * F_m(U) = exp(-U) sum_i (2U)^i/((2m+1)(2m+3)...(2m+2i+1)),
+     * which has only positive terms, the lower orders are filled by the
+     * downward recursion.
+     */
+    BoysFunction::BoysFunction() {
+      const int orders = MaxOrder + _taylor;
+      _table = Eigen::MatrixXd::Zero(orders, _tablepoints);
+      for (int point = 0; point < _tablepoints; point++) {
+        const double U = point * step;
+        const double expU = std::exp(-U);
+        const int top = orders - 1;
+        double term = 1.0 / (2.0 * top + 1.0);
+        double sum = term;
+        for (int i = 1; term > 1e-17 * sum; i++) {
+          term *= 2.0 * U / (2.0 * top + 2.0 * i + 1.0);
+          sum += term;
+        }
+        _table(top, point) = expU * sum;
+        for (int m = top - 1; m >= 0; m--) {
+          _table(m, point) = (2.0 * U * _table(m + 1, point) + expU) / (2.0 * m + 1.0);
+        }
+      }
+      double factorial = 1.0;
+      for (int k = 0; k < _taylor; k++) {
+        if (k > 0) {
+          factorial *= k;
+        }
+        _inv_factorial[k] = 1.0 / factorial;
+      }
+      for (int m = 0; m <= MaxOrder; m++) {
+        _inv_odd[m] = 1.0 / (2.0 * m + 1.0);
+      }
+    }
+
+    void BoysFunction::Calculate(double* FmU, int mmax, double U) const {
+      if (mmax < 0 || mmax > MaxOrder) {
+        throw std::runtime_error("BoysFunction: order " + std::to_string(mmax) + " is not supported");
+      }
+      const double expU = std::exp(-U);
+      if (U < umax) {
+        const int point = int(U * inv_step + 0.5);
+        const double x = point * step - U;
+        const double* column = _table.data() + point * _table.rows();
+        double f = column[mmax + _taylor - 1] * _inv_factorial[_taylor - 1];
+        for (int k = _taylor - 2; k >= 0; k--) {
+          f = f * x + column[mmax + k] * _inv_factorial[k];
+        }
+        FmU[mmax] = f;
+        const double twoU = 2.0 * U;
+        for (int m = mmax - 1; m >= 0; m--) {
+          FmU[m] = (twoU * FmU[m + 1] + expU) * _inv_odd[m];
+        }
+      } else {
+        const double pi = boost::math::constants::pi<double>();
+        // erf(sqrt(U)) is 1 to machine precision
+        FmU[0] = 0.5 * std::sqrt(pi / U);
+        const double inv_twoU = 0.5 / U;
+        for (int m = 1; m <= mmax; m++) {
+          FmU[m] = ((2.0 * m - 1.0) * FmU[m - 1] - expU) * inv_twoU;
+        }
+      }
+      return;
+    }
+
+    /*
+     * The Taylor sum and the recursion work on whole columns of chunks of
+     * points that stay in the L1 cache, so Eigen vectorises them over the
+     * points. Only the lookup of the table coefficients is a gather.
+     */
+    void BoysFunction::Evaluate(Eigen::MatrixXd& FmU, int mmax, const Eigen::VectorXd& U) {
+      const BoysFunction& boys = Instance();
+      if (mmax < 0 || mmax > MaxOrder) {
+        throw std::runtime_error("BoysFunction: order " + std::to_string(mmax) + " is not supported");
+      }
+      const int npoints = U.size();
+      FmU.resize(npoints, mmax + 1);
+      const int chunksize = 64;
+      Eigen::ArrayXi point(chunksize);
+      Eigen::ArrayXd x(chunksize);
+      Eigen::ArrayXd f(chunksize);
+      Eigen::ArrayXd coefficient(chunksize);
+      Eigen::ArrayXd expU(chunksize);
+      std::vector<int> large;
+      for (int start = 0; start < npoints; start += chunksize) {
+        const int size = std::min(chunksize, npoints - start);
+        const Eigen::ArrayXd chunk = U.segment(start, size).array();
+        for (int i = 0; i < size; i++) {
+          if (chunk(i) < umax) {
+            point(i) = int(chunk(i) * inv_step + 0.5);
+          } else {
+            point(i) = 0;
+            large.push_back(start + i);
+          }
+        }
+        x.head(size) = point.head(size).cast<double>() * step - chunk;
+        f.head(size).setZero();
+        for (int k = _taylor - 1; k >= 0; k--) {
+          const double* row = boys._table.data() + mmax + k;
+          for (int i = 0; i < size; i++) {
+            coefficient(i) = row[point(i) * boys._table.rows()];
+          }
+          f.head(size) = f.head(size) * x.head(size) + coefficient.head(size) * boys._inv_factorial[k];
+        }
+        FmU.col(mmax).segment(start, size) = f.head(size).matrix();
+        expU.head(size) = (-chunk).exp();
+        for (int m = mmax - 1; m >= 0; m--) {
+          FmU.col(m).segment(start, size) = ((2.0 * chunk * FmU.col(m + 1).segment(start, size).array()
+                  + expU.head(size)) * boys._inv_odd[m]).matrix();
+        }
+      }
+
+      Values values;
+      for (int i : large) {
+        boys.Calculate(values.data(), mmax, U(i));
+        for (int m = 0; m <= mmax; m++) {
+          FmU(i, m) = values[m];
+        }
+      }
+      return;
+    }
+
+  }
+}
@@ -163,6 +163,12 @@ double BSECoupling::getTripletCouplingElement( int levelA, int levelB, int metho
  * @param _orbitalsAB molecular orbitals of the dimer AB
  */
 void BSECoupling::CalculateCouplings(const Orbitals& orbitalsA, const Orbitals& orbitalsB, Orbitals& orbitalsAB) {
+    CalculateCouplings(orbitalsA, orbitalsB, orbitalsAB, NULL, NULL);
+    return;
+}
+
+void BSECoupling::CalculateCouplings(const Orbitals& orbitalsA, const Orbitals& orbitalsB, Orbitals& orbitalsAB,
+                                     const BSEOperator* Hs, const BSEOperator* Ht) {
        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()  << "  Calculating exciton couplings" << flush;
     #ifdef _OPENMP
     
@@ -292,19 +298,27 @@ void BSECoupling::CalculateCouplings(const Orbitals& orbitalsA, const Orbitals&
     int _bseAB_ctotal = _bseAB_cmax - _bseAB_cmin +1 ;
     int _bseAB_size   = _bseAB_vtotal * _bseAB_ctotal;
     // check if electron-hole interaction matrices are stored
-    if ( ! orbitalsAB.hasEHinteraction_triplet() && _doTriplets){
+    if ( Ht==NULL && ! orbitalsAB.hasEHinteraction_triplet() && _doTriplets){
        throw std::runtime_error( "BSE EH for triplets not stored " );
     }
-    if ( ! orbitalsAB.hasEHinteraction_singlet() && _doSinglets){
+    if ( Hs==NULL && ! orbitalsAB.hasEHinteraction_singlet() && _doSinglets){
        throw std::runtime_error( "BSE EH for singlets not stored " );
     }
     const MatrixXfd&    eh_t = orbitalsAB.eh_t(); 
     const MatrixXfd&    eh_s = orbitalsAB.eh_s(); 
     if(_doTriplets){
+        if(Ht!=NULL){
+    CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()   << "   dimer AB has matrix-free BSE triplet Hamiltonian with dimension " << Ht->rows() << flush;
+        }else{
     CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()   << "   dimer AB has BSE EH interaction triplet with dimension " << eh_t.rows() << " x " <<  eh_t.cols() << flush;
+        }
     }
     if(_doSinglets){
+        if(Hs!=NULL){
+    CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()   << "   dimer AB has matrix-free BSE singlet Hamiltonian with dimension " << Hs->rows() << flush;
+        }else{
     CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()   << "   dimer AB has BSE EH interaction singlet with dimension " << eh_s.rows() << " x " <<  eh_s.cols() << flush;
+        }
     }
     // now, two storage assignment matrices for two-particle functions
     Eigen::MatrixXi combAB;
@@ -449,12 +463,15 @@ void BSECoupling::CalculateCouplings(const Orbitals& orbitalsA, const Orbitals&
     // now the different spin types
             if (_doSinglets) {
                 CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "   Evaluating singlets" << flush;
-                Eigen::MatrixXd Hamiltonian_AB = eh_s.cast<double>();
-                CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "   Setup Hamiltonian" << flush;
                 const Eigen::MatrixXd bseA_T = orbitalsA.BSESingletCoefficients().block(0,0,orbitalsA.BSESingletCoefficients().rows(),_levA).transpose().cast<double>();
                 const Eigen::MatrixXd bseB_T =orbitalsB.BSESingletCoefficients().block(0,0,orbitalsB.BSESingletCoefficients().rows(),_levB).transpose().cast<double>();
-                
-                JAB_singlet = ProjectExcitons(bseA_T, bseB_T, Hamiltonian_AB);
+                if (Hs != NULL) {
+                    JAB_singlet = ProjectExcitons(bseA_T, bseB_T, *Hs);
+                } else {
+                    Eigen::MatrixXd Hamiltonian_AB = eh_s.cast<double>();
+                    CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "   Setup Hamiltonian" << flush;
+                    JAB_singlet = ProjectExcitons(bseA_T, bseB_T, Hamiltonian_AB);
+                }
                 CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "   calculated singlet couplings " << flush;
             }
 
@@ -462,11 +479,15 @@ void BSECoupling::CalculateCouplings(const Orbitals& orbitalsA, const Orbitals&
 
             if (_doTriplets) {
                 CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "   Evaluating triplets" << flush;
-                Eigen::MatrixXd Hamiltonian_AB = eh_s.cast<double>();
-                CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "  Converted Hamiltonian to double" << flush;         
                 const Eigen::MatrixXd bseA_T = orbitalsA.BSETripletCoefficients().block(0,0,orbitalsA.BSETripletCoefficients().rows(),_levA).transpose().cast<double>();
                 const Eigen::MatrixXd bseB_T =orbitalsB.BSETripletCoefficients().block(0,0,orbitalsB.BSETripletCoefficients().rows(),_levB).transpose().cast<double>();
-                JAB_triplet = ProjectExcitons(bseA_T, bseB_T, Hamiltonian_AB);
+                if (Ht != NULL) {
+                    JAB_triplet = ProjectExcitons(bseA_T, bseB_T, *Ht);
+                } else {
+                    Eigen::MatrixXd Hamiltonian_AB = eh_t.cast<double>();
+                    CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "  Converted Hamiltonian to double" << flush;
+                    JAB_triplet = ProjectExcitons(bseA_T, bseB_T, Hamiltonian_AB);
+                }
                 CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << "   calculated triplet couplings " << flush;
             }
     
@@ -475,8 +496,9 @@ void BSECoupling::CalculateCouplings(const Orbitals& orbitalsA, const Orbitals&
 };
 
 
+template<class BSE_Hamiltonian>
 std::vector< Eigen::MatrixXd > BSECoupling::ProjectExcitons(const Eigen::MatrixXd& bseA_T, const Eigen::MatrixXd& bseB_T, 
-                                  Eigen::MatrixXd& H){
+                                  const BSE_Hamiltonian& H){
    
      // get projection of monomer excitons on dimer product functions
      Eigen::MatrixXd _proj_excA = bseA_T* _kap;
@@ -536,8 +558,8 @@ std::vector< Eigen::MatrixXd > BSECoupling::ProjectExcitons(const Eigen::MatrixX
      
      // this only works for hermitian/symmetric H so only in TDA
     
-     Eigen::MatrixXd J_dimer=projection*H*projection.transpose();
-     H.resize(0,0);
+     // H is only applied to the few projected states, it is never needed as a whole
+     Eigen::MatrixXd J_dimer=projection*ApplyHamiltonian(H,projection.transpose());
     
     CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()  << "   Setting up overlap matrix size "<< _bse_exc +_ct<<"x"<<_bse_exc +_ct << flush;    
     Eigen::MatrixXd S_dimer=projection*projection.transpose();
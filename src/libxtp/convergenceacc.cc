@@ -33,6 +33,23 @@ namespace votca { namespace xtp {
        return;
    }
    
+   void ConvergenceAcc::Reset(){
+     for (Eigen::MatrixXd* mat:_mathist){
+       delete mat;
+     }
+     _mathist.clear();
+     for (Eigen::MatrixXd* dmat:_dmatHist){
+       delete dmat;
+     }
+     _dmatHist.clear();
+     _totE.clear();
+     _diis.Reset();
+     _usemixing=true;
+     _diiserror=std::numeric_limits<double>::max();
+     _maxerrorindex=0;
+     _maxerror=0.0;
+     return;
+   }
    
     Eigen::MatrixXd ConvergenceAcc::Iterate(const Eigen::MatrixXd& dmat,Eigen::MatrixXd& H,Eigen::VectorXd &MOenergies,Eigen::MatrixXd &MOs,double totE){
       Eigen::MatrixXd H_guess=Eigen::MatrixXd::Zero(H.rows(),H.cols());    
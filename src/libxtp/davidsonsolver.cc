@@ -0,0 +1,128 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <votca/xtp/davidsonsolver.h>
+#include <numeric>
+#include <vector>
+#include <algorithm>
+
+namespace votca {
+  namespace xtp {
+
+    Eigen::MatrixXd DavidsonSolver::SetupInitialEigenvectors(const Eigen::VectorXd& Adiag, int size) const {
+      // unit vectors on the smallest diagonal elements
+      std::vector<int> index(Adiag.size());
+      std::iota(index.begin(), index.end(), 0);
+      std::stable_sort(index.begin(), index.end(),
+              [&Adiag](int i, int j) {return Adiag(i) < Adiag(j);});
+      Eigen::MatrixXd guess = Eigen::MatrixXd::Zero(Adiag.size(), size);
+      for (int i = 0; i < size; ++i) {
+        guess(index[i], i) = 1.0;
+      }
+      return guess;
+    }
+
+    DavidsonSolver::RitzPairs DavidsonSolver::SolveProjectedProblem(const Eigen::MatrixXd& V, const Eigen::MatrixXd& AV) const {
+      RitzPairs ritz;
+      Eigen::MatrixXd T = V.transpose() * AV;
+      if (_matrix_type == SYMMETRIC) {
+        Eigen::MatrixXd Tsym = 0.5 * (T + T.transpose());
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(Tsym);
+        ritz.lambda = es.eigenvalues();
+        ritz.y = es.eigenvectors();
+      } else {
+        // spectrum is real for the operators we use, imaginary parts are numerical noise
+        Eigen::EigenSolver<Eigen::MatrixXd> es(T);
+        Eigen::VectorXd lambda = es.eigenvalues().real();
+        Eigen::MatrixXd y = es.eigenvectors().real();
+        std::vector<int> index(lambda.size());
+        std::iota(index.begin(), index.end(), 0);
+        std::sort(index.begin(), index.end(),
+                [&lambda](int i, int j) {return lambda(i) < lambda(j);});
+        ritz.lambda.resize(lambda.size());
+        ritz.y.resize(y.rows(), y.cols());
+        for (unsigned i = 0; i < index.size(); ++i) {
+          ritz.lambda(i) = lambda(index[i]);
+          ritz.y.col(i) = y.col(index[i]).normalized();
+        }
+      }
+      return ritz;
+    }
+
+    Eigen::MatrixXd DavidsonSolver::CorrectionVectors(const Eigen::MatrixXd& residual, const Eigen::VectorXd& Adiag) const {
+      // diagonal preconditioned residue, only for unconverged roots
+      const double eps = 1e-8;
+      Eigen::MatrixXd correction = Eigen::MatrixXd::Zero(residual.rows(), residual.cols());
+      int count = 0;
+      for (int i = 0; i < residual.cols(); ++i) {
+        if (_residues(i) < _tolerance) {
+          continue;
+        }
+        Eigen::ArrayXd denom = _eigenvalues(i) - Adiag.array();
+        for (int j = 0; j < denom.size(); ++j) {
+          if (std::abs(denom(j)) < eps) {
+            denom(j) = (denom(j) < 0) ? -eps : eps;
+          }
+        }
+        correction.col(count) = (residual.col(i).array() / denom).matrix();
+        count++;
+      }
+      correction.conservativeResize(Eigen::NoChange, count);
+      return correction;
+    }
+
+    Eigen::MatrixXd DavidsonSolver::OrthogonalizeAgainst(const Eigen::MatrixXd& V, const Eigen::MatrixXd& vectors) const {
+      // Gram-Schmidt done twice, which is sufficient in floating point
+      const double threshold = 1e-6;
+      Eigen::MatrixXd result = Eigen::MatrixXd::Zero(vectors.rows(), vectors.cols());
+      int count = 0;
+      for (int i = 0; i < vectors.cols(); ++i) {
+        Eigen::VectorXd v = vectors.col(i);
+        double norm0 = v.norm();
+        if (norm0 < 1e-14) {
+          continue;
+        }
+        v /= norm0;
+        for (int pass = 0; pass < 2; ++pass) {
+          v -= V * (V.transpose() * v);
+          if (count > 0) {
+            v -= result.leftCols(count) * (result.leftCols(count).transpose() * v);
+          }
+        }
+        double norm = v.norm();
+        if (norm > threshold) {
+          result.col(count) = v / norm;
+          count++;
+        }
+      }
+      result.conservativeResize(Eigen::NoChange, count);
+      return result;
+    }
+
+    void DavidsonSolver::Restart(Eigen::MatrixXd& V, Eigen::MatrixXd& AV, const Eigen::MatrixXd& y) const {
+      // orthonormalise the kept Ritz vectors in the subspace, V stays orthonormal
+      Eigen::HouseholderQR<Eigen::MatrixXd> qr(y);
+      Eigen::MatrixXd Q = qr.householderQ() * Eigen::MatrixXd::Identity(y.rows(), y.cols());
+      V = V * Q;
+      AV = AV * Q;
+      return;
+    }
+
+  }
+}
@@ -21,6 +21,7 @@
 #include "votca/xtp/qminterface.h"
 #include "votca/xtp/qmatom.h"
 #include <votca/xtp/dftengine.h>
+#include <votca/xtp/atomicguesscache.h>
 
 #include <boost/format.hpp>
 #include <boost/filesystem.hpp>
@@ -59,11 +60,14 @@ namespace votca {
       }
 
       if (!_with_RI) {
-        std::vector<std::string> choices = {"direct", "cache"};
+        std::vector<std::string> choices = {"direct", "cache", "disk"};
         _four_center_method = options.ifExistsAndinListReturnElseThrowRuntimeError<std::string>(key + ".four_center_method", choices);
 
         _with_screening = options.ifExistsReturnElseReturnDefault<bool>(key + ".with_screening", true);
         _screening_eps = options.ifExistsReturnElseReturnDefault<double>(key + ".screening_eps", 1e-9);
+        _incremental_fock = options.ifExistsReturnElseReturnDefault<bool>(key + ".incremental_fock", _with_screening);
+        _fock_rebuild = options.ifExistsReturnElseReturnDefault<int>(key + ".fock_rebuild", 10);
+        _four_center_scratch = options.ifExistsReturnElseReturnDefault<std::string>(key + ".four_center_scratch", ".");
       }
 
       if (options.exists(key + ".ecp")) {
@@ -74,6 +78,7 @@ namespace votca {
       }
       _with_guess = options.ifExistsReturnElseReturnDefault<bool>(key + ".read_guess", false);
       _initial_guess = options.ifExistsReturnElseReturnDefault<string>(key + ".initial_guess", "atom");
+      _atomic_guess_cache = options.ifExistsReturnElseReturnDefault<string>(key + ".atomic_guess_cache", "");
 
       _grid_name = options.ifExistsReturnElseReturnDefault<string>(key + ".integration_grid", "medium");
       _use_small_grid = options.ifExistsReturnElseReturnDefault<bool>(key + ".integration_grid_small", true);
@@ -223,7 +228,7 @@ void DFTEngine::CalcElDipole(Orbitals& orbitals)const{
 
         } else if (_initial_guess == "atom") {
           _dftAOdmat = AtomicGuess(orbitals);
-          CalculateERIs(_dftbasis, _dftAOdmat);
+          CalculateERIs(_ERIs, _dftbasis, _dftAOdmat);
 
           if (_use_small_grid) {
             orbitals.AOVxc() = _gridIntegration_small.IntegrateVXC(_dftAOdmat);
@@ -234,11 +239,7 @@ void DFTEngine::CalcElDipole(Orbitals& orbitals)const{
           }
           Eigen::MatrixXd H = H0 + _ERIs.getERIs() + orbitals.AOVxc();
           if(_ScaHFX>0){
-              if (_with_RI) {
-             _ERIs.CalculateEXX(_dftAOdmat);
-           } else {
-             _ERIs.CalculateEXX_4c_small_molecule(_dftAOdmat);
-           }
+            CalculateEXX(_ERIs, _dftAOdmat);
             H-=0.5*_ScaHFX*_ERIs.getEXX();
           }      
           _conv_accelerator.SolveFockmatrix(MOEnergies, MOCoeff, H);
@@ -275,7 +276,7 @@ void DFTEngine::CalcElDipole(Orbitals& orbitals)const{
           vxcenergy = _gridIntegration.getTotEcontribution();
           CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Filled DFT Vxc matrix " << flush;
         }
-        CalculateERIs(_dftbasis, _dftAOdmat);
+        CalculateERIs(_ERIs, _dftbasis, _dftAOdmat);
         Eigen::MatrixXd H = H0 + _ERIs.getERIs() + orbitals.AOVxc();
         if(_ScaHFX>0){
               if (_with_RI) {
@@ -368,6 +369,79 @@ void DFTEngine::CalcElDipole(Orbitals& orbitals)const{
       CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() 
               << " Filled DFT nuclear potential matrix."<< flush;
 
+      SetupExternalPotentials();
+
+      if (_with_ecp) {
+        _dftAOECP.setECP(&_ecp);
+        _dftAOECP.Fill(_dftbasis);
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() 
+                << " Filled DFT ECP matrix" << flush;
+      }
+
+      _conv_accelerator.Configure(ConvergenceAcc::KSmode::closed, _usediis,
+              true, _histlength, _maxout, _adiis_start, _diis_start,
+              _levelshift, _levelshiftend, _numofelectrons, _mixingparameter);
+      _conv_accelerator.setLogger(_pLog);
+      _conv_accelerator.setOverlap(&_dftAOoverlap, 1e-8);
+
+      SetupERIs(_ERIs, _dftbasis, _auxbasis);
+      return;
+    }
+
+    /*
+     * Invariant part of the Coulomb and exact exchange integrals for the RI or
+     * four-center method of the options, shared by the SCF and the frozen density
+     * energies of the gradient
+     */
+    void DFTEngine::SetupERIs(ERIs& eris, AOBasis& dftbasis, AOBasis& auxbasis) {
+      if (_with_RI) {
+
+        AOCoulomb auxAOcoulomb;
+        auxAOcoulomb.Fill(auxbasis);
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
+                << " Filled auxiliary Coulomb matrix"<< flush;
+
+        Eigen::MatrixXd Inverse=auxAOcoulomb.Pseudo_InvSqrt(1e-8);
+
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
+                << " Inverted AUX Coulomb matrix, removed " << auxAOcoulomb.Removedfunctions()
+                << " functions from aux basis" << flush;
+
+        // prepare invariant part of electron repulsion integrals
+        eris.Initialize(dftbasis, auxbasis, Inverse);
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
+                << " Setup invariant parts of Electron Repulsion integrals " << flush;
+      } else {
+
+        if (_four_center_method=="cache") {
+
+          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculating 4c integrals. " << flush;
+          eris.Initialize_4c_small_molecule(dftbasis);
+          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculated 4c integrals. " << flush;
+        }
+
+        if (_with_screening && (_four_center_method=="direct" || _four_center_method=="disk")) {
+          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculating 4c diagonals. " << flush;
+          eris.Initialize_4c_screening(dftbasis, _screening_eps);
+          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculated 4c diagonals. " << flush;
+        }
+        if (_four_center_method=="disk") {
+          path scratchfile = path(_four_center_scratch) / unique_path("xtp_4c_%%%%-%%%%-%%%%.scratch");
+          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Writing 4c integrals to "
+                  << scratchfile.string() << flush;
+          eris.Initialize_4c_disk(dftbasis, scratchfile.string());
+          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculated 4c integrals. " << flush;
+        }
+        if (_four_center_method=="direct") {
+          eris.setIncrementalRebuild(_fock_rebuild);
+          eris.ResetIncremental();
+        }
+      }
+
+      return;
+    }
+
+    void DFTEngine::SetupExternalPotentials() {
       if (_addexternalsites) {
         _dftAOESP.Fillextpotential(_dftbasis, _externalsites);
         CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() 
@@ -411,53 +485,6 @@ void DFTEngine::CalcElDipole(Orbitals& orbitals)const{
           }
         }
       }
-
-      if (_with_ecp) {
-        _dftAOECP.setECP(&_ecp);
-        _dftAOECP.Fill(_dftbasis);
-        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() 
-                << " Filled DFT ECP matrix" << flush;
-      }
-
-      _conv_accelerator.Configure(ConvergenceAcc::KSmode::closed, _usediis,
-              true, _histlength, _maxout, _adiis_start, _diis_start,
-              _levelshift, _levelshiftend, _numofelectrons, _mixingparameter);
-      _conv_accelerator.setLogger(_pLog);
-      _conv_accelerator.setOverlap(&_dftAOoverlap, 1e-8);
-
-      if (_with_RI) {
-
-        AOCoulomb auxAOcoulomb;
-        auxAOcoulomb.Fill(_auxbasis);
-        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
-                << " Filled auxiliary Coulomb matrix"<< flush;
-
-        Eigen::MatrixXd Inverse=auxAOcoulomb.Pseudo_InvSqrt(1e-8);
-
-        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
-                << " Inverted AUX Coulomb matrix, removed " << auxAOcoulomb.Removedfunctions()
-                << " functions from aux basis" << flush;
-
-        // prepare invariant part of electron repulsion integrals
-        _ERIs.Initialize(_dftbasis, _auxbasis, Inverse);
-        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
-                << " Setup invariant parts of Electron Repulsion integrals " << flush;
-      } else {
-
-        if (_four_center_method=="cache") {
-
-          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculating 4c integrals. " << flush;
-          _ERIs.Initialize_4c_small_molecule(_dftbasis);
-          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculated 4c integrals. " << flush;
-        }
-
-        if (_with_screening && _four_center_method=="direct") {
-          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculating 4c diagonals. " << flush;
-          _ERIs.Initialize_4c_screening(_dftbasis, _screening_eps);
-          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculated 4c diagonals. " << flush;
-        }
-      }
-
       return;
     }
     
@@ -641,10 +668,30 @@ void DFTEngine::CalcElDipole(Orbitals& orbitals)const{
       
       CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " " << uniqueelements.size() << " unique elements found" << flush;
       std::vector< Eigen::MatrixXd > uniqueatom_guesses;
+      AtomicGuessCache cache(_atomic_guess_cache);
       for ( QMAtom* unique_atom:uniqueelements) {
+        const std::string cachekey = AtomicGuessCache::Key(unique_atom->getType(), _dftbasis_name,
+                _with_ecp ? _ecp_name : "", _xc_functional_name, _grid_name);
+        if (!_atomic_guess_cache.empty()) {
+          std::vector<QMAtom*> atom = {unique_atom};
+          AOBasis atombasis;
+          atombasis.AOBasisFill(_dftbasisset, atom);
+          Eigen::MatrixXd dmat_cached;
+          if (cache.Load(cachekey, dmat_cached) && dmat_cached.rows() == atombasis.AOBasisSize()
+                  && dmat_cached.cols() == atombasis.AOBasisSize()) {
+            CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Read atom density for "
+                    << unique_atom->getType() << " from " << _atomic_guess_cache << flush;
+            uniqueatom_guesses.push_back(dmat_cached);
+            continue;
+          }
+        }
         CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculating atom density for " << unique_atom->getType() << flush;
         Eigen::MatrixXd dmat_unrestricted=RunAtomicDFT_unrestricted(unique_atom);
         uniqueatom_guesses.push_back(dmat_unrestricted);
+        if (!_atomic_guess_cache.empty() && !cache.Store(cachekey, dmat_unrestricted)) {
+          CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " WARNING: could not write atom density to "
+                  << _atomic_guess_cache << flush;
+        }
       }
  
       Eigen::MatrixXd guess = Eigen::MatrixXd::Zero(_dftbasis.AOBasisSize(), _dftbasis.AOBasisSize());
@@ -729,6 +776,55 @@ void DFTEngine::Prepare(Orbitals& orbitals) {
                 << " Using native Eigen implementation, no BLAS overload " << flush;
       }
 
+      PrepareSystem(orbitals);
+
+      _gridIntegration.GridSetup(_grid_name, _atoms, _dftbasis);
+      _gridIntegration.setXCfunctional(_xc_functional_name);
+      CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Setup numerical integration grid "
+              << _grid_name << " for vxc functional "
+              << _xc_functional_name <<  flush;
+      CTP_LOG(ctp::logDEBUG, *_pLog) << "\t\t "<<" with " << _gridIntegration.getGridSize() << " points" 
+              << " divided into "<< _gridIntegration.getBoxesSize() << " boxes" << flush;
+      if (_use_small_grid) {
+        _gridIntegration_small.GridSetup(_grid_name_small, _atoms, _dftbasis);
+        _gridIntegration_small.setXCfunctional(_xc_functional_name);
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Setup small numerical integration grid "
+                << _grid_name_small << " for vxc functional "
+                << _xc_functional_name  << flush;
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "\t\t " << " with " << _gridIntegration_small.getGridSize() << " points"
+                << " divided into "<< _gridIntegration_small.getBoxesSize() << " boxes" << flush;
+      }
+
+      if (_do_externalfield) {
+        _gridIntegration_ext.GridSetup(_grid_name_ext, _atoms, _dftbasis);
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Setup numerical integration grid "
+                << _grid_name_ext << " for external field with "
+                << _gridIntegration_ext.getGridpoints().size() << " points" << flush;
+      }
+
+      ConfigOrbfile(orbitals);
+      SetupInvariantMatrices();
+      _prepared_atoms.clear();
+      for (const QMAtom* atom : _atoms) {
+        _prepared_atoms.push_back(*atom);
+      }
+      return;
+    }
+
+    /*
+     * EvaluateSemiNumericalGradient builds all integrals and grids at the displaced
+     * geometries itself, so only the basis sets and ECPs are loaded, no SCF setup is done
+     */
+    void DFTEngine::PrepareSemiNumericalGradient(Orbitals& orbitals) {
+#ifdef _OPENMP
+      omp_set_num_threads(_openmp_threads);
+#endif
+      PrepareSystem(orbitals);
+      return;
+    }
+
+    // atoms, basis sets, ECPs, exact exchange and number of electrons
+    void DFTEngine::PrepareSystem(Orbitals& orbitals) {
       if (_atoms.size() == 0) {
         _atoms = orbitals.QMAtoms();
       }
@@ -769,37 +865,12 @@ void DFTEngine::Prepare(Orbitals& orbitals) {
                 << " Filled ECP Basis of size " << _ecp.getNumofShells() << flush;
       }
 
-      _gridIntegration.GridSetup(_grid_name, _atoms, _dftbasis);
-      _gridIntegration.setXCfunctional(_xc_functional_name);
-
       _ScaHFX = _gridIntegration.getExactExchange(_xc_functional_name);
       if (_ScaHFX > 0) {
         CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
                 << " Using hybrid functional with alpha=" << _ScaHFX << flush;
       }
 
-      CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Setup numerical integration grid "
-              << _grid_name << " for vxc functional "
-              << _xc_functional_name <<  flush;
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "\t\t "<<" with " << _gridIntegration.getGridSize() << " points" 
-              << " divided into "<< _gridIntegration.getBoxesSize() << " boxes" << flush;
-      if (_use_small_grid) {
-        _gridIntegration_small.GridSetup(_grid_name_small, _atoms, _dftbasis);
-        _gridIntegration_small.setXCfunctional(_xc_functional_name);
-        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Setup small numerical integration grid "
-                << _grid_name_small << " for vxc functional "
-                << _xc_functional_name  << flush;
-        CTP_LOG(ctp::logDEBUG, *_pLog) << "\t\t " << " with " << _gridIntegration_small.getGridSize() << " points"
-                << " divided into "<< _gridIntegration_small.getBoxesSize() << " boxes" << flush;
-      }
-
-      if (_do_externalfield) {
-        _gridIntegration_ext.GridSetup(_grid_name_ext, _atoms, _dftbasis);
-        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Setup numerical integration grid "
-                << _grid_name_ext << " for external field with "
-                << _gridIntegration_ext.getGridpoints().size() << " points" << flush;
-      }
-
       for (auto& atom : _atoms) {
         _numofelectrons += atom->getNuccharge();
       }
@@ -807,10 +878,44 @@ void DFTEngine::Prepare(Orbitals& orbitals) {
       // here number of electrons is actually the total number, everywhere else in votca it is just alpha_electrons
       CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
               << " Total number of electrons: " << _numofelectrons << flush;
+      return;
+    }
 
+    bool DFTEngine::PrepareWarmStart(Orbitals& orbitals) {
+      const std::vector<QMAtom*>& atoms = orbitals.QMAtoms();
+      if (_prepared_atoms.size() == 0 || atoms.size() != _prepared_atoms.size()) {
+        return false;
+      }
+      for (unsigned i = 0; i < atoms.size(); i++) {
+        const QMAtom& prepared = _prepared_atoms[i];
+        if (atoms[i]->getType() != prepared.getType()
+                || atoms[i]->getNuccharge() != prepared.getNuccharge()
+                || abs(atoms[i]->getPos() - prepared.getPos()) > 1e-9) {
+          return false;
+        }
+      }
+      const int size = _dftbasis.AOBasisSize();
+      if (orbitals.MOCoefficients().rows() != size || orbitals.MOCoefficients().cols() != size
+              || orbitals.MOEnergies().size() != size) {
+        return false;
+      }
+#ifdef _OPENMP
+      omp_set_num_threads(_openmp_threads);
+#endif
+      CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
+              << " Reusing basis sets, grids and integrals of the previous run" << flush;
+      // orbitals may hold new copies of the same atoms, the shells of the basis
+      // sets still refer to the old ones, which are only used to setup ECPs and
+      // the atomic guess
+      _atoms = orbitals.QMAtoms();
+      _with_guess = true;
       ConfigOrbfile(orbitals);
-      SetupInvariantMatrices();
-      return;
+      SetupExternalPotentials();
+      _conv_accelerator.setLogger(_pLog);
+      _conv_accelerator.Reset();
+      // J of the previous run belongs to other external potentials
+      _ERIs.ResetIncremental();
+      return true;
     }
 
     void DFTEngine::NuclearRepulsion() {
@@ -828,6 +933,137 @@ void DFTEngine::Prepare(Orbitals& orbitals) {
       return;
     }
 
+    Eigen::MatrixX3d DFTEngine::NuclearRepulsionGradient() const {
+      Eigen::MatrixX3d gradient = Eigen::MatrixX3d::Zero(_atoms.size(), 3);
+      for (unsigned i = 0; i < _atoms.size(); i++) {
+        const Eigen::Vector3d r1 = _atoms[i]->getPos().toEigen();
+        double charge1 = _atoms[i]->getNuccharge();
+        for (unsigned j = 0; j < i; j++) {
+          const Eigen::Vector3d r12 = r1 - _atoms[j]->getPos().toEigen();
+          double charge2 = _atoms[j]->getNuccharge();
+          const Eigen::Vector3d grad = -charge1 * charge2 / std::pow(r12.norm(), 3) * r12;
+          gradient.row(i) += grad.transpose();
+          gradient.row(j) -= grad.transpose();
+        }
+      }
+      return gradient;
+    }
+
+    /*
+     * Electronic energy for a density matrix held fixed in the AO basis minus
+     * Tr(W S), with everything that moves with the atoms rebuilt at the current
+     * positions: basis functions, one-electron and ECP integrals, external sites,
+     * the aux basis and three-center integrals and the xc grid and its weights.
+     */
+    double DFTEngine::FrozenDensityEnergy(const Eigen::MatrixXd& dmat, const Eigen::MatrixXd& energy_dmat) {
+      AOBasis dftbasis;
+      dftbasis.AOBasisFill(_dftbasisset, _atoms);
+      AOOverlap overlap;
+      overlap.Fill(dftbasis);
+      AOKinetic kinetic;
+      kinetic.Fill(dftbasis);
+      AOESP esp;
+      esp.Fillnucpotential(dftbasis, _atoms);
+      Eigen::MatrixXd H0 = kinetic.Matrix() + esp.getNuclearpotential();
+      double energy = 0.0;
+      if (_with_ecp) {
+        AOBasis ecp;
+        ecp.ECPFill(_ecpbasisset, _atoms);
+        AOECP aoecp;
+        aoecp.setECP(&ecp);
+        aoecp.Fill(dftbasis);
+        H0 += aoecp.Matrix();
+      }
+      if (_addexternalsites) {
+        esp.Fillextpotential(dftbasis, _externalsites);
+        AODipole_Potential dipole_potential;
+        dipole_potential.Fillextpotential(dftbasis, _externalsites);
+        AOQuadrupole_Potential quadrupole_potential;
+        quadrupole_potential.Fillextpotential(dftbasis, _externalsites);
+        H0 += esp.getExternalpotential();
+        H0 += dipole_potential.getExternalpotential();
+        H0 += quadrupole_potential.getExternalpotential();
+        energy += ExternalRepulsion();
+      }
+      energy += dmat.cwiseProduct(H0).sum() - energy_dmat.cwiseProduct(overlap.Matrix()).sum();
+
+      NumericalIntegration gridIntegration;
+      gridIntegration.GridSetup(_grid_name, _atoms, dftbasis);
+      gridIntegration.setXCfunctional(_xc_functional_name);
+      gridIntegration.IntegrateVXC(dmat);
+      energy += gridIntegration.getTotEcontribution();
+
+      AOBasis auxbasis;
+      if (_with_RI) {
+        auxbasis.AOBasisFill(_auxbasisset, _atoms);
+      }
+      ERIs eris;
+      SetupERIs(eris, dftbasis, auxbasis);
+      CalculateERIs(eris, dftbasis, dmat);
+      energy += 0.5 * eris.getERIsenergy();
+      if (_ScaHFX > 0) {
+        CalculateEXX(eris, dmat);
+        energy -= _ScaHFX / 4 * eris.getEXXsenergy();
+      }
+      return energy;
+    }
+
+    /*
+     * The SCF energy is stationary in the density matrix under the constraint
+     * C^T S C = 1, so its derivative is the explicit derivative at fixed density
+     * matrix minus Tr(W dS/dR) with W = 2 sum_occ e_i c_i c_i^T. The nuclear
+     * repulsion is differentiated analytically, the electronic part by central
+     * differences of FrozenDensityEnergy. There are no derivative integrals, each
+     * of the 6N displacements sets up all integrals and grids again and does a
+     * single Fock build, which only saves the SCF iterations.
+     */
+    Eigen::MatrixX3d DFTEngine::EvaluateSemiNumericalGradient(Orbitals& orbitals, double displacement) {
+      if (_do_externalfield || _integrate_ext_density) {
+        throw std::runtime_error("DFTEngine: gradients with external grid potentials or densities are not implemented");
+      }
+      if (orbitals.MOCoefficients().rows() != _dftbasis.AOBasisSize()) {
+        throw std::runtime_error((boost::format("DFTEngine: gradient needs the MOs of the %1% basis, orbitals have %2% functions")
+                % _dftbasis_name % orbitals.MOCoefficients().rows()).str());
+      }
+#ifdef _OPENMP
+      omp_set_num_threads(_openmp_threads);
+#endif
+      const int occupied = _numofelectrons / 2;
+      const Eigen::MatrixXd occMOs = orbitals.MOCoefficients().leftCols(occupied);
+      const Eigen::MatrixXd dmat = 2.0 * occMOs * occMOs.transpose();
+      const Eigen::MatrixXd energy_dmat = 2.0 * occMOs
+              * orbitals.MOEnergies().head(occupied).asDiagonal() * occMOs.transpose();
+
+      CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Calculating gradient from "
+              << 6 * _atoms.size() << " frozen density energies" << flush;
+      // puts the displaced atom back, also if one of the energies throws
+      struct PositionGuard {
+        QMAtom* atom;
+        const tools::vec position;
+        ~PositionGuard() {
+          atom->setPos(position);
+        }
+      };
+      Eigen::MatrixX3d gradient = NuclearRepulsionGradient();
+      for (unsigned i = 0; i < _atoms.size(); i++) {
+        {
+          PositionGuard guard{_atoms[i], _atoms[i]->getPos()};
+          for (int i_cart = 0; i_cart < 3; i_cart++) {
+            tools::vec displacement_vec(0, 0, 0);
+            displacement_vec[i_cart] = displacement;
+            _atoms[i]->setPos(guard.position + displacement_vec);
+            double energy_plus = FrozenDensityEnergy(dmat, energy_dmat);
+            _atoms[i]->setPos(guard.position - displacement_vec);
+            double energy_minus = FrozenDensityEnergy(dmat, energy_dmat);
+            gradient(i, i_cart) += 0.5 * (energy_plus - energy_minus) / displacement;
+          }
+        }
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Gradient on atom " << i << " "
+                << gradient.row(i) << " Hartree/Bohr" << flush;
+      }
+      return gradient;
+    }
+
     double DFTEngine::ExternalRepulsion(ctp::Topology* top) {
 
 
@@ -1001,14 +1237,30 @@ void DFTEngine::Prepare(Orbitals& orbitals) {
       return e_contrib+esp.getNuclearpotential();
     }
 
-    void DFTEngine::CalculateERIs(const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT) {
+    void DFTEngine::CalculateERIs(ERIs& eris, const AOBasis& dftbasis, const Eigen::MatrixXd& dmat) {
 
       if (_with_RI)
-        _ERIs.CalculateERIs(_dftAOdmat);
-      else if (_four_center_method.compare("cache") == 0)
-        _ERIs.CalculateERIs_4c_small_molecule(_dftAOdmat);
-      else if (_four_center_method.compare("direct") == 0)
-        _ERIs.CalculateERIs_4c_direct(_dftbasis, _dftAOdmat);
+        eris.CalculateERIs(dmat);
+      else if (_four_center_method.compare("cache") == 0 || _four_center_method.compare("disk") == 0)
+        eris.CalculateERIs_4c_small_molecule(dmat);
+      else if (_four_center_method.compare("direct") == 0) {
+        if (_incremental_fock) {
+          eris.CalculateERIs_4c_direct_incremental(dftbasis, dmat);
+        } else {
+          eris.CalculateERIs_4c_direct(dftbasis, dmat);
+        }
+        CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " 4c direct: computed "
+                << eris.getComputedQuartets() << " skipped " << eris.getSkippedQuartets()
+                << " shell quartets" << flush;
+      }
+    }
+
+    void DFTEngine::CalculateEXX(ERIs& eris, const Eigen::MatrixXd& dmat) {
+      if (_with_RI) {
+        eris.CalculateEXX(dmat);
+      } else {
+        eris.CalculateEXX_4c_small_molecule(dmat);
+      }
     }
     
     Eigen::MatrixXd DFTEngine::OrthogonalizeGuess(const Eigen::MatrixXd& GuessMOs ){
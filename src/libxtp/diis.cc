@@ -24,6 +24,19 @@
 namespace votca { namespace xtp {
   
    
+   void DIIS::Reset(){
+     for (Eigen::MatrixXd* error:_errormatrixhist){
+       delete error;
+     }
+     _errormatrixhist.clear();
+     for (std::vector<double>* Bijs:_Diis_Bs){
+       delete Bijs;
+     }
+     _Diis_Bs.clear();
+     success=true;
+     return;
+   }
+   
    void DIIS::Update(int maxerrorindex, const Eigen::MatrixXd& errormatrix){
      
      
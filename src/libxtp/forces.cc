@@ -18,7 +18,9 @@
  */
 
 #include <votca/xtp/forces.h>
+#include <votca/xtp/qmpackage.h>
 #include <boost/format.hpp>
+#include <memory>
 
 #include "votca/xtp/statefilter.h"
 
@@ -28,16 +30,18 @@ namespace votca {
       using std::flush;
         void Forces::Initialize(tools::Property &options) {
 
-            std::vector<std::string> choices = {"forward", "central"};
+            std::vector<std::string> choices = {"forward", "central", "seminumerical"};
             _force_method = options.ifExistsAndinListReturnElseThrowRuntimeError<std::string>(".method", choices);
 
             _noisy_output = options.ifExistsReturnElseReturnDefault<bool>(".noisy", false); 
            
-            if ((_force_method == "forward") || (_force_method == "central")) {
-                _displacement = options.ifExistsReturnElseReturnDefault<double>(".displacement", 0.001); // Angstrom
-            }
+            // for seminumerical the displacement is used for the frozen density energies of the DFT engine
+            _displacement = options.ifExistsReturnElseReturnDefault<double>(".displacement", 0.001); // Angstrom
             _displacement*=tools::conv::ang2bohr;
 
+            _concurrent_tasks = options.ifExistsReturnElseReturnDefault<int>(".concurrent_tasks", 1);
+            _threads_per_task = options.ifExistsReturnElseReturnDefault<int>(".threads_per_task", 0);
+
             // check for force removal options
             choices = {"total", "none"};
             std::string _force_removal = options.ifExistsAndinListReturnElseThrowRuntimeError<std::string>(".removal", choices);
@@ -55,6 +59,24 @@ namespace votca {
             if ( ! _noisy_output ){
                 _pLog->setReportLevel(ctp::logERROR); // go silent for force calculations
             }
+            if (_force_method == "seminumerical") {
+                if (SemiNumericalGradient()) {
+                    _pLog->setReportLevel(ReportLevel);
+                    if (_remove_total_force) RemoveTotalForce();
+                    return;
+                }
+                CTP_LOG(ctp::logERROR, *_pLog) << "FORCES: no seminumerical gradient from the QM package for this state, "
+                        "using central differences" << flush;
+            }
+            if (_concurrent_tasks > 1) {
+                if (ConcurrentForces(energy)) {
+                    _pLog->setReportLevel(ReportLevel);
+                    if (_remove_total_force) RemoveTotalForce();
+                    return;
+                }
+                CTP_LOG(ctp::logERROR, *_pLog) << "FORCES: QM package cannot run concurrently, "
+                        "displacing atoms one after the other" << flush;
+            }
             std::vector<QMAtom*>& atoms=_orbitals.QMAtoms();
             for (unsigned atom_index=0;atom_index<atoms.size();atom_index++) {
                 if ( _noisy_output ){
@@ -63,7 +85,7 @@ namespace votca {
                 Eigen::Vector3d atom_force=Eigen::Vector3d::Zero();
                 // Calculate Force on this atom
                 if (_force_method == "forward") atom_force=NumForceForward(energy, atom_index);
-                if (_force_method == "central") atom_force=NumForceCentral(energy, atom_index);
+                if (_force_method == "central" || _force_method == "seminumerical") atom_force=NumForceCentral(energy, atom_index);
                 _forces.row(atom_index)=atom_force.transpose();
             }
             _pLog->setReportLevel(ReportLevel); // 
@@ -74,7 +96,11 @@ namespace votca {
         void Forces::Report() const{
 
             CTP_LOG(ctp::logINFO, *_pLog) << (boost::format("   ---- FORCES (Hartree/Bohr)   ")).str() << flush;
-            CTP_LOG(ctp::logINFO, *_pLog) << (boost::format("        %1$s differences   ") % _force_method).str() << flush;
+            if (_force_method == "seminumerical") {
+                CTP_LOG(ctp::logINFO, *_pLog) << (boost::format("        seminumerical gradient of the QM package   ")).str() << flush;
+            } else {
+                CTP_LOG(ctp::logINFO, *_pLog) << (boost::format("        %1$s differences   ") % _force_method).str() << flush;
+            }
             CTP_LOG(ctp::logINFO, *_pLog) << (boost::format("        displacement %1$1.4f Angstrom   ") % (_displacement*tools::conv::bohr2ang)).str() << flush;
             CTP_LOG(ctp::logINFO, *_pLog) << (boost::format("   Atom\t x\t  y\t  z ")).str() << flush;
 
@@ -85,6 +111,122 @@ namespace votca {
             return;
         }
 
+        /* Ground state forces from the frozen density gradient of the QM package, false if it provides none */
+        bool Forces::SemiNumericalGradient() {
+            if (_filter.CalcState(_orbitals).Type() != QMStateType::Gstate) {
+                return false;
+            }
+            QMPackage* qmpackage = _gwbse_engine.getQMPackage();
+            qmpackage->setLog(_pLog);
+            Eigen::MatrixX3d gradient;
+            if (!qmpackage->CalculateSemiNumericalGradient(_orbitals, _displacement, gradient)) {
+                return false;
+            }
+            _forces = -gradient;
+            return true;
+        }
+
+        /* Copy of the reference with one atom displaced and the reference MOs as guess */
+        void Forces::DisplacedOrbitals(Orbitals& displaced, int atom_index, const tools::vec& displacement) const {
+            for (const QMAtom* atom : _orbitals.QMAtoms()) {
+                displaced.AddAtom(*atom);
+            }
+            QMAtom* atom = displaced.QMAtoms()[atom_index];
+            atom->setPos(atom->getPos() + displacement);
+            displaced.setDFTbasis(_orbitals.getDFTbasis());
+            displaced.setECP(_orbitals.getECP());
+            displaced.setBasisSetSize(_orbitals.getBasisSetSize());
+            displaced.setNumberOfElectrons(_orbitals.getNumberOfElectrons());
+            displaced.setNumberOfLevels(_orbitals.getLumo(), _orbitals.getNumberOfLevels() - _orbitals.getLumo());
+            displaced.MOEnergies() = _orbitals.MOEnergies();
+            displaced.MOCoefficients() = _orbitals.MOCoefficients();
+            return;
+        }
+
+        /*
+         * All displaced calculations are independent, so they run as tasks of an
+         * OpenMP loop with _concurrent_tasks threads. Each task has its own copy
+         * of the QM package, the GWBSE engine and the orbitals and gets
+         * _threads_per_task threads for the nested parallel regions of DFT and GW-BSE.
+         * The reference orbitals are left untouched.
+         */
+        bool Forces::ConcurrentForces(double energy) {
+            QMPackage* reference = _gwbse_engine.getQMPackage();
+            std::unique_ptr<QMPackage> probe(reference->Clone());
+            if (!probe) {
+                return false;
+            }
+            std::vector<int> signs = {1};
+            if (_force_method != "forward") {
+                signs.push_back(-1);
+            }
+            const int ntasks = _natoms * 3 * signs.size();
+            int threads_per_task = _threads_per_task;
+#ifdef _OPENMP
+            if (threads_per_task < 1) {
+                threads_per_task = std::max(1, omp_get_max_threads() / _concurrent_tasks);
+            }
+            const int nested = omp_get_nested();
+            omp_set_nested(1);
+#endif
+            CTP_LOG(ctp::logINFO, *_pLog) << "FORCES: " << ntasks << " displaced calculations, "
+                    << _concurrent_tasks << " at a time with " << threads_per_task << " threads each" << flush;
+
+            std::vector<double> energies(ntasks, 0.0);
+            std::string error;
+#pragma omp parallel for schedule(dynamic) num_threads(_concurrent_tasks)
+            for (int task = 0; task < ntasks; task++) {
+                try {
+#ifdef _OPENMP
+                    omp_set_num_threads(threads_per_task);
+#endif
+                    const int atom_index = task / (3 * signs.size());
+                    const int i_cart = (task / signs.size()) % 3;
+                    tools::vec displacement_vec(0, 0, 0);
+                    displacement_vec[i_cart] = signs[task % signs.size()] * _displacement;
+
+                    ctp::Logger task_log(ctp::logERROR);
+                    std::unique_ptr<QMPackage> qmpackage(reference->Clone());
+                    qmpackage->setLog(&task_log);
+                    qmpackage->setThreads(threads_per_task);
+                    qmpackage->setGuessRequested(true);
+                    GWBSEEngine gwbse_engine = _gwbse_engine;
+                    gwbse_engine.setLog(&task_log);
+                    gwbse_engine.setQMPackage(qmpackage.get());
+                    gwbse_engine.setRedirectLogger(false);
+                    gwbse_engine.setThreads(threads_per_task);
+
+                    Orbitals displaced;
+                    DisplacedOrbitals(displaced, atom_index, displacement_vec);
+                    gwbse_engine.ExcitationEnergies(displaced);
+                    energies[task] = displaced.getTotalStateEnergy(_filter.CalcState(displaced));
+                } catch (std::exception& e) {
+#pragma omp critical
+                    {
+                        error = e.what();
+                    }
+                }
+            }
+#ifdef _OPENMP
+            omp_set_nested(nested);
+#endif
+            if (!error.empty()) {
+                throw std::runtime_error("Forces: displaced calculation failed: " + error);
+            }
+
+            for (unsigned atom_index = 0; atom_index < _natoms; atom_index++) {
+                for (unsigned i_cart = 0; i_cart < 3; i_cart++) {
+                    const int task = (3 * atom_index + i_cart) * signs.size();
+                    if (_force_method == "forward") {
+                        _forces(atom_index, i_cart) = (energy - energies[task]) / _displacement;
+                    } else {
+                        _forces(atom_index, i_cart) = 0.5 * (energies[task + 1] - energies[task]) / _displacement;
+                    }
+                }
+            }
+            return true;
+        }
+
         /* Calculate forces on an atom numerically by forward differences */
         Eigen::Vector3d Forces::NumForceForward(double energy,int atom_index) {
             Eigen::Vector3d force=Eigen::Vector3d::Zero();
@@ -18,33 +18,261 @@
  */
 
 #include <votca/xtp/fourcenter.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
 
 
 namespace votca {
     namespace xtp {
 
-       void FCMatrix::Fill_4c_small_molecule(const AOBasis& dftbasis) {
+       namespace {
+         // quartets are collected per thread until a batch holds this many integrals, 16 MB
+         const std::size_t disk_batch_values = 1 << 21;
+
+         struct DiskBatch {
+           std::vector<int> shells;
+           std::vector<double> values;
+         };
+
+         // batch layout: number of quartets, number of integrals, the four shell
+         // indices of every quartet, the integrals of all quartets
+         bool WriteDiskBatch(std::ofstream& file, DiskBatch& batch) {
+           int nquartets = batch.shells.size() / 4;
+           long nvalues = batch.values.size();
+           file.write(reinterpret_cast<const char*> (&nquartets), sizeof (nquartets));
+           file.write(reinterpret_cast<const char*> (&nvalues), sizeof (nvalues));
+           file.write(reinterpret_cast<const char*> (batch.shells.data()), batch.shells.size() * sizeof (int));
+           file.write(reinterpret_cast<const char*> (batch.values.data()), batch.values.size() * sizeof (double));
+           batch.shells.clear();
+           batch.values.clear();
+           return bool(file);
+         }
+       }
+
+       std::vector<FCMatrix::ShellPairTask> FCMatrix::SortedShellPairTasks(const AOBasis& dftbasis) {
+         int shellsize = dftbasis.getNumofShells();
+         // cost of a shell pair ~ number of functions times number of primitive pairs
+         Eigen::MatrixXd paircost = Eigen::MatrixXd::Zero(shellsize, shellsize);
+         for (int i = 0; i < shellsize; ++i) {
+           const AOShell* shell_i = dftbasis.getShell(i);
+           for (int j = i; j < shellsize; ++j) {
+             const AOShell* shell_j = dftbasis.getShell(j);
+             paircost(i, j) = double(shell_i->getNumFunc() * shell_j->getNumFunc())
+                     * double(shell_i->getSize() * shell_j->getSize());
+           }
+         }
+         // cost of all pairs (1,2) with i<=1<=2
+         Eigen::VectorXd tailcost = Eigen::VectorXd::Zero(shellsize + 1);
+         for (int i = shellsize - 1; i >= 0; --i) {
+           tailcost(i) = tailcost(i + 1) + paircost.row(i).sum();
+         }
+         std::vector<ShellPairTask> tasks;
+         tasks.reserve((shellsize * (shellsize + 1)) / 2);
+         for (int i = 0; i < shellsize; ++i) {
+           for (int j = i; j < shellsize; ++j) {
+             ShellPairTask task;
+             task.shell_3 = i;
+             task.shell_4 = j;
+             task.cost = paircost(i, j) * tailcost(i);
+             tasks.push_back(task);
+           }
+         }
+         std::stable_sort(tasks.begin(), tasks.end(),
+                 [](const ShellPairTask& a, const ShellPairTask & b) {
+                   return a.cost > b.cost;
+                 });
+         return tasks;
+       }
+
+       tensor4d FCMatrix::QuartetBuffer(const AOBasis& dftbasis) {
+         int maxfunc = 0;
+         for (const AOShell* shell : dftbasis) {
+           maxfunc = std::max(maxfunc, shell->getNumFunc());
+         }
          tensor4d::extent_gen extents;
-          int dftBasisSize = dftbasis.AOBasisSize();
-          int vectorSize = (dftBasisSize*(dftBasisSize+1))/2;
-          
+         return tensor4d(extents[ range(0, maxfunc) ][ range(0, maxfunc) ][ range(0, maxfunc)][ range(0, maxfunc)]);
+       }
+
+       long FCMatrix::PackedSize(const AOBasis& dftbasis) {
+         long dftBasisSize = dftbasis.AOBasisSize();
+         long vectorSize = (dftBasisSize * (dftBasisSize + 1)) / 2;
+         return (vectorSize * (vectorSize + 1)) / 2;
+       }
+
+       void FCMatrix::Fill_4c_small_molecule(const AOBasis& dftbasis) {
+          _diskfile.reset();
+          _disk_quartets = 0;
           try{
-          _4c_vector = Eigen::VectorXd::Zero((vectorSize*(vectorSize+1))/2);
+          _4c_vector = Eigen::VectorXd::Zero(PackedSize(dftbasis));
           }
           catch(std::bad_alloc& ba){
-            std::cerr << "Basisset too large for 4c calculation. Not enough RAM. Caught bad alloc: " << ba.what() << std::endl;
-            exit(0);
+            throw std::runtime_error("Basisset too large for 4c calculation in memory, use four_center_method disk. Caught bad alloc: "
+                    + std::string(ba.what()));
           }
+          FillPacked(dftbasis, _4c_vector.data());
+          return;
+       }
+
+       void FCMatrix::Fill_4c_disk(const AOBasis& dftbasis, const std::string& filename,
+               const Eigen::MatrixXd& schwarz_shellpairs, double eps) {
+          _4c_vector.resize(0);
+          _diskfile.reset();
+          _shell_start.clear();
+          _shell_numfunc.clear();
+          for (const AOShell* shell : dftbasis) {
+            _shell_start.push_back(shell->getStartIndex());
+            _shell_numfunc.push_back(shell->getNumFunc());
+          }
+          std::shared_ptr<const std::string> diskfile(new std::string(filename),
+                  [](const std::string * name) {
+                    std::remove(name->c_str());
+                    delete name;
+                  });
+          std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+          if (!file.is_open()) {
+            throw std::runtime_error("Could not open 4c scratch file " + filename);
+          }
+          const bool screening = (schwarz_shellpairs.size() > 0);
+          int shellsize = dftbasis.getNumofShells();
+          const std::vector<ShellPairTask> tasks = SortedShellPairTasks(dftbasis);
+          const int ntasks = tasks.size();
+          long stored = 0;
+          bool failed = false;
+          #pragma omp parallel reduction(+:stored)
+          {
+          tensor4d block = QuartetBuffer(dftbasis);
+          DiskBatch batch;
+          #pragma omp for schedule(dynamic)
+          for (int task = 0; task < ntasks; ++task) {
+            int shell_3 = tasks[task].shell_3;
+            int shell_4 = tasks[task].shell_4;
+            const AOShell* _shell_3 = dftbasis.getShell(shell_3);
+            const AOShell* _shell_4 = dftbasis.getShell(shell_4);
+            int NumFunc_3 = _shell_3->getNumFunc();
+            int NumFunc_4 = _shell_4->getNumFunc();
+            for (int shell_1 = shell_3; shell_1 < shellsize; ++shell_1) {
+              const AOShell* _shell_1 = dftbasis.getShell(shell_1);
+              int NumFunc_1 = _shell_1->getNumFunc();
+              for (int shell_2 = shell_1; shell_2 < shellsize; ++shell_2) {
+                const AOShell* _shell_2 = dftbasis.getShell(shell_2);
+                int NumFunc_2 = _shell_2->getNumFunc();
+                // Cauchy-Schwarz
+                if (screening && schwarz_shellpairs(shell_1, shell_2) * schwarz_shellpairs(shell_3, shell_4) < eps) {
+                  continue;
+                }
+                for (int i_1 = 0; i_1 < NumFunc_1; ++i_1) {
+                  for (int i_2 = 0; i_2 < NumFunc_2; ++i_2) {
+                    for (int i_3 = 0; i_3 < NumFunc_3; ++i_3) {
+                      for (int i_4 = 0; i_4 < NumFunc_4; ++i_4) {
+                        block[i_1][i_2][i_3][i_4] = 0.0;
+                      }
+                    }
+                  }
+                }
+                if (!FillFourCenterRepBlock(block, _shell_1, _shell_2, _shell_3, _shell_4)) {
+                  continue;
+                }
+                batch.shells.push_back(shell_1);
+                batch.shells.push_back(shell_2);
+                batch.shells.push_back(shell_3);
+                batch.shells.push_back(shell_4);
+                for (int i_1 = 0; i_1 < NumFunc_1; ++i_1) {
+                  for (int i_2 = 0; i_2 < NumFunc_2; ++i_2) {
+                    for (int i_3 = 0; i_3 < NumFunc_3; ++i_3) {
+                      for (int i_4 = 0; i_4 < NumFunc_4; ++i_4) {
+                        batch.values.push_back(block[i_1][i_2][i_3][i_4]);
+                      }
+                    }
+                  }
+                }
+                stored++;
+                if (batch.values.size() >= disk_batch_values) {
+                  #pragma omp critical(fourcenter_disk)
+                  {
+                    failed = !WriteDiskBatch(file, batch) || failed;
+                  }
+                }
+              } // DFT shell_2
+            } // DFT shell_1
+          } // shell pair tasks (3,4)
+          if (!batch.shells.empty()) {
+            #pragma omp critical(fourcenter_disk)
+            {
+              failed = !WriteDiskBatch(file, batch) || failed;
+            }
+          }
+          } // omp parallel
+          file.close();
+          if (failed || !file) {
+            throw std::runtime_error("Writing 4c scratch file " + filename + " failed");
+          }
+          _diskfile = diskfile;
+          _disk_quartets = stored;
+          return;
+       }
+
+       void FCMatrix::ReadDiskBatches(const std::function<void(const std::vector<DiskQuartet>&)>& process) const {
+         if (!_diskfile) {
+           throw std::runtime_error("4c integrals are not stored on disk");
+         }
+         std::ifstream file(_diskfile->c_str(), std::ios::binary);
+         if (!file.is_open()) {
+           throw std::runtime_error("Could not open 4c scratch file " + *_diskfile);
+         }
+         std::vector<int> shells;
+         std::vector<double> values;
+         std::vector<DiskQuartet> quartets;
+         int nquartets = 0;
+         while (file.read(reinterpret_cast<char*> (&nquartets), sizeof (nquartets))) {
+           long nvalues = 0;
+           file.read(reinterpret_cast<char*> (&nvalues), sizeof (nvalues));
+           shells.resize(4 * nquartets);
+           values.resize(nvalues);
+           file.read(reinterpret_cast<char*> (shells.data()), shells.size() * sizeof (int));
+           file.read(reinterpret_cast<char*> (values.data()), values.size() * sizeof (double));
+           if (!file) {
+             throw std::runtime_error("4c scratch file " + *_diskfile + " is truncated");
+           }
+           quartets.resize(nquartets);
+           long offset = 0;
+           for (int q = 0; q < nquartets; ++q) {
+             DiskQuartet& quartet = quartets[q];
+             long size = 1;
+             for (int s = 0; s < 4; ++s) {
+               int shell = shells[4 * q + s];
+               quartet.start[s] = _shell_start[shell];
+               quartet.numfunc[s] = _shell_numfunc[shell];
+               size *= quartet.numfunc[s];
+             }
+             quartet.block = values.data() + offset;
+             offset += size;
+           }
+           process(quartets);
+         }
+         return;
+       }
+
+       void FCMatrix::FillPacked(const AOBasis& dftbasis, double* data) {
+          long dftBasisSize = dftbasis.AOBasisSize();
+          long vectorSize = (dftBasisSize*(dftBasisSize+1))/2;
           int shellsize=dftbasis.getNumofShells();
-          #pragma omp parallel for schedule(dynamic)
-          for(int i=0;i<shellsize;++i){
+          const std::vector<ShellPairTask> tasks = SortedShellPairTasks(dftbasis);
+          const int ntasks = tasks.size();
+          #pragma omp parallel
+          {
+          // indices into the buffer stay below the shell sizes, no reallocation per quartet
+          tensor4d block = QuartetBuffer(dftbasis);
+          #pragma omp for schedule(dynamic)
+          for(int task=0;task<ntasks;++task){
+            int i = tasks[task].shell_3;
+            int j = tasks[task].shell_4;
           
             const AOShell* _shell_3 = dftbasis.getShell(i);
             int start_3 = _shell_3->getStartIndex();
             int NumFunc_3 = _shell_3->getNumFunc();
    
-
-            for (int j=i;j<shellsize;++j) {
               const AOShell* _shell_4 = dftbasis.getShell(j);
               int start_4 = _shell_4->getStartIndex();
               int NumFunc_4 = _shell_4->getNumFunc();                
@@ -59,11 +287,10 @@ namespace votca {
                   int start_2 = _shell_2->getStartIndex();
                   int NumFunc_2 = _shell_2->getNumFunc();
                   
-                  tensor4d block(extents[ range(0, NumFunc_1) ][ range(0, NumFunc_2) ][ range(0, NumFunc_3)][ range(0, NumFunc_4)]);
-                  for (int i = 0; i < _shell_1->getNumFunc(); ++i) {
-                    for (int j = 0; j < _shell_2->getNumFunc(); ++j) {
-                      for (int k = 0; k < _shell_3->getNumFunc(); ++k) {
-                        for (int l = 0; l < _shell_4->getNumFunc(); ++l) {
+                  for (int i = 0; i < NumFunc_1; ++i) {
+                    for (int j = 0; j < NumFunc_2; ++j) {
+                      for (int k = 0; k < NumFunc_3; ++k) {
+                        for (int l = 0; l < NumFunc_4; ++l) {
                           block[i][j][k][l] = 0.0;
                         }
                       }
@@ -74,22 +301,22 @@ namespace votca {
                   if (nonzero) {
 
                     for (int i_3 = 0; i_3 < NumFunc_3; i_3++) {
-                      int ind_3 = start_3 + i_3;
-                      int sum_ind_3 = (ind_3*(ind_3+1))/2;
+                      long ind_3 = start_3 + i_3;
+                      long sum_ind_3 = (ind_3*(ind_3+1))/2;
                       for (int i_4 = 0; i_4 < NumFunc_4; i_4++) {
-                        int ind_4 = start_4 + i_4;
+                        long ind_4 = start_4 + i_4;
                         if (ind_3 > ind_4) continue;
-                        int index_34 = dftBasisSize * ind_3 - sum_ind_3 + ind_4;
-                        int index_34_12_a = vectorSize * index_34 - (index_34*(index_34+1))/2;
+                        long index_34 = dftBasisSize * ind_3 - sum_ind_3 + ind_4;
+                        long index_34_12_a = vectorSize * index_34 - (index_34*(index_34+1))/2;
                         for (int i_1 = 0; i_1 < NumFunc_1; i_1++) {
-                          int ind_1 = start_1 + i_1;
-                          int sum_ind_1 = (ind_1*(ind_1+1))/2;
+                          long ind_1 = start_1 + i_1;
+                          long sum_ind_1 = (ind_1*(ind_1+1))/2;
                           for (int i_2 = 0; i_2 < NumFunc_2; i_2++) {
-                            int ind_2 = start_2 + i_2;
+                            long ind_2 = start_2 + i_2;
                             if (ind_1 > ind_2) continue;
-                            int index_12 = dftBasisSize * ind_1 - sum_ind_1 + ind_2;
+                            long index_12 = dftBasisSize * ind_1 - sum_ind_1 + ind_2;
                             if (index_34 > index_12) continue;
-                            _4c_vector(index_34_12_a + index_12) = block[i_1][i_2][i_3][i_4];
+                            data[index_34_12_a + index_12] = block[i_1][i_2][i_3][i_4];
 
                           } // i_2
                         } // i_1
@@ -99,11 +326,11 @@ namespace votca {
                   } // end if
                 } // DFT shell_2
               } // DFT shell_1
-            } // DFT shell_4
-          } // DFT shell_3
+          } // shell pair tasks (3,4)
+          } // omp parallel
 
           return;
-        } // FCMatrix_dft::Fill_4c_small_molecule
+        } // FCMatrix::FillPacked
  
     }
 }
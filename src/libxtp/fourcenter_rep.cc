@@ -21,6 +21,9 @@
 
 
 #include <votca/xtp/fourcenter.h>
+#include <votca/xtp/cartesianindex.h>
+#include <algorithm>
+#include <array>
 
 
 
@@ -45,7 +48,7 @@ namespace votca {
          */
 
       
-        bool FCMatrix::FillFourCenterRepBlock(tensor4d& block,
+        bool FCMatrix::FillFourCenterRepBlockGeneric(tensor4d& block,
                 const AOShell* shell_1, const AOShell* shell_2, const AOShell* shell_3, const AOShell* shell_4) {
 
             const double pi = boost::math::constants::pi<double>();
@@ -267,6 +270,24 @@ namespace votca {
 
 
 
+            int offset_alpha = shell_alpha->getOffset();
+            int offset_beta = shell_beta->getOffset();
+            int offset_gamma = shell_gamma->getOffset();
+            int offset_delta = shell_delta->getOffset();
+
+            int ntrafo_alpha = shell_alpha->getNumFunc() + offset_alpha;
+            int ntrafo_beta = shell_beta->getNumFunc() + offset_beta;
+            int ntrafo_gamma = shell_gamma->getNumFunc() + offset_gamma;
+            int ntrafo_delta = shell_delta->getNumFunc() + offset_delta;
+
+            // the recursion and transformation buffers are allocated once per
+            // shell quartet and reused for every primitive quartet
+            tensor3d R_temp(extents[ range(0, _ncombined_ab ) ][ range(0, ncombined_cd ) ][ range(0, mmax+1)]);
+            tensor3d R(extents[ range(0, _ncombined_ab ) ][ range(0, _nbeta ) ][ range(0, ncombined_cd)]);
+            tensor3d R3_ab_sph(extents[ ntrafo_alpha ][ ntrafo_beta ][ ncombined_cd ]);
+            tensor4d R4_ab_sph(extents4[ ntrafo_alpha ][ ntrafo_beta ][ ncombined_cd ][ _ndelta ]);
+            tensor4d R4_sph(extents4[ ntrafo_alpha ][ ntrafo_beta ][ ntrafo_gamma ][ ntrafo_delta ]);
+
             for ( AOShell::GaussianIterator italpha = shell_alpha->begin(); italpha != shell_alpha->end(); ++italpha) {
                 const double decay_alpha = italpha->getDecay();
             
@@ -328,35 +349,13 @@ namespace votca {
 
 
 
-            tensor3d R_temp;
-            R_temp.resize(extents[ range(0, _ncombined_ab ) ][ range(0, ncombined_cd ) ][ range(0, mmax+1)]);
-            //initialize to zero
-            for (index3d i = 0; i != _ncombined_ab; ++i) {
-              for (index3d j = 0; j != ncombined_cd; ++j) {
-                for (index3d k = 0; k != mmax+1; ++k) {
-
-                  R_temp[i][j][k] = 0.0;
-
-                }
-              }
-             }
-
-
-            tensor3d R;
-            R.resize(extents[ range(0, _ncombined_ab ) ][ range(0, _nbeta ) ][ range(0, ncombined_cd)]);
             //initialize to zero
-            for (index3d i = 0; i != _ncombined_ab; ++i) {
-              for (index3d j = 0; j != _nbeta; ++j) {
-                for (index3d k = 0; k != ncombined_cd; ++k) {
-
-                  R[i][j][k] = 0.0;
-
-                }
-              }
-            }
+            std::fill(R_temp.data(), R_temp.data() + R_temp.num_elements(), 0.0);
+            std::fill(R.data(), R.data() + R.num_elements(), 0.0);
             
 
-            const std::vector<double> FmT=AOMatrix<double>::XIntegrate(mmax+1, U);
+            BoysFunction::Values FmT;
+            BoysFunction::Evaluate(FmT, mmax, U);
 
             double exp_AB = exp( -2. * decay_alpha * decay_beta * rzeta * _dist_AB );
             double exp_CD = exp( -2.* decay_gamma * decay_delta * reta * _dist_CD );
@@ -753,20 +752,9 @@ for (int l = 4; l < lmax_beta+1; l++) {
             int istart[] = {0, 1, 1, 1, 4, 4, 4, 4, 4, 10, 10, 10, 10, 10, 10, 10, 20, 20, 20, 20, 20, 20, 20, 20, 20 };
             int istop[] =  {0, 3, 3, 3, 9, 9, 9, 9, 9, 19, 19, 19, 19, 19, 19, 19, 34, 34, 34, 34, 34, 34, 34, 34, 34 };
 
-            int offset_alpha = shell_alpha->getOffset();
-            int offset_beta = shell_beta->getOffset();
-
-            // prepare transformation matrices
-            int ntrafo_alpha = shell_alpha->getNumFunc() + offset_alpha;
-            int ntrafo_beta = shell_beta->getNumFunc() + offset_beta;
-
-            
             // get transformation matrices
-            const Eigen::MatrixXd trafo_alpha = AOSuperMatrix::getTrafo(*italpha);
-            const Eigen::MatrixXd trafo_beta = AOSuperMatrix::getTrafo(*itbeta);
-
-            tensor3d R3_ab_sph;
-            R3_ab_sph.resize(extents[ ntrafo_alpha ][ ntrafo_beta ][ ncombined_cd ]);
+            const Eigen::MatrixXd& trafo_alpha = AOSuperMatrix::getTrafo(*italpha);
+            const Eigen::MatrixXd& trafo_beta = AOSuperMatrix::getTrafo(*itbeta);
 
             for (int i_beta = 0; i_beta < ntrafo_beta; i_beta++) {
               for (int i_alpha = 0; i_alpha < ntrafo_alpha; i_alpha++) {
@@ -797,9 +785,7 @@ for (int l = 4; l < lmax_beta+1; l++) {
 
 
 //copy into new 4D array.
-tensor4d R4_ab_sph;
-R4_ab_sph.resize(extents4[ ntrafo_alpha ][ ntrafo_beta ][ ncombined_cd ][ _ndelta ]);
-//ma4_type R4_ab_sph(boost::extents[ _ntrafo_alpha ][ _ntrafo_beta ][ _ncombined_cd ][ _ndelta ]);
+std::fill(R4_ab_sph.data(), R4_ab_sph.data() + R4_ab_sph.num_elements(), 0.0);
 
 for (index3d j = 0; j < ntrafo_alpha; ++j) {
   for (index3d k = 0; k < ntrafo_beta; ++k) {
@@ -910,20 +896,10 @@ for (int l = 4; l < lmax_delta+1; l++) {
 
 // Transforming gamma and delta functions to sphericals
 
-            int offset_gamma = shell_gamma->getOffset();
-            int offset_delta = shell_delta->getOffset();
-
-            // prepare transformation matrices
-            int ntrafo_gamma = shell_gamma->getNumFunc() + offset_gamma;
-            int ntrafo_delta = shell_delta->getNumFunc() + offset_delta;
+            const Eigen::MatrixXd& trafo_gamma = AOSuperMatrix::getTrafo(*itgamma);
+            const Eigen::MatrixXd& trafo_delta = AOSuperMatrix::getTrafo(*itdelta);
 
-            const Eigen::MatrixXd trafo_gamma = AOSuperMatrix::getTrafo(*itgamma);
-            const Eigen::MatrixXd trafo_delta = AOSuperMatrix::getTrafo(*itdelta);
 
-
-            tensor4d R4_sph;
-            R4_sph.resize(extents4[ ntrafo_alpha ][ ntrafo_beta ][ ntrafo_gamma ][ ntrafo_delta ]);
-            
             for (int j = 0; j < ntrafo_alpha; j++) {
                   for (int k = 0; k < ntrafo_beta; k++) {
                         for (int i_gamma = 0; i_gamma < ntrafo_gamma; i_gamma++) {
@@ -989,5 +965,372 @@ for (int l = 4; l < lmax_delta+1; l++) {
 
 
 
+        namespace {
+
+        /*
+         * Vertical recursion on the ket pair at fixed m for the cartesians
+         * C...CSTOP-1 and all a of the bra pair,
+         * (a|c+1_d)^m = QC_d (a|c)^m + WQ_d (a|c)^(m+1) + N_d(a)/(2(zeta+eta)) (a-1_d|c)^(m+1)
+         *             + N_d(c)/(2eta) ((a|c-1_d)^m - zeta/(zeta+eta) (a|c-1_d)^(m+1))
+         * with (a|c)^m at R_temp[(c*M1+m)*NAB+a]. c and m are template
+         * parameters, so that every step compiles to code with fixed offsets.
+         */
+        template <int NAB, int M1, int M, int C, int CSTOP>
+        struct VerticalStepCD {
+            static void Apply(double* R_temp, const double* fak_a, const double* qmc, const double* wmq, double reta, double cfak) {
+                using namespace CartesianIndex;
+                const int d = direction[C];
+                const int c1 = less[d][C];
+                const int c2 = less[d][c1];
+                const double fak_c = exponent[d][c1] * reta;
+                const double* c1_m = R_temp + (c1 * M1 + M) * NAB;
+                const double* c1_m1 = R_temp + (c1 * M1 + M + 1) * NAB;
+                const double* c2_m = R_temp + (c2 * M1 + M) * NAB;
+                const double* c2_m1 = R_temp + (c2 * M1 + M + 1) * NAB;
+                double* c_m = R_temp + (C * M1 + M) * NAB;
+                for (int a = 0; a < NAB; a++) {
+                    c_m[a] = qmc[d] * c1_m[a] + wmq[d] * c1_m1[a] + fak_a[d * NAB + a] * c1_m1[less[d][a]]
+                            + fak_c * (c2_m[a] - cfak * c2_m1[a]);
+                }
+                VerticalStepCD<NAB, M1, M, C + 1, CSTOP>::Apply(R_temp, fak_a, qmc, wmq, reta, cfak);
+            }
+        };
+
+        template <int NAB, int M1, int M, int CSTOP>
+        struct VerticalStepCD<NAB, M1, M, CSTOP, CSTOP> {
+            static void Apply(double*, const double*, const double*, const double*, double, double) {
+            }
+        };
+
+        // all steps for m=M...0, (a|c)^m is needed up to level LCD-m
+        template <int NAB, int M1, int LCD, int M>
+        struct VerticalCD {
+            static void Apply(double* R_temp, const double* fak_a, const double* qmc, const double* wmq, double reta, double cfak) {
+                VerticalStepCD<NAB, M1, M, 1, CartesianIndex::NumUpTo(LCD - M)>::Apply(R_temp, fak_a, qmc, wmq, reta, cfak);
+                VerticalCD<NAB, M1, LCD, M - 1>::Apply(R_temp, fak_a, qmc, wmq, reta, cfak);
+            }
+        };
+
+        template <int NAB, int M1, int LCD>
+        struct VerticalCD<NAB, M1, LCD, -1> {
+            static void Apply(double*, const double*, const double*, const double*, double, double) {
+            }
+        };
+
+        /*
+         * (ab|cd) for fixed angular momenta LA>=LB and LC>=LD. The recursions
+         * are those of FillFourCenterRepBlockGeneric, but with compile-time
+         * loop bounds and index tables, and with the intermediates in fixed
+         * size arrays on the stack, so that the compiler unrolls them for every
+         * combination. After the horizontal recursion on b the bra functions
+         * are transformed to sphericals one alpha function at a time, which
+         * keeps the buffers for the horizontal recursion on d small.
+         */
+        template <int LA, int LB, int LC, int LD>
+        struct FourCenterKernel {
+            static const int LAB = LA + LB;
+            static const int LCD = LC + LD;
+            static const int MMAX = LAB + LCD;
+            static const int NAB = CartesianIndex::NumUpTo(LAB);
+            static const int NB = CartesianIndex::NumUpTo(LB);
+            static const int NCD = CartesianIndex::NumUpTo(LCD);
+            static const int ND = CartesianIndex::NumUpTo(LD);
+            static const int NSPH_B = CartesianIndex::NumSphericalUpTo(LB);
+            static const int NSPH_C = CartesianIndex::NumSphericalUpTo(LC);
+            static_assert(LAB <= CartesianIndex::MaxL && LCD <= CartesianIndex::MaxL, "index tables only reach g functions");
+
+            static bool Fill(tensor4d& block, const AOShell* shell_alpha, const AOShell* shell_beta,
+                    const AOShell* shell_gamma, const AOShell* shell_delta,
+                    bool alphabetaswitch, bool gammadeltaswitch, bool ab_cd_switch) {
+                using namespace CartesianIndex;
+                const double pi = boost::math::constants::pi<double>();
+
+                const tools::vec& pos_alpha = shell_alpha->getPos();
+                const tools::vec& pos_beta = shell_beta->getPos();
+                const tools::vec& pos_gamma = shell_gamma->getPos();
+                const tools::vec& pos_delta = shell_delta->getPos();
+                const double dist_AB = (pos_alpha - pos_beta) * (pos_alpha - pos_beta);
+                const double dist_CD = (pos_gamma - pos_delta) * (pos_gamma - pos_delta);
+                // pairs on (nearly) the same centre are treated as one centre
+                const bool split_AB = dist_AB > 0.03;
+                const bool split_CD = dist_CD > 0.03;
+                const tools::vec amb_vec = split_AB ? pos_alpha - pos_beta : tools::vec(0.0);
+                const tools::vec cmd_vec = split_CD ? pos_gamma - pos_delta : tools::vec(0.0);
+                const double amb[3] = {amb_vec.getX(), amb_vec.getY(), amb_vec.getZ()};
+                const double cmd[3] = {cmd_vec.getX(), cmd_vec.getY(), cmd_vec.getZ()};
+
+                const int offset_alpha = shell_alpha->getOffset();
+                const int offset_beta = shell_beta->getOffset();
+                const int offset_gamma = shell_gamma->getOffset();
+                const int offset_delta = shell_delta->getOffset();
+                const int numfunc_alpha = shell_alpha->getNumFunc();
+                const int numfunc_beta = shell_beta->getNumFunc();
+                const int numfunc_gamma = shell_gamma->getNumFunc();
+                const int numfunc_delta = shell_delta->getNumFunc();
+                const int start_beta = sph_start[offset_beta];
+                const int start_delta = sph_start[offset_delta];
+
+                // the innermost index runs over the bra pair as long as it is
+                // cartesian, afterwards over the spherical beta functions
+                // (a|s)^m, a up to LA+LB, m up to MMAX
+                std::array<double, (MMAX + 1) * NAB> R_s;
+                // (a|c)^m, c up to LC+LD, m up to LC+LD
+                std::array<double, NCD * (LCD + 1) * NAB> R_temp;
+                // (ab|c)
+                std::array<double, NCD * NB * NAB> R;
+                // (ab|c) for one spherical a
+                std::array<double, NCD * NB> R_alpha;
+                // (ab|cd) for one spherical a, spherical b
+                std::array<double, NCD * ND * NSPH_B> R_ab;
+                // (ab|cd) for one spherical a, spherical b and c
+                std::array<double, NSPH_C * ND * NSPH_B> R_abc;
+
+                auto RS = [&R_s](int a, int m) -> double& {
+                    return R_s[m * NAB + a];
+                };
+                auto RT = [&R_temp](int a, int c, int m) -> double& {
+                    return R_temp[(c * (LCD + 1) + m) * NAB + a];
+                };
+                auto RH = [&R](int a, int b, int c) -> double& {
+                    return R[(c * NB + b) * NAB + a];
+                };
+                auto RA = [&R_alpha](int b, int c) -> double& {
+                    return R_alpha[c * NB + b];
+                };
+                auto RAB = [&R_ab](int b, int c, int d) -> double& {
+                    return R_ab[(c * ND + d) * NSPH_B + b];
+                };
+                auto RABC = [&R_abc](int b, int c, int d) -> double& {
+                    return R_abc[(c * ND + d) * NSPH_B + b];
+                };
+
+                for (AOShell::GaussianIterator italpha = shell_alpha->begin(); italpha != shell_alpha->end(); ++italpha) {
+                    const double decay_alpha = italpha->getDecay();
+                    const Eigen::MatrixXd& trafo_alpha = AOSuperMatrix::getTrafo(*italpha);
+
+                    for (AOShell::GaussianIterator itbeta = shell_beta->begin(); itbeta != shell_beta->end(); ++itbeta) {
+                        const double decay_beta = itbeta->getDecay();
+                        const Eigen::MatrixXd& trafo_beta = AOSuperMatrix::getTrafo(*itbeta);
+                        const double zeta = decay_alpha + decay_beta;
+                        const double rzeta = 0.5 / zeta;
+                        const tools::vec P = (decay_alpha * pos_alpha + decay_beta * pos_beta) / zeta;
+                        const tools::vec pma_vec = split_AB ? P - pos_alpha : tools::vec(0.0);
+                        const double pma[3] = {pma_vec.getX(), pma_vec.getY(), pma_vec.getZ()};
+                        const double exp_AB = exp(-2. * decay_alpha * decay_beta * rzeta * dist_AB);
+
+                        for (AOShell::GaussianIterator itgamma = shell_gamma->begin(); itgamma != shell_gamma->end(); ++itgamma) {
+                            const double decay_gamma = itgamma->getDecay();
+                            const Eigen::MatrixXd& trafo_gamma = AOSuperMatrix::getTrafo(*itgamma);
+
+                            for (AOShell::GaussianIterator itdelta = shell_delta->begin(); itdelta != shell_delta->end(); ++itdelta) {
+                                const double decay_delta = itdelta->getDecay();
+                                const Eigen::MatrixXd& trafo_delta = AOSuperMatrix::getTrafo(*itdelta);
+
+                                const double eta = decay_gamma + decay_delta;
+                                const double decay = zeta + eta;
+                                const double rho = (zeta * eta) / decay;
+                                const double reta = 0.5 / eta;
+                                const double rdecay = 0.5 / decay;
+                                const double gfak = eta / decay;
+                                const double cfak = zeta / decay;
+                                const tools::vec Q = (decay_gamma * pos_gamma + decay_delta * pos_delta) / eta;
+                                const tools::vec W = (zeta * P + eta * Q) / decay;
+                                const double U = rho * (P - Q)*(P - Q);
+                                const tools::vec qmc_vec = split_CD ? Q - pos_gamma : tools::vec(0.0);
+                                const tools::vec wmp_vec = W - P;
+                                const tools::vec wmq_vec = W - Q;
+                                const double qmc[3] = {qmc_vec.getX(), qmc_vec.getY(), qmc_vec.getZ()};
+                                const double wmp[3] = {wmp_vec.getX(), wmp_vec.getY(), wmp_vec.getZ()};
+                                const double wmq[3] = {wmq_vec.getX(), wmq_vec.getY(), wmq_vec.getZ()};
+
+                                const double exp_CD = exp(-2. * decay_gamma * decay_delta * reta * dist_CD);
+                                const double ssss = (16. * pow(decay_alpha * decay_beta * decay_gamma * decay_delta, .75) * exp_AB * exp_CD)
+                                        / (zeta * eta * sqrt(pi * decay));
+
+                                BoysFunction::Values FmT;
+                                BoysFunction::Evaluate(FmT, MMAX, U);
+                                for (int m = 0; m <= MMAX; m++) {
+                                    RS(0, m) = ssss * FmT[m];
+                                }
+
+                                // vertical recursion on a, (a+1_d|s)^m is needed up to level MMAX-m
+                                for (int m = MMAX - 1; m >= 0; m--) {
+                                    const int a_stop = (NumUpTo(MMAX - m) < NAB) ? NumUpTo(MMAX - m) : NAB;
+                                    for (int a = 1; a < a_stop; a++) {
+                                        const int d = direction[a];
+                                        const int a1 = less[d][a];
+                                        const int a2 = less[d][a1];
+                                        RS(a, m) = pma[d] * RS(a1, m) + wmp[d] * RS(a1, m + 1)
+                                                + exponent[d][a1] * rzeta * (RS(a2, m) - gfak * RS(a2, m + 1));
+                                    }
+                                }
+                                std::copy_n(R_s.begin(), (LCD + 1) * NAB, R_temp.begin());
+
+                                // vertical recursion on c, (a|c+1_d)^m is needed up to level LC+LD-m
+                                std::array<double, 3 * NAB> fak_a;
+                                for (int d = 0; d < 3; d++) {
+                                    for (int a = 0; a < NAB; a++) {
+                                        fak_a[d * NAB + a] = exponent[d][a] * rdecay;
+                                    }
+                                }
+                                VerticalCD<NAB, LCD + 1, LCD, LCD - 1>::Apply(R_temp.data(), fak_a.data(), qmc, wmq, reta, cfak);
+
+                                // horizontal recursion on b, (a|b+1_d|c)=(a+1_d|b|c)+AB_d (a|b|c)
+                                for (int c = 0; c < NCD; c++) {
+                                    std::copy_n(&RT(0, c, 0), NAB, &RH(0, 0, c));
+                                }
+                                for (int b = 1; b < NB; b++) {
+                                    const int d = direction[b];
+                                    const int b1 = less[d][b];
+                                    for (int c = 0; c < NCD; c++) {
+                                        for (int a = 0; a < NumUpTo(LAB - Level(b)); a++) {
+                                            RH(a, b, c) = RH(more[d][a], b1, c) + amb[d] * RH(a, b1, c);
+                                        }
+                                    }
+                                }
+
+                                for (int i_alpha = 0; i_alpha < numfunc_alpha; i_alpha++) {
+                                    const int i_alpha_off = i_alpha + offset_alpha;
+
+                                    // alpha to sphericals, the trafos hold the contraction
+                                    for (int c = 0; c < NCD; c++) {
+                                        for (int b = start_beta; b < NB; b++) {
+                                            double value = 0.0;
+                                            for (int j = 0; j < sph_numcart[i_alpha_off]; j++) {
+                                                const int a = sph_cart[i_alpha_off][j];
+                                                value += trafo_alpha(a, i_alpha_off) * RH(a, b, c);
+                                            }
+                                            RA(b, c) = value;
+                                        }
+                                    }
+
+                                    // beta to sphericals
+                                    for (int c = 0; c < NCD; c++) {
+                                        for (int i_beta = 0; i_beta < numfunc_beta; i_beta++) {
+                                            const int i_beta_off = i_beta + offset_beta;
+                                            double value = 0.0;
+                                            for (int j = 0; j < sph_numcart[i_beta_off]; j++) {
+                                                const int b = sph_cart[i_beta_off][j];
+                                                value += trafo_beta(b, i_beta_off) * RA(b, c);
+                                            }
+                                            RAB(i_beta, c, 0) = value;
+                                        }
+                                    }
+
+                                    // horizontal recursion on d, (ab|c|d+1_e)=(ab|c+1_e|d)+CD_e (ab|c|d)
+                                    for (int d = 1; d < ND; d++) {
+                                        const int e = direction[d];
+                                        const int d1 = less[e][d];
+                                        for (int c = 0; c < NumUpTo(LCD - Level(d)); c++) {
+                                            for (int i_beta = 0; i_beta < numfunc_beta; i_beta++) {
+                                                RAB(i_beta, c, d) = RAB(i_beta, more[e][c], d1) + cmd[e] * RAB(i_beta, c, d1);
+                                            }
+                                        }
+                                    }
+
+                                    // gamma to sphericals
+                                    for (int i_gamma = 0; i_gamma < numfunc_gamma; i_gamma++) {
+                                        const int i_gamma_off = i_gamma + offset_gamma;
+                                        for (int d = start_delta; d < ND; d++) {
+                                            for (int i_beta = 0; i_beta < numfunc_beta; i_beta++) {
+                                                RABC(i_beta, i_gamma, d) = 0.0;
+                                            }
+                                            for (int j = 0; j < sph_numcart[i_gamma_off]; j++) {
+                                                const int c = sph_cart[i_gamma_off][j];
+                                                const double coeff = trafo_gamma(c, i_gamma_off);
+                                                for (int i_beta = 0; i_beta < numfunc_beta; i_beta++) {
+                                                    RABC(i_beta, i_gamma, d) += coeff * RAB(i_beta, c, d);
+                                                }
+                                            }
+                                        }
+                                    }
+
+                                    // delta to sphericals and into the block
+                                    for (int i_gamma = 0; i_gamma < numfunc_gamma; i_gamma++) {
+                                        for (int i_delta = 0; i_delta < numfunc_delta; i_delta++) {
+                                            const int i_delta_off = i_delta + offset_delta;
+                                            const int c = gammadeltaswitch ? i_delta : i_gamma;
+                                            const int d = gammadeltaswitch ? i_gamma : i_delta;
+                                            for (int i_beta = 0; i_beta < numfunc_beta; i_beta++) {
+                                                double value = 0.0;
+                                                for (int j = 0; j < sph_numcart[i_delta_off]; j++) {
+                                                    const int dc = sph_cart[i_delta_off][j];
+                                                    value += trafo_delta(dc, i_delta_off) * RABC(i_beta, i_gamma, dc);
+                                                }
+                                                const int a = alphabetaswitch ? i_beta : i_alpha;
+                                                const int b = alphabetaswitch ? i_alpha : i_beta;
+                                                if (ab_cd_switch) {
+                                                    block[c][d][a][b] += value;
+                                                } else {
+                                                    block[a][b][c][d] += value;
+                                                }
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+                return true;
+            }
+        };
+
+        typedef bool (*FourCenterKernelFunction)(tensor4d&, const AOShell*, const AOShell*, const AOShell*, const AOShell*,
+                bool, bool, bool);
+
+        template <int LA, int LB>
+        FourCenterKernelFunction SelectFourCenterKernel(int lmax_gamma, int lmax_delta) {
+            switch (3 * lmax_gamma + lmax_delta) {
+                case 0: return &FourCenterKernel<LA, LB, 0, 0>::Fill;
+                case 3: return &FourCenterKernel<LA, LB, 1, 0>::Fill;
+                case 4: return &FourCenterKernel<LA, LB, 1, 1>::Fill;
+                case 6: return &FourCenterKernel<LA, LB, 2, 0>::Fill;
+                case 7: return &FourCenterKernel<LA, LB, 2, 1>::Fill;
+                case 8: return &FourCenterKernel<LA, LB, 2, 2>::Fill;
+                default: return nullptr;
+            }
+        }
+
+        // kernels exist for s,p,d shells with lmax_alpha>=lmax_beta and lmax_gamma>=lmax_delta
+        FourCenterKernelFunction SelectFourCenterKernel(int lmax_alpha, int lmax_beta, int lmax_gamma, int lmax_delta) {
+            switch (3 * lmax_alpha + lmax_beta) {
+                case 0: return SelectFourCenterKernel<0, 0>(lmax_gamma, lmax_delta);
+                case 3: return SelectFourCenterKernel<1, 0>(lmax_gamma, lmax_delta);
+                case 4: return SelectFourCenterKernel<1, 1>(lmax_gamma, lmax_delta);
+                case 6: return SelectFourCenterKernel<2, 0>(lmax_gamma, lmax_delta);
+                case 7: return SelectFourCenterKernel<2, 1>(lmax_gamma, lmax_delta);
+                case 8: return SelectFourCenterKernel<2, 2>(lmax_gamma, lmax_delta);
+                default: return nullptr;
+            }
+        }
+
+        }
+
+        bool FCMatrix::FillFourCenterRepBlock(tensor4d& block,
+                const AOShell* shell_1, const AOShell* shell_2, const AOShell* shell_3, const AOShell* shell_4) {
+            const bool alphabetaswitch = shell_1->getLmax() < shell_2->getLmax();
+            const bool gammadeltaswitch = shell_3->getLmax() < shell_4->getLmax();
+            const bool ab_cd_switch = (shell_1->getLmax() + shell_2->getLmax()) < (shell_3->getLmax() + shell_4->getLmax());
+            const AOShell* shell_a = alphabetaswitch ? shell_2 : shell_1;
+            const AOShell* shell_b = alphabetaswitch ? shell_1 : shell_2;
+            const AOShell* shell_c = gammadeltaswitch ? shell_4 : shell_3;
+            const AOShell* shell_d = gammadeltaswitch ? shell_3 : shell_4;
+            const AOShell* shell_alpha = ab_cd_switch ? shell_c : shell_a;
+            const AOShell* shell_beta = ab_cd_switch ? shell_d : shell_b;
+            const AOShell* shell_gamma = ab_cd_switch ? shell_a : shell_c;
+            const AOShell* shell_delta = ab_cd_switch ? shell_b : shell_d;
+            FourCenterKernelFunction kernel = (shell_alpha->getLmax() > 2 || shell_gamma->getLmax() > 2) ? nullptr
+                    : SelectFourCenterKernel(shell_alpha->getLmax(), shell_beta->getLmax(),
+                    shell_gamma->getLmax(), shell_delta->getLmax());
+            if (kernel == nullptr) {
+                return FillFourCenterRepBlockGeneric(block, shell_1, shell_2, shell_3, shell_4);
+            }
+            // the flags of the kernel refer to its own pairs
+            return kernel(block, shell_alpha, shell_beta, shell_gamma, shell_delta,
+                    ab_cd_switch ? gammadeltaswitch : alphabetaswitch,
+                    ab_cd_switch ? alphabetaswitch : gammadeltaswitch, ab_cd_switch);
+        }
+
 
     }}
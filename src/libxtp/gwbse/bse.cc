@@ -19,7 +19,9 @@
 
 
 #include <votca/xtp/bse.h>
+#include <votca/xtp/davidsonsolver.h>
 #include <votca/tools/linalg.h>
+#include <type_traits>
 
 #include "votca/xtp/qmstate.h"
 using boost::format;
@@ -29,27 +31,59 @@ namespace votca {
   namespace xtp {
 
     void BSE::Solve_triplets() {
-      MatrixXfd H = MatrixXfd::Zero(_bse_size,_bse_size);
-      Add_Hd<real_gwbse>(H);
-      Add_Hqp<real_gwbse>(H);
-      CTP_LOG(ctp::logDEBUG, *_log)
-        << ctp::TimeStamp() << " Setup TDA triplet hamiltonian " << flush;
-      CTP_LOG(ctp::logDEBUG, *_log)
-        << ctp::TimeStamp() << " Solving for first "<<_bse_nmax<<" eigenvectors"<< flush;
-      tools::linalg_eigenvalues(H , _bse_triplet_energies, _bse_triplet_coefficients ,_bse_nmax );
+      if (_use_davidson) {
+        BSEOperator Ht = getOperator(0.0, 0.0);
+        CTP_LOG(ctp::logDEBUG, *_log)
+          << ctp::TimeStamp() << " Davidson solver for first "<<_bse_nmax<<" triplet eigenvectors"<< flush;
+        Solve_Davidson(Ht, _bse_triplet_energies, _bse_triplet_coefficients);
+        return;
+      }
+      if (_double_hamiltonian) {
+        Solve_TDA<double>(0.0, "triplet", _bse_triplet_energies, _bse_triplet_coefficients);
+      } else {
+        Solve_TDA<float>(0.0, "triplet", _bse_triplet_energies, _bse_triplet_coefficients);
+      }
       return;
     }
 
     void BSE::Solve_singlets() {
-      MatrixXfd H = MatrixXfd::Zero(_bse_size,_bse_size);
-      Add_Hd<real_gwbse>(H);
-      Add_Hqp<real_gwbse>(H);
-      Add_Hx<real_gwbse>(H,2.0);
+      if (_use_davidson) {
+        BSEOperator Hs = getOperator(2.0, 0.0);
+        CTP_LOG(ctp::logDEBUG, *_log)
+          << ctp::TimeStamp() << " Davidson solver for first "<<_bse_nmax<<" singlet eigenvectors"<< flush;
+        Solve_Davidson(Hs, _bse_singlet_energies, _bse_singlet_coefficients);
+        return;
+      }
+      if (_double_hamiltonian) {
+        Solve_TDA<double>(2.0, "singlet", _bse_singlet_energies, _bse_singlet_coefficients);
+      } else {
+        Solve_TDA<float>(2.0, "singlet", _bse_singlet_energies, _bse_singlet_coefficients);
+      }
+      return;
+    }
+
+    template <typename T>
+    void BSE::Solve_TDA(double x_factor, const std::string& spin, VectorXfd& energies, MatrixXfd& coefficients) {
+      // the Hamiltonian is set up and diagonalised in precision T and only
+      // the result is converted to the storage precision real_gwbse
+      typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixXT;
+      typedef Eigen::Matrix<T, Eigen::Dynamic, 1> VectorXT;
+      MatrixXT H = MatrixXT::Zero(_bse_size, _bse_size);
+      Add_Hd<T>(H);
+      Add_Hqp<T>(H);
+      if (x_factor != 0.0) {
+        Add_Hx<T>(H, x_factor);
+      }
       CTP_LOG(ctp::logDEBUG, *_log)
-        << ctp::TimeStamp() << " Setup TDA singlet hamiltonian " << flush;
+        << ctp::TimeStamp() << " Setup TDA " << spin << " hamiltonian in "
+        << (std::is_same<T, double>::value ? "double" : "single") << " precision" << flush;
       CTP_LOG(ctp::logDEBUG, *_log)
         << ctp::TimeStamp() << " Solving for first "<<_bse_nmax<<" eigenvectors"<< flush;
-      tools::linalg_eigenvalues(H, _bse_singlet_energies, _bse_singlet_coefficients , _bse_nmax );
+      VectorXT eigenvalues;
+      MatrixXT eigenvectors;
+      tools::linalg_eigenvalues(H, eigenvalues, eigenvectors, _bse_nmax);
+      energies = eigenvalues.template cast<real_gwbse>();
+      coefficients = eigenvectors.template cast<real_gwbse>();
       return;
     }
     
@@ -67,7 +101,80 @@ namespace votca {
   }
     
 
+    void BSE::Solve_Davidson(const BSEOperator& H, VectorXfd& energies, MatrixXfd& coefficients) {
+      DavidsonSolver ds;
+      ds.setTolerance(_davidson_tolerance);
+      ds.setMaxIterations(_davidson_maxiter);
+      ds.solve(H, _bse_nmax);
+      if (ds.Info()) {
+        CTP_LOG(ctp::logDEBUG, *_log)
+          << ctp::TimeStamp() << " Davidson converged after " << ds.NumIterations()
+          << " iterations, max residue " << ds.residues().maxCoeff() << flush;
+      } else {
+        CTP_LOG(ctp::logDEBUG, *_log)
+          << ctp::TimeStamp() << " WARNING: Davidson not converged after " << ds.NumIterations()
+          << " iterations, max residue " << ds.residues().maxCoeff() << flush;
+      }
+#if (GWBSE_DOUBLE)
+      energies = ds.eigenvalues();
+      coefficients = ds.eigenvectors();
+#else
+      energies = ds.eigenvalues().cast<float>();
+      coefficients = ds.eigenvectors().cast<float>();
+#endif
+      return;
+    }
+
+    void BSE::Solve_singlets_BTDA_Davidson() {
+      // (A-B)(A+B)(X+Y) = Omega^2 (X+Y), X-Y = (A+B)(X+Y)/Omega
+      BSEOperator ApB = getOperator(4.0, 1.0);
+      BSEOperator AmB = getOperator(0.0, -1.0);
+      SquaredOperator M(ApB, AmB);
+      CTP_LOG(ctp::logDEBUG, *_log)
+        << ctp::TimeStamp() << " Davidson solver for first "<<_bse_nmax<<" eigenvectors of (A-B)(A+B)"<< flush;
+      DavidsonSolver ds;
+      ds.setMatrixType(DavidsonSolver::NONSYMMETRIC);
+      ds.setTolerance(_davidson_tolerance);
+      ds.setMaxIterations(_davidson_maxiter);
+      ds.solve(M, _bse_nmax);
+      if (ds.Info()) {
+        CTP_LOG(ctp::logDEBUG, *_log)
+          << ctp::TimeStamp() << " Davidson converged after " << ds.NumIterations()
+          << " iterations, max residue " << ds.residues().maxCoeff() << flush;
+      } else {
+        CTP_LOG(ctp::logDEBUG, *_log)
+          << ctp::TimeStamp() << " WARNING: Davidson not converged after " << ds.NumIterations()
+          << " iterations, max residue " << ds.residues().maxCoeff() << flush;
+      }
+      const Eigen::MatrixXd& XpY = ds.eigenvectors();
+      Eigen::MatrixXd ApB_XpY = ApB.matmul(XpY);
+      Eigen::VectorXd omega = ds.eigenvalues().cwiseSqrt();
+      int dim = XpY.rows();
+      _bse_singlet_energies.resize(_bse_nmax);
+      _bse_singlet_coefficients.resize(dim, _bse_nmax);
+      _bse_singlet_coefficients_AR.resize(dim, _bse_nmax);
+      for (int level = 0; level < _bse_nmax; level++) {
+        Eigen::VectorXd XmY = ApB_XpY.col(level) / omega(level);
+        // normalisation X^TX-Y^TY=(X+Y)^T(X-Y)=1
+        double norm = 1.0 / std::sqrt(XpY.col(level).dot(XmY));
+#if (GWBSE_DOUBLE)
+        _bse_singlet_energies(level) = omega(level);
+        _bse_singlet_coefficients.col(level) = 0.5 * norm * (XpY.col(level) + XmY);
+        _bse_singlet_coefficients_AR.col(level) = 0.5 * norm * (XpY.col(level) - XmY);
+#else
+        _bse_singlet_energies(level) = float(omega(level));
+        _bse_singlet_coefficients.col(level) = (0.5 * norm * (XpY.col(level) + XmY)).cast<float>();
+        _bse_singlet_coefficients_AR.col(level) = (0.5 * norm * (XpY.col(level) - XmY)).cast<float>();
+#endif
+      }
+      return;
+    }
+
     void BSE::Solve_singlets_BTDA() {
+      if (_use_davidson) {
+        Solve_singlets_BTDA_Davidson();
+        return;
+      }
 
       // For details of the method, see EPL,78(2007)12001,
       // Nuclear Physics A146(1970)449, Nuclear Physics A163(1971)257.
@@ -129,7 +236,8 @@ namespace votca {
       _bse_singlet_energies = eigenvalues.cast<float>(); 
 #endif
       // reconstruct real eigenvectors X_l = 1/2 [sqrt(eps_l) (L^T)^-1 + 1/sqrt(eps_l)L ] R_l
-      //                               Y_l = 1/2 [sqrt(eps_l) (L^T)^-1 - 1/sqrt(eps_l)L ] R_l
+      //                               Y_l = 1/2 [1/sqrt(eps_l)L - sqrt(eps_l) (L^T)^-1 ] R_l
+      // so that X+Y = L R_l/sqrt(eps_l) solves (A-B)(A+B)(X+Y) = eps_l^2 (X+Y)
       // determine inverse of L^T
      Eigen::MatrixXd LmT = AmB.inverse().transpose();
       int dim = LmT.rows();
@@ -142,10 +250,10 @@ namespace votca {
         // get l-th reduced EV
 #if (GWBSE_DOUBLE)
         _bse_singlet_coefficients.col(level) = (0.5 / sqrt_eval * (_bse_singlet_energies(level) * LmT + AmB) * eigenvectors.col(level));
-        _bse_singlet_coefficients_AR.col(level) = (0.5 / sqrt_eval * (_bse_singlet_energies(level) * LmT - AmB) * eigenvectors.col(level));
+        _bse_singlet_coefficients_AR.col(level) = (0.5 / sqrt_eval * (AmB - _bse_singlet_energies(level) * LmT) * eigenvectors.col(level));
 #else
         _bse_singlet_coefficients.col(level) = (0.5 / sqrt_eval * (_bse_singlet_energies(level) * LmT + AmB) * eigenvectors.col(level)).cast<float>();
-        _bse_singlet_coefficients_AR.col(level) = (0.5 / sqrt_eval * (_bse_singlet_energies(level) * LmT - AmB) * eigenvectors.col(level)).cast<float>();
+        _bse_singlet_coefficients_AR.col(level) = (0.5 / sqrt_eval * (AmB - _bse_singlet_energies(level) * LmT) * eigenvectors.col(level)).cast<float>();
 #endif
 
       }
@@ -183,158 +291,110 @@ template <typename T>
       return;
     }
 
+    int BSE::TileSize(int width1, int width2, int bytes) const {
+      // largest t with bytes*(aux*t*(width1+width2)+t^2*width1*width2) <= budget,
+      // i.e. two gathered slices of the 3-center integrals and their product
+      double a = double(width1) * double(width2);
+      double b = double(_Mmn->getAuxDimension()) * double(width1 + width2);
+      double budget = _tile_memory / double(bytes);
+      int tile = int((std::sqrt(b * b + 4.0 * a * budget) - b) / (2.0 * a));
+      return std::max(tile, 1);
+    }
+
 template <typename T>
     void BSE::Add_Hd(Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& H) {
-      // gwbasis size
-      int auxsize = _Mmn->getAuxDimension();
-      int vxv_size=_bse_vtotal * _bse_vtotal;
-      int cxc_size=_bse_ctotal * _bse_ctotal;
-      
-      // messy procedure, first get two matrices for occ and empty subbparts
-      // store occs directly transposed
-      MatrixXfd storage_v = MatrixXfd::Zero(auxsize, vxv_size);
-#pragma omp parallel for
-      for (int v1 = 0; v1 < _bse_vtotal; v1++) {
-        const MatrixXfd& Mmn = (*_Mmn)[v1 + _bse_vmin ];
-        for (int i_gw = 0; i_gw < auxsize; i_gw++) {
-          for (int v2 = 0; v2 < _bse_vtotal; v2++) {
-            int index_vv = _bse_vtotal * v1 + v2;         
-              storage_v(i_gw,index_vv) = Mmn( v2 + _bse_vmin,i_gw);
-            }
-        }
-      }
-
-      MatrixXfd storage_c = MatrixXfd::Zero(auxsize,cxc_size);
+      // H(v1c1,v2c2) -= sum_P M_v1v2^P (1-w_P) M_c1c2^P
+      // assembled in tiles of c1 x v1, the cc and vv slices of Mmn are only
+      // gathered for the current tile, so memory is bounded by _tile_memory
+      typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixXT;
+      const int auxsize = _Mmn->getAuxDimension();
+      const Eigen::Matrix<T, Eigen::Dynamic, 1> weights = _ppm->getScreenedWeights().cast<T>();
+      const int tile = TileSize(_bse_ctotal, _bse_vtotal, sizeof(T));
+      const int ctile = std::min(tile, _bse_ctotal);
+      const int vtile = std::min(tile, _bse_vtotal);
+
+      for (int c1a = 0; c1a < _bse_ctotal; c1a += ctile) {
+        const int nc = std::min(ctile, _bse_ctotal - c1a);
+        // columns (c1,c2) hold M_c1c2^P
+        MatrixXT storage_c(auxsize, nc * _bse_ctotal);
 #pragma omp parallel for
-      for (int c1 = 0; c1 < _bse_ctotal; c1++) {
-        const MatrixXfd& Mmn = (*_Mmn)[c1 + _bse_cmin];
-        for (int i_gw = 0; i_gw < auxsize; i_gw++) {
-          for (int c2 = 0; c2 < _bse_ctotal; c2++) {
-            int index_cc = _bse_ctotal * c1 + c2;
-            storage_c(i_gw, index_cc) = Mmn( c2 + _bse_cmin,i_gw);
-          }
+        for (int c1 = 0; c1 < nc; c1++) {
+          const Eigen::Map<const MatrixXfd> Mmn = (*_Mmn)[c1 + c1a + _bse_cmin];
+          storage_c.middleCols(c1 * _bse_ctotal, _bse_ctotal) =
+                  Mmn.block(_bse_cmin, 0, _bse_ctotal, auxsize).transpose().template cast<T>();
         }
-      }
-
-      // store elements in a vtotal^2 x ctotal^2 matrix
-      MatrixXfd storage_prod = storage_v.transpose() *storage_c;
-
-      // now patch up _storage for screened interaction
+        for (int v1a = 0; v1a < _bse_vtotal; v1a += vtile) {
+          const int nv = std::min(vtile, _bse_vtotal - v1a);
+          // columns (v1,v2) hold (1-w_P) M_v1v2^P
+          MatrixXT storage_v(auxsize, nv * _bse_vtotal);
 #pragma omp parallel for
-      for (int i_gw = 0; i_gw < auxsize; i_gw++) {
-        if (_ppm->getPpm_weight()(i_gw) < 1.e-9) {
-          for (int v = 0; v < vxv_size; v++) {
-            storage_v(i_gw,v ) = 0;
-          }
-          for (int c = 0; c < cxc_size; c++) {
-            storage_c(i_gw, c) = 0;
-          }
-        } else {
-          double ppm_factor = sqrt(_ppm->getPpm_weight()(i_gw));
-          for (int v = 0; v < vxv_size; v++) {
-            storage_v(i_gw,v ) *= ppm_factor;
-          }
-          for (int c = 0; c < cxc_size; c++) {
-            storage_c(i_gw, c) *= ppm_factor;
+          for (int v1 = 0; v1 < nv; v1++) {
+            const Eigen::Map<const MatrixXfd> Mmn = (*_Mmn)[v1 + v1a + _bse_vmin];
+            storage_v.middleCols(v1 * _bse_vtotal, _bse_vtotal) =
+                    Mmn.block(_bse_vmin, 0, _bse_vtotal, auxsize).transpose().template cast<T>();
           }
-        }
-      }
-
-      // multiply and subtract from _storage_prod
-      storage_prod -= storage_v.transpose()*storage_c;
-      // free storage_v and storage_c
-      storage_c.resize(0, 0);
-      storage_v.resize(0, 0);
-      // finally resort into _eh_d
-      
+          storage_v.array().colwise() *= weights.array();
+          // rows (c1,c2), columns (v1,v2)
+          const MatrixXT storage_prod = storage_c.transpose() * storage_v;
+          // H_d is symmetric, so column v1c1 is filled instead of the row,
+          // its elements v2c2 are contiguous segments over c2
 #pragma omp parallel for
-      for (int v1 = 0; v1 < _bse_vtotal; v1++) {
-        for (int v2 = 0; v2 < _bse_vtotal; v2++) {
-          int index_vv = _bse_vtotal * v1 + v2;
-          for (int c1 = 0; c1 < _bse_ctotal; c1++) {
-            int index_vc1 = _bse_ctotal * v1 + c1;
-            for (int c2 = 0; c2 < _bse_ctotal; c2++) {
-              int index_vc2 = _bse_ctotal * v2 + c2;
-              int index_cc = _bse_ctotal * c1 + c2;
-              H(index_vc1, index_vc2) -= storage_prod(index_vv, index_cc);
+          for (int v1 = 0; v1 < nv; v1++) {
+            for (int c1 = 0; c1 < nc; c1++) {
+              const int index_vc1 = _bse_ctotal * (v1 + v1a) + c1 + c1a;
+              for (int v2 = 0; v2 < _bse_vtotal; v2++) {
+                H.col(index_vc1).segment(_bse_ctotal * v2, _bse_ctotal) -=
+                        storage_prod.col(_bse_vtotal * v1 + v2).segment(_bse_ctotal * c1, _bse_ctotal);
+              }
             }
           }
         }
       }
-
       return;
     }
 template <typename T>
     void BSE::Add_Hd2(Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& H, double factor) {
-      // gwbasis size
-      int auxsize = _Mmn->getAuxDimension();
-      int bse_vxc_total=_bse_vtotal * _bse_ctotal;
-      // messy procedure, first get two matrices for occ and empty subbparts
-      // store occs directly transposed
-      MatrixXfd storage_cv = MatrixXfd::Zero(auxsize,bse_vxc_total);
-#pragma omp parallel for
-      for (int c1 = 0; c1 < _bse_ctotal; c1++) {
-        const MatrixXfd& Mmn = (*_Mmn)[c1 + _bse_cmin ];
-        for (int i_gw = 0; i_gw < auxsize; i_gw++) {
-          for (int v2 = 0; v2 < _bse_vtotal; v2++) {
-            int index_cv = _bse_vtotal * c1 + v2;
-            storage_cv(i_gw,index_cv ) = Mmn( v2 + _bse_vmin,i_gw);
-          }
-        }
-      }
-
-      MatrixXfd storage_vc = MatrixXfd::Zero(auxsize, bse_vxc_total);
+      // H(v1c1,v2c2) -= factor * sum_P M_v1c2^P (1-w_P) M_c1v2^P
+      // assembled in tiles of v1 x c1 as Add_Hd
+      typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixXT;
+      const int auxsize = _Mmn->getAuxDimension();
+      const Eigen::Matrix<T, Eigen::Dynamic, 1> weights = _ppm->getScreenedWeights().cast<T>();
+      const int tile = TileSize(_bse_ctotal, _bse_vtotal, sizeof(T));
+      const int ctile = std::min(tile, _bse_ctotal);
+      const int vtile = std::min(tile, _bse_vtotal);
+
+      for (int v1a = 0; v1a < _bse_vtotal; v1a += vtile) {
+        const int nv = std::min(vtile, _bse_vtotal - v1a);
+        // columns (v1,c2) hold M_v1c2^P
+        MatrixXT storage_vc(auxsize, nv * _bse_ctotal);
 #pragma omp parallel for
-      for (int v1 = 0; v1 < _bse_vtotal; v1++) {
-        const MatrixXfd& Mmn = (*_Mmn)[v1 + _bse_vmin];
-        for (int i_gw = 0; i_gw < auxsize; i_gw++) {
-          for (int c2 = 0; c2 < _bse_ctotal; c2++) {
-            int index_vc = _bse_ctotal * v1 + c2;
-            storage_vc(i_gw, index_vc) = Mmn(c2 + _bse_cmin,i_gw);
-          }
+        for (int v1 = 0; v1 < nv; v1++) {
+          const Eigen::Map<const MatrixXfd> Mmn = (*_Mmn)[v1 + v1a + _bse_vmin];
+          storage_vc.middleCols(v1 * _bse_ctotal, _bse_ctotal) =
+                  Mmn.block(_bse_cmin, 0, _bse_ctotal, auxsize).transpose().template cast<T>();
         }
-      }
-
-      // store elements in a vtotal^2 x ctotal^2 matrix
-      MatrixXfd storage_prod = storage_cv.transpose()* storage_vc;
-
-      // now patch up _storage for screened interaction
+        for (int c1a = 0; c1a < _bse_ctotal; c1a += ctile) {
+          const int nc = std::min(ctile, _bse_ctotal - c1a);
+          // columns (c1,v2) hold (1-w_P) M_c1v2^P
+          MatrixXT storage_cv(auxsize, nc * _bse_vtotal);
 #pragma omp parallel for
-      for (int i_gw = 0; i_gw < auxsize; i_gw++) {
-        if (_ppm->getPpm_weight()(i_gw) < 1.e-9) {
-          for (int v = 0; v < bse_vxc_total; v++) {
-            storage_vc(i_gw, v) = 0;
-          }
-          for (int c = 0; c < bse_vxc_total; c++) {
-            storage_cv(i_gw,c ) = 0;
-          }
-        } else {
-          double ppm_factor = sqrt(_ppm->getPpm_weight()(i_gw));
-          for (int v = 0; v < bse_vxc_total; v++) {
-            storage_vc(i_gw, v) *= ppm_factor;
-          }
-          for (int c = 0; c < bse_vxc_total; c++) {
-            storage_cv(i_gw,c ) *= ppm_factor;
+          for (int c1 = 0; c1 < nc; c1++) {
+            const Eigen::Map<const MatrixXfd> Mmn = (*_Mmn)[c1 + c1a + _bse_cmin];
+            storage_cv.middleCols(c1 * _bse_vtotal, _bse_vtotal) =
+                    Mmn.block(_bse_vmin, 0, _bse_vtotal, auxsize).transpose().template cast<T>();
           }
-        }
-      }
-
-      // multiply and subtract from _storage_prod
-      storage_prod -= storage_cv.transpose() * storage_vc;
-      // free storage_v and storage_c
-      storage_cv.resize(0, 0);
-      storage_vc.resize(0, 0);
-  
+          storage_cv.array().colwise() *= weights.array();
+          // rows (v1,c2), columns (c1,v2)
+          const MatrixXT storage_prod = T(factor) * (storage_vc.transpose() * storage_cv);
+          // H_d2 is symmetric as well, fill column v1c1
 #pragma omp parallel for
-      for (int v1 = 0; v1 < _bse_vtotal; v1++) {
-        for (int v2 = 0; v2 < _bse_vtotal; v2++) {
-          for (int c1 = 0; c1 < _bse_ctotal; c1++) {
-            int index_v1c1 = _bse_ctotal * v1 + c1;
-            int index_c1v2 = _bse_vtotal * c1 + v2;
-            for (int c2 = 0; c2 < _bse_ctotal; c2++) {
-              int index_v2c2 = _bse_ctotal * v2 + c2;
-              int index_v1c2 = _bse_ctotal * v1 + c2;
-              H(index_v1c1, index_v2c2) -= factor*storage_prod(index_c1v2, index_v1c2);
+          for (int v1 = 0; v1 < nv; v1++) {
+            for (int c1 = 0; c1 < nc; c1++) {
+              const int index_vc1 = _bse_ctotal * (v1 + v1a) + c1 + c1a;
+              for (int v2 = 0; v2 < _bse_vtotal; v2++) {
+                H.col(index_vc1).segment(_bse_ctotal * v2, _bse_ctotal) -=
+                        storage_prod.col(_bse_vtotal * c1 + v2).segment(_bse_ctotal * v1, _bse_ctotal);
+              }
             }
           }
         }
@@ -343,28 +403,49 @@ template <typename T>
     }
 
 template <typename T>
-    void BSE::Add_Hx(Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& H, double factor) { 
-      // gwbasis size
-      int auxsize = _Mmn->getAuxDimension();
-      // get a different storage for 3-center integrals we need
-      Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> storage = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(auxsize, _bse_size);
-      // occupied levels
+    void BSE::Add_Hx(Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& H, double factor) {
+      // H(v1c1,v2c2) += factor * sum_P M_v1c1^P M_v2c2^P
+      // the vc slices of Mmn are gathered per tile of v, only the upper
+      // tiles are multiplied and mirrored into the lower triangle
+      typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixXT;
+      const int auxsize = _Mmn->getAuxDimension();
+      const int vtile = std::min(TileSize(_bse_ctotal, _bse_ctotal, sizeof(T)), _bse_vtotal);
+      auto gather = [&](int va, int nv) -> MatrixXT {
+        // columns (v,c) hold M_vc^P
+        MatrixXT storage(auxsize, nv * _bse_ctotal);
 #pragma omp parallel for
-      for (int v = 0; v < _bse_vtotal; v++) {
-        const MatrixXfd& Mmn = (*_Mmn)[v + _bse_vmin];
-        // empty levels
-        for (int i_gw = 0; i_gw < auxsize; i_gw++) {
-          for (int c = 0; c < _bse_ctotal; c++) {
-            int index_vc = _bse_ctotal * v + c;
-            storage(i_gw, index_vc) = Mmn(c + _bse_cmin,i_gw);
+        for (int v = 0; v < nv; v++) {
+          const Eigen::Map<const MatrixXfd> Mmn = (*_Mmn)[v + va + _bse_vmin];
+          storage.middleCols(v * _bse_ctotal, _bse_ctotal) =
+                  Mmn.block(_bse_cmin, 0, _bse_ctotal, auxsize).transpose().template cast<T>();
+        }
+        return storage;
+      };
+
+      for (int v1a = 0; v1a < _bse_vtotal; v1a += vtile) {
+        const int nv1 = std::min(vtile, _bse_vtotal - v1a);
+        const MatrixXT storage1 = gather(v1a, nv1);
+        for (int v2a = v1a; v2a < _bse_vtotal; v2a += vtile) {
+          const int nv2 = std::min(vtile, _bse_vtotal - v2a);
+          const MatrixXT prod = (v2a == v1a) ? MatrixXT(storage1.transpose() * storage1)
+                  : MatrixXT(storage1.transpose() * gather(v2a, nv2));
+          H.block(_bse_ctotal * v1a, _bse_ctotal * v2a, nv1 * _bse_ctotal, nv2 * _bse_ctotal) += T(factor) * prod;
+          if (v2a != v1a) {
+            H.block(_bse_ctotal * v2a, _bse_ctotal * v1a, nv2 * _bse_ctotal, nv1 * _bse_ctotal) += T(factor) * prod.transpose();
           }
         }
       }
-      // with this storage, _eh_x is obtained by matrix multiplication
-      H += factor*storage.transpose() * storage;
       return;
     }
 
+    BSEOperator BSE::getOperator(double x_factor, double d2_factor) const {
+      BSEOperator H(*_Mmn, *_ppm, *_Hqp);
+      H.setBSEindices(_bse_vmin, _bse_vmax, _bse_cmin, _bse_cmax);
+      H.setFactors(x_factor, d2_factor);
+      H.setDoublePrecision(_double_operator);
+      return H;
+    }
+
     void BSE::printFragInfo(const Population& pop, int i){
       CTP_LOG(ctp::logINFO, *_log) << format("           Fragment A -- hole: %1$5.1f%%  electron: %2$5.1f%%  dQ: %3$+5.2f  Qeff: %4$+5.2f")
               % (100.0 * pop.popH[i](0)) % (100.0 * pop.popE[i](0)) % (pop.Crgs[i](0)) % (pop.Crgs[i](0) + pop.popGs(0)) << flush;
@@ -536,19 +617,25 @@ template <typename T>
         Eigen::VectorXd pops = _orbitals.LoewdinPopulation(DMAT, dftoverlap.Matrix(), dftbasis.getAOBasisFragA());
         pop.popGs=nuccharges - pops;
         // population to electron charges and add nuclear charges         
-        for (int i_state = 0; i_state < _bse_nmax; i_state++) {
-          QMState state=QMState(type,i_state,false);
-          // checking Density Matrices
-          std::vector< Eigen::MatrixXd > DMAT = _orbitals.DensityMatrixExcitedState(state);
-          // hole part
-          Eigen::VectorXd popsH = _orbitals.LoewdinPopulation(DMAT[0], dftoverlap.Matrix(), dftbasis.getAOBasisFragA());
-          pop.popH.push_back(popsH);
-          // electron part
-          Eigen::VectorXd popsE = _orbitals.LoewdinPopulation(DMAT[1], dftoverlap.Matrix(), dftbasis.getAOBasisFragA());
-          pop.popE.push_back(popsE);
-          // update effective charges
-          Eigen::VectorXd diff = popsH - popsE;
-          pop.Crgs.push_back(diff);
+        // density matrices in batches of states, each batch keeps 2 AO matrices per state
+        const int batchsize = 32;
+        for (int first = 0; first < _bse_nmax; first += batchsize) {
+          std::vector<QMState> states;
+          for (int i_state = first; i_state < std::min(first + batchsize, _bse_nmax); i_state++) {
+            states.push_back(QMState(type,i_state,false));
+          }
+          std::vector< std::vector<Eigen::MatrixXd> > DMATS = _orbitals.DensityMatricesExcitedStates(states);
+          for (const std::vector<Eigen::MatrixXd>& DMAT : DMATS) {
+            // hole part
+            Eigen::VectorXd popsH = _orbitals.LoewdinPopulation(DMAT[0], dftoverlap.Matrix(), dftbasis.getAOBasisFragA());
+            pop.popH.push_back(popsH);
+            // electron part
+            Eigen::VectorXd popsE = _orbitals.LoewdinPopulation(DMAT[1], dftoverlap.Matrix(), dftbasis.getAOBasisFragA());
+            pop.popE.push_back(popsE);
+            // update effective charges
+            Eigen::VectorXd diff = popsH - popsE;
+            pop.Crgs.push_back(diff);
+          }
         }
         CTP_LOG(ctp::logDEBUG, *_log) << ctp::TimeStamp() << " Ran Excitation fragment population analysis " << flush;
      
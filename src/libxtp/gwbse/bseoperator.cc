@@ -0,0 +1,174 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <votca/xtp/bseoperator.h>
+#include <algorithm>
+
+namespace votca {
+  namespace xtp {
+
+    Eigen::MatrixXd BSEOperator::matmul(const Eigen::MatrixXd& X)const{
+      if (_double_precision) {
+        return Apply<double>(X);
+      }
+      return Apply<float>(X);
+    }
+
+    template <typename T>
+    Eigen::MatrixXd BSEOperator::Apply(const Eigen::MatrixXd& X)const{
+      const MatrixX<T> Xt = X.cast<T>();
+      MatrixX<T> Y = Hqp_times<T>(Xt);
+      Y += Hd_times<T>(Xt);
+      if (_x_factor != 0.0) {
+        Y += T(_x_factor) * Hx_times<T>(Xt);
+      }
+      if (_d2_factor != 0.0) {
+        Y += T(_d2_factor) * Hd2_times<T>(Xt);
+      }
+      return Y.template cast<double>();
+    }
+
+    Eigen::VectorXd BSEOperator::diagonal()const{
+      const int auxsize = _Mmn.getAuxDimension();
+      const VectorXfd weights = _ppm.getScreenedWeights().cast<real_gwbse>();
+      Eigen::VectorXd diag = Eigen::VectorXd::Zero(_bse_size);
+#pragma omp parallel for
+      for (int v = 0; v < _bse_vtotal; v++) {
+        const MatrixXfd Mvc = _Mmn[v + _bse_vmin].block(_bse_cmin, 0, _bse_ctotal, auxsize);
+        const VectorXfd Mvv_w = _Mmn[v + _bse_vmin].row(v + _bse_vmin).transpose().cwiseProduct(weights);
+        for (int c = 0; c < _bse_ctotal; c++) {
+          int index_vc = _bse_ctotal * v + c;
+          double value = _Hqp(c + _bse_vtotal, c + _bse_vtotal) - _Hqp(v, v);
+          value -= Mvv_w.dot(_Mmn[c + _bse_cmin].row(c + _bse_cmin).transpose());
+          double Mvc2 = Mvc.row(c).squaredNorm();
+          double Mvc2_w = Mvc.row(c).cwiseAbs2().dot(weights.transpose());
+          value += _x_factor * Mvc2 - _d2_factor * Mvc2_w;
+          diag(index_vc) = value;
+        }
+      }
+      return diag;
+    }
+
+    MatrixXfd BSEOperator::Dense()const{
+      const int blocksize = 256;
+      MatrixXfd H = MatrixXfd::Zero(_bse_size, _bse_size);
+      for (int start = 0; start < _bse_size; start += blocksize) {
+        int cols = std::min(blocksize, _bse_size - start);
+        Eigen::MatrixXd unit = Eigen::MatrixXd::Zero(_bse_size, cols);
+        unit.block(start, 0, cols, cols) = Eigen::MatrixXd::Identity(cols, cols);
+        H.middleCols(start, cols) = matmul(unit).cast<real_gwbse>();
+      }
+      return H;
+    }
+
+    /*
+     * Products of the BSE Hamiltonian contributions with a block of trial
+     * vectors X (bse_size x k). Column i of X reshaped to ctotal x vtotal
+     * gives the coefficient of the product function v,c. The kernels run in
+     * precision T, slices of the three-center integrals are converted on use.
+     */
+    template <typename T>
+    BSEOperator::MatrixX<T> BSEOperator::Hqp_times(const MatrixX<T>& X)const{
+      const MatrixX<T> Hvv = _Hqp.topLeftCorner(_bse_vtotal, _bse_vtotal).cast<T>();
+      const MatrixX<T> Hcc = _Hqp.block(_bse_vtotal, _bse_vtotal, _bse_ctotal, _bse_ctotal).cast<T>();
+      MatrixX<T> Y = MatrixX<T>::Zero(X.rows(), X.cols());
+      for (int i = 0; i < X.cols(); i++) {
+        Eigen::Map<const MatrixX<T> > x(X.col(i).data(), _bse_ctotal, _bse_vtotal);
+        Eigen::Map<MatrixX<T> > y(Y.col(i).data(), _bse_ctotal, _bse_vtotal);
+        y.noalias() = Hcc * x;
+        y.noalias() -= x * Hvv;
+      }
+      return Y;
+    }
+
+    template <typename T>
+    BSEOperator::MatrixX<T> BSEOperator::Hx_times(const MatrixX<T>& X)const{
+      const int auxsize = _Mmn.getAuxDimension();
+      MatrixX<T> R = MatrixX<T>::Zero(auxsize, X.cols());
+      for (int v = 0; v < _bse_vtotal; v++) {
+        const MatrixX<T> Mvc = _Mmn[v + _bse_vmin].block(_bse_cmin, 0, _bse_ctotal, auxsize).template cast<T>();
+        R.noalias() += Mvc.transpose() * X.middleRows(_bse_ctotal * v, _bse_ctotal);
+      }
+      MatrixX<T> Y = MatrixX<T>::Zero(X.rows(), X.cols());
+#pragma omp parallel for
+      for (int v = 0; v < _bse_vtotal; v++) {
+        const MatrixX<T> Mvc = _Mmn[v + _bse_vmin].block(_bse_cmin, 0, _bse_ctotal, auxsize).template cast<T>();
+        Y.middleRows(_bse_ctotal * v, _bse_ctotal).noalias() = Mvc * R;
+      }
+      return Y;
+    }
+
+    template <typename T>
+    BSEOperator::MatrixX<T> BSEOperator::Hd_times(const MatrixX<T>& X)const{
+      const int auxsize = _Mmn.getAuxDimension();
+      const int k = X.cols();
+      const VectorX<T> weights = _ppm.getScreenedWeights().cast<T>();
+      // M_v1v2^P stored as vtotal x (aux*vtotal), small compared to a full H
+      MatrixX<T> Mvv(_bse_vtotal, auxsize * _bse_vtotal);
+      for (int v1 = 0; v1 < _bse_vtotal; v1++) {
+        const MatrixX<T> Mt = _Mmn[v1 + _bse_vmin].block(_bse_vmin, 0, _bse_vtotal, auxsize).transpose().template cast<T>();
+        Mvv.row(v1) = Eigen::Map<const VectorX<T> >(Mt.data(), Mt.size()).transpose();
+      }
+      Eigen::Map<const MatrixX<T> > Xall(X.data(), _bse_ctotal, _bse_vtotal * k);
+      MatrixX<T> Y = MatrixX<T>::Zero(X.rows(), k);
+#pragma omp parallel for
+      for (int c1 = 0; c1 < _bse_ctotal; c1++) {
+        // Z(P,v2) = sum_c2 M_c1c2^P X(c2,v2) for all trial vectors at once
+        const MatrixX<T> Mcc = _Mmn[c1 + _bse_cmin].block(_bse_cmin, 0, _bse_ctotal, auxsize).template cast<T>();
+        MatrixX<T> Z = Mcc.transpose() * Xall;
+        Z.array().colwise() *= weights.array();
+        Eigen::Map<const MatrixX<T> > Zmap(Z.data(), auxsize * _bse_vtotal, k);
+        const MatrixX<T> result = Mvv * Zmap;
+        for (int v1 = 0; v1 < _bse_vtotal; v1++) {
+          Y.row(_bse_ctotal * v1 + c1) -= result.row(v1);
+        }
+      }
+      return Y;
+    }
+
+    template <typename T>
+    BSEOperator::MatrixX<T> BSEOperator::Hd2_times(const MatrixX<T>& X)const{
+      // uses M_c1v2^P=M_v2c1^P, so only the vc slices of Mmn are needed
+      const int auxsize = _Mmn.getAuxDimension();
+      const int k = X.cols();
+      const VectorX<T> weights = _ppm.getScreenedWeights().cast<T>();
+      std::vector<MatrixX<T> > Mvc(_bse_vtotal);
+      for (int v = 0; v < _bse_vtotal; v++) {
+        Mvc[v] = _Mmn[v + _bse_vmin].block(_bse_cmin, 0, _bse_ctotal, auxsize).template cast<T>();
+      }
+      Eigen::Map<const MatrixX<T> > Xall(X.data(), _bse_ctotal, _bse_vtotal * k);
+      MatrixX<T> Y = MatrixX<T>::Zero(X.rows(), k);
+#pragma omp parallel for
+      for (int v1 = 0; v1 < _bse_vtotal; v1++) {
+        MatrixX<T> Q = Mvc[v1].transpose() * Xall;
+        Q.array().colwise() *= weights.array();
+        MatrixX<T> result = MatrixX<T>::Zero(_bse_ctotal, k);
+        for (int v2 = 0; v2 < _bse_vtotal; v2++) {
+          Eigen::Map<const MatrixX<T>, 0, Eigen::OuterStride<> > Qv2(Q.data() + auxsize * v2,
+                  auxsize, k, Eigen::OuterStride<>(auxsize * _bse_vtotal));
+          result.noalias() += Mvc[v2] * Qv2;
+        }
+        Y.middleRows(_bse_ctotal * v1, _bse_ctotal) -= result;
+      }
+      return Y;
+    }
+
+  }
+}
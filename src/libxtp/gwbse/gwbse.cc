@@ -21,6 +21,7 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
+#include <chrono>
 #include <votca/ctp/logger.h>
 #include <votca/tools/constants.h>
 #include <votca/xtp/gwbse.h>
@@ -98,9 +99,6 @@ std::string ranges = options.ifExistsReturnElseReturnDefault<std::string>(key +
 
   _homo = _orbitals.getNumberOfElectrons() - 1;  // indexed from 0
 
- _reset_3c=options.ifExistsReturnElseReturnDefault<int>(
-      key + ".rebuild_threecenter_freq", 5);
-
   _rpamin = 0;  // lowest index occ min(gwa%mmin, screening%nsum_low) ! always 1
   if (ranges == "default" || ranges == "full") {
     _rpamax = _orbitals.getNumberOfLevels() - 1;  // total number of levels
@@ -241,9 +239,65 @@ std::string ranges = options.ifExistsReturnElseReturnDefault<std::string>(key +
     CTP_LOG(ctp::logDEBUG, *_pLog) << " BSE type: TDA" << flush;
   }
 
+  _do_davidson = false;
+  _davidson_tolerance = 1e-5;
+  _davidson_maxiter = 50;
+  if (options.exists(key + ".eigensolver")) {
+    _do_davidson = options.ifExistsReturnElseReturnDefault<bool>(
+        key + ".eigensolver.dodavidson", false);
+    _davidson_tolerance = options.ifExistsReturnElseReturnDefault<double>(
+        key + ".eigensolver.tolerance", _davidson_tolerance);
+    _davidson_maxiter = options.ifExistsReturnElseReturnDefault<int>(
+        key + ".eigensolver.maxiterations", _davidson_maxiter);
+  }
+  if (_do_davidson) {
+    CTP_LOG(ctp::logDEBUG, *_pLog) << " BSE eigensolver: Davidson, tolerance "
+                                   << _davidson_tolerance << flush;
+  } else {
+    CTP_LOG(ctp::logDEBUG, *_pLog) << " BSE eigensolver: full diagonalisation"
+                                   << flush;
+  }
+
+  // compute precision of the BSE stages, the storage precision of Mmn and of
+  // the BSE results is fixed at compile time by GWBSE_DOUBLE
+  std::vector<std::string> precisions = {"single", "double"};
+  _bse_double = (sizeof(real_gwbse) == sizeof(double));
+  _davidson_double = _bse_double;
+  // an empty entry keeps the storage precision
+  std::string bse_precision = options.ifExistsReturnElseReturnDefault<std::string>(
+      key + ".precision.bse", "");
+  if (!bse_precision.empty()) {
+    _bse_double = (options.ifExistsAndinListReturnElseThrowRuntimeError<std::string>(
+        key + ".precision.bse", precisions) == "double");
+  }
+  std::string davidson_precision = options.ifExistsReturnElseReturnDefault<std::string>(
+      key + ".precision.davidson", "");
+  if (!davidson_precision.empty()) {
+    _davidson_double = (options.ifExistsAndinListReturnElseThrowRuntimeError<std::string>(
+        key + ".precision.davidson", precisions) == "double");
+  }
+  CTP_LOG(ctp::logDEBUG, *_pLog) << " BSE precision: Hamiltonian "
+          << (_bse_double ? "double" : "single") << ", Davidson products "
+          << (_davidson_double ? "double" : "single") << flush;
+
+  // memory in MB for the tiled setup of the dense BSE Hamiltonian
+  _bse_tilememory =
+      options.ifExistsReturnElseReturnDefault<double>(key + ".bse_tilememory", 256.0);
+
   _openmp_threads =
       options.ifExistsReturnElseReturnDefault<int>(key + ".openmp", 0);
 
+  // directory for a memory mapped file holding Mmn, empty keeps Mmn in RAM
+  _mmn_scratch =
+      options.ifExistsReturnElseReturnDefault<std::string>(key + ".mmn_scratch", "");
+
+  _do_auxtruncation = false;
+  _auxtruncation_tolerance = 1e-3;
+  if (options.exists(key + ".auxtruncation")) {
+    _do_auxtruncation = options.ifExistsReturnElseReturnDefault<bool>(key + ".auxtruncation.dotruncation", false);
+    _auxtruncation_tolerance = options.ifExistsReturnElseReturnDefault<double>(key + ".auxtruncation.tolerance", 1e-3);
+  }
+
   if (options.exists(key + ".vxc")) {
     _doVxc =
         options.ifExistsReturnElseThrowRuntimeError<bool>(key + ".vxc.dovxc");
@@ -370,6 +424,20 @@ std::string ranges = options.ifExistsReturnElseReturnDefault<std::string>(key +
   return;
 }
 
+BSEOperator GWBSE::getSingletOperator() const {
+  BSEOperator H(_Mmn, _ppm, _Hqp);
+  H.setBSEindices(_bse_vmin, _bse_vmax, _bse_cmin, _bse_cmax);
+  H.setFactors(2.0, 0.0);
+  return H;
+}
+
+BSEOperator GWBSE::getTripletOperator() const {
+  BSEOperator H(_Mmn, _ppm, _Hqp);
+  H.setBSEindices(_bse_vmin, _bse_vmax, _bse_cmin, _bse_cmax);
+  H.setFactors(0.0, 0.0);
+  return H;
+}
+
 void GWBSE::addoutput(tools::Property& summary) {
 
   const double hrt2ev = tools::conv::hrt2ev;
@@ -748,8 +816,14 @@ bool GWBSE::Evaluate() {
   // prepare 3-center integral object
 
   TCMatrix_gwbse Mmn;
+  std::string mmn_scratchfile = "";
+  if (!_mmn_scratch.empty()) {
+    mmn_scratchfile = (path(_mmn_scratch) / unique_path("xtp_mmn_%%%%-%%%%-%%%%.scratch")).string();
+    CTP_LOG(ctp::logDEBUG, *_pLog)
+        << ctp::TimeStamp() << " Storing Mmn in " << mmn_scratchfile << flush;
+  }
   //rpamin here, because RPA needs till rpamin
-  Mmn.Initialize(auxbasis.AOBasisSize(), _rpamin, _qpmax, _rpamin, _rpamax);
+  Mmn.Initialize(auxbasis.AOBasisSize(), _rpamin, _qpmax, _rpamin, _rpamax, mmn_scratchfile);
   Mmn.Fill(auxbasis, dftbasis, _orbitals.MOCoefficients());
   CTP_LOG(ctp::logDEBUG, *_pLog)
       << ctp::TimeStamp()
@@ -761,6 +835,14 @@ bool GWBSE::Evaluate() {
   CTP_LOG(ctp::logDEBUG, *_pLog)
       << ctp::TimeStamp()
       << " Multiplied Mmn_beta with Coulomb Matrix " << flush;
+
+  if (_do_auxtruncation) {
+    const int auxsize = Mmn.getAuxDimension();
+    Mmn.ReduceAuxDimension(Mmn.TruncatedAuxBasis(_auxtruncation_tolerance));
+    CTP_LOG(ctp::logDEBUG, *_pLog)
+        << ctp::TimeStamp() << " Reduced aux dimension of Mmn from " << auxsize
+        << " to " << Mmn.getAuxDimension() << flush;
+  }
   PPM ppm;
   RPA rpa;
   rpa.configure(_homo,_rpamin,_rpamax);
@@ -788,19 +870,36 @@ bool GWBSE::Evaluate() {
   sigma.setGWAEnergies(gwa_energies);
   
    /* for automatic iteration of both G and W, we need to
-   * - make a copy of _Mmn
+   * - keep a copy of Mmn in the Coulomb symmetrised basis
    * - calculate eps
    * - construct ppm
-   * - threecenters for sigma
+   * - threecenters for sigma, Mmn_sym * ppm_phi
    * - sigma_x
    * - sigma_c
    * - test for convergence
    *
+   * RPA always sees the unrotated Mmn_sym, so the PPM rotations do not
+   * accumulate and the threecenters never have to be recomputed.
+   * Without iteration Mmn is rotated in place.
    */
 
   if (!_iterate_gw) {
     _gw_sc_max_iterations = 1;
   }
+  TCMatrix_gwbse Mmn_sym;
+  if (_iterate_gw) {
+    Mmn_sym = std::move(Mmn);
+    std::string rotated_scratchfile = "";
+    if (!_mmn_scratch.empty()) {
+      rotated_scratchfile = (path(_mmn_scratch) / unique_path("xtp_mmn_%%%%-%%%%-%%%%.scratch")).string();
+    }
+    Mmn.Initialize(Mmn_sym.getAuxDimension(), _rpamin, _qpmax, _rpamin, _rpamax, rotated_scratchfile);
+  }
+  const TCMatrix_gwbse& Mmn_rpa = _iterate_gw ? Mmn_sym : Mmn;
+  typedef std::chrono::steady_clock Clock;
+  auto seconds = [](const Clock::time_point & start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  };
 
   const Eigen::VectorXd &dft_energies = _orbitals.MOEnergies();
   for (int gw_iteration = 0; gw_iteration < _gw_sc_max_iterations;
@@ -812,28 +911,39 @@ bool GWBSE::Evaluate() {
                                      << gw_iteration + 1 << " of "
                                      << _gw_sc_max_iterations << flush;
     }
-    
-    
-    if(gw_iteration%_reset_3c==0 && gw_iteration!=0){
-      CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp() << " Rebuilding Mmn_beta (3-center-repulsion x orbitals)" << flush;
-       Mmn.Fill(auxbasis, dftbasis, _orbitals.MOCoefficients());
-       Mmn.MultiplyRightWithAuxMatrix(Coulomb_sqrtInv);
-    }
+    const Clock::time_point iteration_start = Clock::now();
   
-    rpa.calculate_epsilon(gwa_energies,Mmn);
+    Clock::time_point start = Clock::now();
+    rpa.calculate_epsilon(gwa_energies,Mmn_rpa);
+    const double time_rpa = seconds(start);
     CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
                                    << " Calculated epsilon via RPA  " << flush;
+    start = Clock::now();
     ppm.PPM_construct_parameters(rpa);
+    const double time_ppm = seconds(start);
     CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
                                    << " Constructed PPM parameters  " << flush;
     
-    Mmn.MultiplyRightWithAuxMatrix(ppm.getPpm_phi());
+    start = Clock::now();
+    if (_iterate_gw) {
+      Mmn.MultiplyRightWithAuxMatrix(Mmn_sym, ppm.getPpm_phi());
+    } else {
+      Mmn.MultiplyRightWithAuxMatrix(ppm.getPpm_phi());
+    }
+    const double time_rotate = seconds(start);
     CTP_LOG(ctp::logDEBUG, *_pLog)
         << ctp::TimeStamp() << " Prepared threecenters for sigma  " << flush;
 
+    start = Clock::now();
     sigma.CalcdiagElements(Mmn,ppm);
+    const double time_sigma = seconds(start);
     CTP_LOG(ctp::logDEBUG, *_pLog)
         << ctp::TimeStamp() << " Calculated diagonal part of Sigma  " << flush;
+    CTP_LOG(ctp::logDEBUG, *_pLog)
+        << ctp::TimeStamp()
+        << (format(" GW iteration %1% timings [s]: RPA %2$.2f PPM %3$.2f Mmn*phi %4$.2f Sigma %5$.2f total %6$.2f")
+            % (gw_iteration + 1) % time_rpa % time_ppm % time_rotate % time_sigma % seconds(iteration_start)).str()
+        << flush;
     // iterative refinement of qp energies
     gwa_energies=sigma.getGWAEnergies();
     double _DFTgap = dft_energies(_homo + 1) - dft_energies(_homo);
@@ -888,6 +998,7 @@ bool GWBSE::Evaluate() {
      }
   }
    
+  Mmn_sym.Cleanup();
   ppm.FreeMatrix();
   rpa.FreeMatrices();
   CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
@@ -945,6 +1056,9 @@ bool GWBSE::Evaluate() {
       BSE bse=BSE(_orbitals,_pLog,_min_print_weight);
       bse.setBSEindices(_homo,_bse_vmin,_bse_cmax,_bse_maxeigenvectors);
       bse.setGWData(&Mmn,&ppm,&Hqp);
+      bse.configureDavidson(_do_davidson,_davidson_tolerance,_davidson_maxiter);
+      bse.configurePrecision(_bse_double,_davidson_double);
+      bse.setTileMemory(_bse_tilememory);
        // calculate direct part of eh interaction, needed for singlets and triplets
 
         if (_do_bse_triplets && _do_bse_diag) {
@@ -973,7 +1087,7 @@ bool GWBSE::Evaluate() {
                 bse.FreeSinglets();
             }
         }
-        if (_store_eh_interaction) {
+        if (_store_eh_interaction && !_keep_bse_data) {
             if (_do_bse_singlets) {
                 bse.SetupHs();
             }
@@ -982,6 +1096,13 @@ bool GWBSE::Evaluate() {
             }
         }
     }
+    if (_keep_bse_data) {
+      _Mmn = std::move(Mmn);
+      _ppm = std::move(ppm);
+      _Hqp = std::move(Hqp);
+      CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
+              << " Kept three-center integrals for matrix-free BSE Hamiltonian" << flush;
+    }
   }
   CTP_LOG(ctp::logDEBUG, *_pLog) << ctp::TimeStamp()
                                  << " GWBSE calculation finished " << flush;
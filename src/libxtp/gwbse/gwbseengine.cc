@@ -143,6 +143,9 @@ namespace votca {
                 GWBSE gwbse = GWBSE(orbitals);
                 gwbse.setLogger(logger);
                 gwbse.Initialize(_gwbse_options);
+                if (_threads > 0) {
+                    gwbse.setThreads(_threads);
+                }
                 gwbse.Evaluate();
                 gwbse.addoutput(output_summary);
             }
@@ -54,5 +54,16 @@ namespace votca {
             return;
         }
 
+        Eigen::VectorXd PPM::getScreenedWeights() const {
+            // ppm_weights below 1.e-9 do not screen at all
+            Eigen::VectorXd weights = Eigen::VectorXd::Ones(_ppm_weight.size());
+            for (int i_gw = 0; i_gw < _ppm_weight.size(); i_gw++) {
+                if (_ppm_weight(i_gw) >= 1.e-9) {
+                    weights(i_gw) -= _ppm_weight(i_gw);
+                }
+            }
+            return weights;
+        }
+
  
 }};
@@ -22,6 +22,7 @@
 #include <votca/xtp/rpa.h>
 #include <votca/xtp/aomatrix.h>
 #include "votca/xtp/threecenter.h"
+#include <algorithm>
 
 
 
@@ -40,46 +41,44 @@ const int size = Mmn_full.getAuxDimension(); // size of gwbasis
             int lumo=_homo+1;
             int n_occ=lumo-_rpamin;
             int n_unocc=_rpamax-_homo;
-            
-#pragma omp parallel for 
-            for (int m_level = 0; m_level < n_occ; m_level++) {
-                const double qp_energy_m = qp_energies(m_level + _rpamin);
+
+            // occupied levels are stacked into batches of (n_levels*n_unocc) x aux,
+            // so that each frequency needs one large GEMM per batch, which is
+            // threaded internally, instead of one small GEMM per level followed
+            // by a serialised update of epsilon. A batch has about the size of
+            // one epsilon matrix.
+            const int batch_levels = std::min(n_occ, std::max(1, size / std::max(1, n_unocc)));
+            for (int m_start = 0; m_start < n_occ; m_start += batch_levels) {
+                const int n_levels = std::min(batch_levels, n_occ - m_start);
+                const int rows = n_levels * n_unocc;
+                Eigen::MatrixXd Mmn_RPA(rows, size);
+                Eigen::VectorXd deltaE(rows);
+#pragma omp parallel for
+                for (int m = 0; m < n_levels; m++) {
+                    const int m_level = m_start + m;
 #if (GWBSE_DOUBLE)
-                const Eigen::MatrixXd Mmn_RPA = Mmn_full[ m_level ].block(n_occ, 0,n_unocc, size );
+                    Mmn_RPA.middleRows(m * n_unocc, n_unocc) = Mmn_full[ m_level ].block(n_occ, 0, n_unocc, size);
 #else
-                const Eigen::MatrixXd Mmn_RPA = Mmn_full[ m_level ].block(n_occ,0,  n_unocc, size).cast<double>();       
+                    Mmn_RPA.middleRows(m * n_unocc, n_unocc) = Mmn_full[ m_level ].block(n_occ, 0, n_unocc, size).cast<double>();
 #endif
-                Eigen::MatrixXd tempresult=Eigen::MatrixXd::Zero(size,size);
-                Eigen::MatrixXd denom_x_Mmn_RPA=Eigen::MatrixXd::Zero(n_unocc,size);
-                for (int i = 0; i < _screen_freq_i.size(); ++i) {   
-                    // a temporary matrix, that will get filled in empty levels loop
-                    const double screen_freq2 = _screen_freq_i(i) * _screen_freq_i(i);
-                    for (int n_level = 0; n_level < n_unocc; n_level++) {
-                        const double deltaE = qp_energies(n_level + lumo) - qp_energy_m;
-                        const double denom=4.0 * deltaE / (deltaE * deltaE + screen_freq2);  
-                        denom_x_Mmn_RPA.row(n_level)=Mmn_RPA.row(n_level)*denom; //hartree    
-                    }
-                    tempresult.noalias() = Mmn_RPA.transpose() * denom_x_Mmn_RPA;
+                    deltaE.segment(m * n_unocc, n_unocc) = qp_energies.segment(lumo, n_unocc).array()
+                            - qp_energies(m_level + _rpamin);
+                }
 
-#pragma omp critical
-                    {
-                        _epsilon_i[i] += tempresult;
-                    }
+                Eigen::MatrixXd denom_x_Mmn_RPA(rows, size);
+                for (int i = 0; i < _screen_freq_i.size(); ++i) {
+                    const double screen_freq2 = _screen_freq_i(i) * _screen_freq_i(i);
+                    const Eigen::VectorXd denom = 4.0 * deltaE.array() / (deltaE.array().square() + screen_freq2);
+                    denom_x_Mmn_RPA.noalias() = denom.asDiagonal() * Mmn_RPA; //hartree
+                    _epsilon_i[i].noalias() += Mmn_RPA.transpose() * denom_x_Mmn_RPA;
                 }
 
                 //real parts
                 for (int i = 0; i < _screen_freq_r.size(); ++i) {
-                    for (int n_level = 0;  n_level < n_unocc; n_level++) {
-                        const double deltaE = qp_energies(n_level + lumo) - qp_energy_m;
-                        const double denom=2.0 * (1.0 / (deltaE - _screen_freq_r(i)) + 1.0 / (deltaE + _screen_freq_r(i)));
-                        denom_x_Mmn_RPA.row(n_level)=Mmn_RPA.row(n_level)*denom; //hartree    
-                    }
-                    tempresult.noalias() = Mmn_RPA.transpose() * denom_x_Mmn_RPA;
-
-#pragma omp critical
-                    {
-                        _epsilon_r[i] += tempresult;
-                    }
+                    const Eigen::VectorXd denom = 2.0 * ((deltaE.array() - _screen_freq_r(i)).inverse()
+                            + (deltaE.array() + _screen_freq_r(i)).inverse());
+                    denom_x_Mmn_RPA.noalias() = denom.asDiagonal() * Mmn_RPA; //hartree
+                    _epsilon_r[i].noalias() += Mmn_RPA.transpose() * denom_x_Mmn_RPA;
                 }
 
             } // occupied levels
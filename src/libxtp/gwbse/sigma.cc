@@ -20,6 +20,7 @@
 
 
 #include <votca/xtp/sigma.h>
+#include <algorithm>
 #include <cmath>
 #include <boost/math/constants/constants.hpp>
 #include <votca/tools/constants.h>
@@ -41,55 +42,85 @@ namespace votca {
       return Hqp;
     }
 
+    Sigma::PPMPoles Sigma::NonzeroPoles(const PPM& ppm) const {
+      // the ppm_weights smaller 1.e-9 are set to zero in rpa.cc PPM_construct_parameters
+      const Eigen::VectorXd& ppm_weight = ppm.getPpm_weight();
+      const Eigen::VectorXd& ppm_freq = ppm.getPpm_freq();
+      PPMPoles poles;
+      for (int i_gw = 0; i_gw < ppm_weight.size(); i_gw++) {
+        if (ppm_weight(i_gw) >= 1.e-9) {
+          poles.index.push_back(i_gw);
+        }
+      }
+      const int npoles = poles.index.size();
+      poles.freq.resize(npoles);
+      poles.fac.resize(npoles);
+      for (int k = 0; k < npoles; k++) {
+        poles.freq(k) = ppm_freq(poles.index[k]);
+        poles.fac(k) = 0.25 * ppm_weight(poles.index[k]) * poles.freq(k);
+      }
+      return poles;
+    }
+
+    Eigen::MatrixXd Sigma::CorrelationFactors(double qp_energy, const Eigen::VectorXd& energies,
+            int levelsum, const PPMPoles& poles, int start, int cols) const {
+      // A(i,k) = 0.25 w_k f_k S(qp - e_i + f_k) for occupied, S(qp - e_i - f_k) for unoccupied bands
+      const Eigen::ArrayXd shifted = qp_energy - energies.head(levelsum).array();
+      const int lumo = _homo + 1;
+      Eigen::MatrixXd A(levelsum, cols);
+      for (int k = 0; k < cols; k++) {
+        const double freq = poles.freq(start + k);
+        Eigen::ArrayXd denom(levelsum);
+        denom.head(lumo) = shifted.head(lumo) + freq;
+        denom.tail(levelsum - lumo) = shifted.tail(levelsum - lumo) - freq;
+        Eigen::ArrayXd stab = denom.inverse();
+        for (int i = 0; i < levelsum; i++) {
+          if (std::abs(denom(i)) < 0.25) {
+            stab(i) = Stabilize(denom(i));
+          }
+        }
+        A.col(k) = poles.fac(start + k) * stab.matrix();
+      }
+      return A;
+    }
+
+    Eigen::MatrixXd Sigma::PoleColumns(const TCMatrix_gwbse& Mmn, int level, const PPMPoles& poles,
+            int start, int cols) const {
+      const Eigen::Map<const MatrixXfd> Mmn1 = Mmn[level];
+      Eigen::MatrixXd M(Mmn1.rows(), cols);
+      for (int k = 0; k < cols; k++) {
+        M.col(k) = Mmn1.col(poles.index[start + k]).cast<double>();
+      }
+      return M;
+    }
+
+    int Sigma::AuxChunkSize(int rows, int auxsize) const {
+      // stacked chunks of all qp levels are kept around 32MB each
+      const long maxelements = 1L << 22;
+      const long chunk = maxelements / std::max(1L, long(rows) * _qptotal);
+      return int(std::max(1L, std::min(long(auxsize), chunk)));
+    }
+
     void Sigma::X_diag(const TCMatrix_gwbse& Mmn){
-      int gwsize = Mmn.getAuxDimension(); // size of the GW basis
       _sigma_x=Eigen::MatrixXd::Zero(_qptotal,_qptotal);
       #pragma omp parallel for
       for (int gw_level = 0; gw_level < _qptotal; gw_level++) {
-        const MatrixXfd & Mmn1 = Mmn[ gw_level + _qpmin ];
-        double sigma_x = 0;
-        for (int i_gw = 0; i_gw < gwsize; i_gw++) {
-          // loop over all occupied bands used in screening
-          for (int i_occ = 0; i_occ <= _homo; i_occ++) {
-            sigma_x -= Mmn1( i_occ,i_gw) * Mmn1( i_occ,i_gw);
-          } // occupied bands
-        } // gwbasis functions             
+        // sum over all occupied bands used in screening and all gwbasis functions
+        const double sigma_x = -Mmn[ gw_level + _qpmin ].topRows(_homo + 1).cast<double>().squaredNorm();
         _sigma_x(gw_level, gw_level) = (1.0 - _ScaHFX) * sigma_x;
       }
     }
 
-    void Sigma::C_diag(const TCMatrix_gwbse& Mmn, const PPM& ppm, const Eigen::VectorXd& qp_old){
-      int levelsum = Mmn.get_ntot(); // total number of bands
-      int gwsize = Mmn.getAuxDimension(); // size of the GW basis
-      
+    void Sigma::C_diag(const TCMatrix_gwbse& Mmn, const PPMPoles& poles, const Eigen::VectorXd& qp_old){
+      const int levelsum = Mmn.get_ntot(); // total number of bands
+      const int npoles = poles.index.size();
       // loop over all GW levels
 #pragma omp parallel for
       for (int gw_level = 0; gw_level < _qptotal; gw_level++) {
-        const MatrixXfd & Mmn1 = Mmn[ gw_level + _qpmin ];
-        const double qpmin = qp_old(gw_level + _qpmin);
-        double sigma_c = 0.0;
-        // loop over all functions in GW basis
-        for (int i_gw = 0; i_gw < gwsize; i_gw++) {
-          // the ppm_weights smaller 1.e-5 are set to zero in rpa.cc PPM_construct_parameters
-          if (ppm.getPpm_weight()(i_gw) < 1.e-9) {
-            continue;
-          }
-          const double ppm_freq = ppm.getPpm_freq()(i_gw);
-          const double fac = 0.5*ppm.getPpm_weight()(i_gw) * ppm_freq;
-          // loop over all bands
-          double sigma_c_loc=0.0;
-          for (int i = 0; i < _homo+1; i++) {
-            const double factor=Stabilize(qpmin - qp_old(i) +ppm_freq);
-            // sigma_c diagonal elements
-            sigma_c_loc += factor * Mmn1(i, i_gw) * Mmn1( i,i_gw);
-          }// bands
-          for (int i = _homo+1; i < levelsum; i++) {
-            const double factor=Stabilize(qpmin - qp_old(i) -ppm_freq);
-            // sigma_c diagonal elements
-            sigma_c_loc += factor * Mmn1(i,i_gw) * Mmn1(i,i_gw);
-          }// bands
-          sigma_c+=sigma_c_loc*fac;
-        }// GW functions
+        const Eigen::MatrixXd A = CorrelationFactors(qp_old(gw_level + _qpmin), qp_old, levelsum, poles, 0, npoles);
+        const Eigen::MatrixXd M = PoleColumns(Mmn, gw_level + _qpmin, poles, 0, npoles);
+        // sigma_c = 2 sum_ik A(i,k) M(i,k)^2
+        const double sigma_c = 2.0 * (A.array() * M.array().square()).sum();
         _sigma_c(gw_level, gw_level) = sigma_c;
         // update _qp_energies
         _gwa_energies(gw_level + _qpmin) = (*_dftenergies)(gw_level + _qpmin) + sigma_c + _sigma_x(gw_level, gw_level) - (*_vxc)(gw_level, gw_level);
@@ -105,10 +136,11 @@ namespace votca {
 
       // initial _qp_energies are dft energies
       Eigen::VectorXd qp_old = _gwa_energies;
+      const PPMPoles poles = NonzeroPoles(ppm);
       // only diagonal elements except for in final iteration
       for (int g_iter = 0; g_iter < _g_sc_max_iterations; g_iter++) {
         
-        C_diag(Mmn, ppm, qp_old);
+        C_diag(Mmn, poles, qp_old);
         Eigen::VectorXd diff = qp_old - _gwa_energies;
         bool energies_converged = true;
 
@@ -141,21 +173,26 @@ namespace votca {
     }
 
     void Sigma::X_offdiag(const TCMatrix_gwbse& Mmn){
-      int gwsize = Mmn.getAuxDimension();
-      #pragma omp parallel for schedule(dynamic)
+      // sigma_x(m,n) = - sum_i^occ sum_gw M_m(i,gw) M_n(i,gw), with the occupied blocks of
+      // all qp levels stacked into columns this is one GEMM per chunk of gwbasis functions
+      const int gwsize = Mmn.getAuxDimension();
+      const int nocc = _homo + 1;
+      const int chunk = AuxChunkSize(nocc, gwsize);
+      Eigen::MatrixXd sigma_x = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+      for (int start = 0; start < gwsize; start += chunk) {
+        const int cols = std::min(chunk, gwsize - start);
+        Eigen::MatrixXd M(long(nocc) * cols, _qptotal);
+        #pragma omp parallel for
+        for (int gw_level = 0; gw_level < _qptotal; gw_level++) {
+          Eigen::Map<Eigen::MatrixXd> Mlevel(M.col(gw_level).data(), nocc, cols);
+          Mlevel = Mmn[ gw_level + _qpmin ].block(0, start, nocc, cols).cast<double>();
+        }
+        sigma_x.noalias() -= M.transpose() * M;
+      }
       for (int gw_level1 = 0; gw_level1 < _qptotal; gw_level1++) {
-        const MatrixXfd& Mmn1 = Mmn[ gw_level1 + _qpmin ];
         for (int gw_level2 = gw_level1+1; gw_level2 < _qptotal; gw_level2++) {
-          const MatrixXfd & Mmn2 = Mmn[ gw_level2 + _qpmin ];
-          double sigma_x = 0;
-          for (int i_gw = 0; i_gw < gwsize; i_gw++) {
-            // loop over all occupied bands used in screening
-            for (int i_occ = 0; i_occ <= _homo; i_occ++) {
-              sigma_x -= Mmn1(i_occ,i_gw) * Mmn2(i_occ,i_gw);
-            } // occupied bands
-          } // gwbasis functions
-          _sigma_x(gw_level1, gw_level2) = (1.0 - _ScaHFX) * sigma_x;
-          _sigma_x(gw_level2, gw_level1) = (1.0 - _ScaHFX) * sigma_x;
+          _sigma_x(gw_level1, gw_level2) = (1.0 - _ScaHFX) * sigma_x(gw_level1, gw_level2);
+          _sigma_x(gw_level2, gw_level1) = (1.0 - _ScaHFX) * sigma_x(gw_level1, gw_level2);
         }
       }
       return;
@@ -170,57 +207,37 @@ namespace votca {
       return stab / denom;
     }
 
-    double Sigma::SumSymmetric(real_gwbse Mmn1xMmn2, double qpmin1, double qpmin2, double gwa_energy){
-      double factor=Stabilize(qpmin1 - gwa_energy);
-      factor+= Stabilize(qpmin2 - gwa_energy);
-      return Mmn1xMmn2 * factor;
-    }
-
     void Sigma::C_offdiag(const TCMatrix_gwbse& Mmn, const PPM& ppm){
-
-      #pragma omp parallel 
-      {
-        int lumo=_homo+1;
-        const int levelsum = Mmn.get_ntot(); // total number of bands
-        const int gwsize = Mmn.getAuxDimension(); // size of the GW basis
-        const Eigen::VectorXd ppm_weight=ppm.getPpm_weight();
-        const Eigen::VectorXd ppm_freqs=ppm.getPpm_freq();
-        #pragma omp for schedule(dynamic)
-        for (int gw_level1 = 0; gw_level1 < _qptotal; gw_level1++) {
-        const MatrixXfd& Mmn1=Mmn[ gw_level1 + _qpmin ];
+      // sigma_c(m,n) = sum_ik (A_m(i,k) + A_n(i,k)) M_m(i,k) M_n(i,k) = <B_m,M_n> + <M_m,B_n>
+      // with B_m = A_m o M_m. Stacking B_m and M_m of all qp levels as columns gives
+      // sigma_c = B^T M + M^T B, evaluated in chunks of PPM poles.
+      const int levelsum = Mmn.get_ntot(); // total number of bands
+      const PPMPoles poles = NonzeroPoles(ppm);
+      const int npoles = poles.index.size();
+      const int chunk = AuxChunkSize(levelsum, npoles);
+      const Eigen::VectorXd gwa_energies = _gwa_energies;
+      Eigen::MatrixXd BtM = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+      for (int start = 0; start < npoles; start += chunk) {
+        const int cols = std::min(chunk, npoles - start);
+        Eigen::MatrixXd M(long(levelsum) * cols, _qptotal);
+        Eigen::MatrixXd B(long(levelsum) * cols, _qptotal);
+        #pragma omp parallel for
+        for (int gw_level = 0; gw_level < _qptotal; gw_level++) {
+          Eigen::Map<Eigen::MatrixXd> Mlevel(M.col(gw_level).data(), levelsum, cols);
+          Eigen::Map<Eigen::MatrixXd> Blevel(B.col(gw_level).data(), levelsum, cols);
+          Mlevel = PoleColumns(Mmn, gw_level + _qpmin, poles, start, cols);
+          Blevel = CorrelationFactors(gwa_energies(gw_level + _qpmin), gwa_energies, levelsum, poles, start, cols)
+                  .cwiseProduct(Mlevel);
+        }
+        BtM.noalias() += B.transpose() * M;
+      }
+      for (int gw_level1 = 0; gw_level1 < _qptotal; gw_level1++) {
         for (int gw_level2 = gw_level1+1; gw_level2 < _qptotal; gw_level2++) {
-          const MatrixXfd Mmn1xMmn2=Mmn[ gw_level2 + _qpmin ].cwiseProduct(Mmn1);
-          const Eigen::VectorXd gwa_energies=_gwa_energies;
-          const double qpmin1 = gwa_energies(gw_level1 + _qpmin);
-          const double qpmin2 = gwa_energies(gw_level2 + _qpmin);
- 
-          double sigma_c=0;
-          for (int i_gw = 0; i_gw < gwsize; i_gw++) {
-            // the ppm_weights smaller 1.e-5 are set to zero in rpa.cc PPM_construct_parameters
-            if (ppm_weight(i_gw) < 1.e-9) {
-              continue;
-            }
-            const double ppm_freq= ppm_freqs(i_gw);
-            const double fac = 0.25* ppm_weight(i_gw) * ppm_freq;
-            double sigma_loc=0.0;
-            // loop over occ screening levels
-              for (int i = 0; i < lumo; i++) {
-                const double gwa_energy = gwa_energies(i) - ppm_freq;
-                sigma_loc+=SumSymmetric(Mmn1xMmn2(i,i_gw), qpmin1, qpmin2, gwa_energy);
-              }
-              // loop over unocc screening levels
-              for (int i = lumo; i < levelsum; i++) {
-                const double gwa_energy = gwa_energies(i) + ppm_freq;
-                sigma_loc+=SumSymmetric(Mmn1xMmn2(i,i_gw), qpmin1, qpmin2, gwa_energy);
-              }
-              sigma_c += sigma_loc*fac;
-            }
+          const double sigma_c = BtM(gw_level1, gw_level2) + BtM(gw_level2, gw_level1);
           _sigma_c(gw_level1, gw_level2) = sigma_c;
           _sigma_c(gw_level2, gw_level1) = sigma_c;
-        }// GW row             
-      }//GW col
+        }
       }
-      
       return;
     }
 
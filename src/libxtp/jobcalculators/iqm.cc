@@ -417,6 +417,10 @@ namespace votca {
 
 
       // do excited states calculation
+      // if the couplings are evaluated right away and the eh interaction is not
+      // stored, the BSE Hamiltonian of the dimer is kept matrix-free
+      bool bse_operator_coupling = _do_gwbse && _do_bsecoupling && !_store_ehint;
+      GWBSE gwbse = GWBSE(orbitalsAB);
       if (_do_gwbse) {
         try {
           CTP_LOG(ctp::logDEBUG, *pLog) << "Running GWBSE" << flush;
@@ -426,9 +430,9 @@ namespace votca {
           gwbse_logger.setPreface(ctp::logERROR, (format("\nGWBSE ERR ...")).str());
           gwbse_logger.setPreface(ctp::logWARNING, (format("\nGWBSE WAR ...")).str());
           gwbse_logger.setPreface(ctp::logDEBUG, (format("\nGWBSE DBG ...")).str());
-          GWBSE gwbse = GWBSE(orbitalsAB);
           gwbse.setLogger(&gwbse_logger);
           gwbse.Initialize(_gwbse_options);
+          gwbse.setKeepBSEData(bse_operator_coupling);
           gwbse.Evaluate();
            WriteLoggerToFile(work_dir + "/gwbse.log", gwbse_logger);
         } catch (std::runtime_error& error) {
@@ -481,7 +485,13 @@ namespace votca {
           bsecoupling_logger.setPreface(ctp::logDEBUG, (format("\nGWBSE DBG ...")).str());
           bsecoupling.setLogger(&bsecoupling_logger);
           bsecoupling.Initialize(_bsecoupling_options);
-          bsecoupling.CalculateCouplings(orbitalsA, orbitalsB, orbitalsAB);
+          if (bse_operator_coupling) {
+            const BSEOperator Hs = gwbse.getSingletOperator();
+            const BSEOperator Ht = gwbse.getTripletOperator();
+            bsecoupling.CalculateCouplings(orbitalsA, orbitalsB, orbitalsAB, &Hs, &Ht);
+          } else {
+            bsecoupling.CalculateCouplings(orbitalsA, orbitalsB, orbitalsAB);
+          }
           bsecoupling.Addoutput(job_output, orbitalsA, orbitalsB);
           WriteLoggerToFile(work_dir + "/bsecoupling.log", bsecoupling_logger);
         } catch (std::runtime_error& error) {
@@ -123,42 +123,89 @@ namespace votca {
     }
 
         
-        void NumericalIntegration::EvaluateXC(const double rho, const double sigma, double& f_xc, double& df_drho, double& df_dsigma) {
-
-        double exc[1];
-        double vsigma[1]; // libxc 
-        double vrho[1]; // libxc df/drho
+        void NumericalIntegration::EvaluateXC(const Eigen::VectorXd& rho, const Eigen::VectorXd& sigma, Eigen::VectorXd& f_xc, Eigen::VectorXd& df_drho, Eigen::VectorXd& df_dsigma) {
+        // one libxc call for all points
+        const int npoints = rho.size();
+        f_xc = Eigen::VectorXd::Zero(npoints);
+        df_drho = Eigen::VectorXd::Zero(npoints);
+        df_dsigma = Eigen::VectorXd::Zero(npoints); // stays zero for LDA
+        if (npoints == 0) {
+          return;
+        }
         switch (xfunc.info->family) {
           case XC_FAMILY_LDA:
-            xc_lda_exc_vxc(&xfunc, 1, &rho, exc, vrho);
+            xc_lda_exc_vxc(&xfunc, npoints, rho.data(), f_xc.data(), df_drho.data());
             break;
           case XC_FAMILY_GGA:
           case XC_FAMILY_HYB_GGA:
-            xc_gga_exc_vxc(&xfunc, 1, &rho, &sigma, exc, vrho, vsigma);
+            xc_gga_exc_vxc(&xfunc, npoints, rho.data(), sigma.data(), f_xc.data(), df_drho.data(), df_dsigma.data());
             break;
         }
-        f_xc = exc[0];
-        df_drho = vrho[0];
-        df_dsigma = vsigma[0];
         if (_use_separate) {
           // via libxc correlation part only
+          Eigen::VectorXd exc = Eigen::VectorXd::Zero(npoints);
+          Eigen::VectorXd vrho = Eigen::VectorXd::Zero(npoints);
+          Eigen::VectorXd vsigma = Eigen::VectorXd::Zero(npoints);
           switch (cfunc.info->family) {
             case XC_FAMILY_LDA:
-              xc_lda_exc_vxc(&cfunc, 1, &rho, exc, vrho);
+              xc_lda_exc_vxc(&cfunc, npoints, rho.data(), exc.data(), vrho.data());
               break;
             case XC_FAMILY_GGA:
             case XC_FAMILY_HYB_GGA:
-              xc_gga_exc_vxc(&cfunc, 1, &rho, &sigma, exc, vrho, vsigma);
+              xc_gga_exc_vxc(&cfunc, npoints, rho.data(), sigma.data(), exc.data(), vrho.data(), vsigma.data());
               break;
           }
-
-          f_xc += exc[0];
-          df_drho += vrho[0];
-          df_dsigma += vsigma[0];
+          f_xc += exc;
+          df_drho += vrho;
+          df_dsigma += vsigma;
         }
   
       return;
     }
+
+    Eigen::MatrixX3d NumericalIntegration::GridPositions(const GridBox& box) const {
+      const std::vector<tools::vec>& points = box.getGridPoints();
+      Eigen::MatrixX3d positions(points.size(), 3);
+      for (unsigned p = 0; p < points.size(); p++) {
+        positions(p, 0) = points[p].getX();
+        positions(p, 1) = points[p].getY();
+        positions(p, 2) = points[p].getZ();
+      }
+      return positions;
+    }
+
+    void NumericalIntegration::EvalAOBlock(const GridBox& box, Eigen::MatrixXd& ao) const {
+      const std::vector<GridboxRange>& aoranges = box.getAOranges();
+      const std::vector<const AOShell* >& shells = box.getShells();
+      const Eigen::MatrixX3d positions = GridPositions(box);
+      ao = Eigen::MatrixXd::Zero(box.size(), box.Matrixsize());
+      for (unsigned j = 0; j < box.Shellsize(); ++j) {
+        Eigen::Block<Eigen::MatrixXd> ao_block = ao.block(0, aoranges[j].start, box.size(), aoranges[j].size);
+        shells[j]->EvalAOspace(ao_block, positions);
+      }
+      return;
+    }
+
+    void NumericalIntegration::EvalAOBlock(const GridBox& box, Eigen::MatrixXd& ao, Eigen::MatrixXd& ao_grad_x,
+                                             Eigen::MatrixXd& ao_grad_y, Eigen::MatrixXd& ao_grad_z) const {
+      const std::vector<GridboxRange>& aoranges = box.getAOranges();
+      const std::vector<const AOShell* >& shells = box.getShells();
+      const Eigen::MatrixX3d positions = GridPositions(box);
+      ao = Eigen::MatrixXd::Zero(box.size(), box.Matrixsize());
+      ao_grad_x = Eigen::MatrixXd::Zero(box.size(), box.Matrixsize());
+      ao_grad_y = Eigen::MatrixXd::Zero(box.size(), box.Matrixsize());
+      ao_grad_z = Eigen::MatrixXd::Zero(box.size(), box.Matrixsize());
+      for (unsigned j = 0; j < box.Shellsize(); ++j) {
+        const int start = aoranges[j].start;
+        const int size = aoranges[j].size;
+        Eigen::Block<Eigen::MatrixXd> ao_block = ao.block(0, start, box.size(), size);
+        Eigen::Block<Eigen::MatrixXd> grad_x_block = ao_grad_x.block(0, start, box.size(), size);
+        Eigen::Block<Eigen::MatrixXd> grad_y_block = ao_grad_y.block(0, start, box.size(), size);
+        Eigen::Block<Eigen::MatrixXd> grad_z_block = ao_grad_z.block(0, start, box.size(), size);
+        shells[j]->EvalAOspace(ao_block, grad_x_block, grad_y_block, grad_z_block, positions);
+      }
+      return;
+    }
         
         
     double NumericalIntegration::IntegratePotential(const tools::vec& rvector) {
@@ -379,36 +426,57 @@ namespace votca {
           if (DMAT_here.cwiseAbs2().maxCoeff()<cutoff ){
             continue;
           }     
-          Eigen::MatrixXd Vxc_here = Eigen::MatrixXd::Zero(DMAT_here.rows(), DMAT_here.cols());
-          const std::vector<tools::vec>& points = box.getGridPoints();
           const std::vector<double>& weights = box.getGridWeights();
-          const std::vector<GridboxRange>& aoranges = box.getAOranges();
-          const std::vector<const AOShell* >& shells = box.getShells();
-          
-          //iterate over gridpoints
+
+          // all points of a box at once, AO values are npoints x nao
+          Eigen::MatrixXd ao;
+          Eigen::MatrixXd ao_grad_x;
+          Eigen::MatrixXd ao_grad_y;
+          Eigen::MatrixXd ao_grad_z;
+          EvalAOBlock(box, ao, ao_grad_x, ao_grad_y, ao_grad_z);
+          const Eigen::MatrixXd DMATxao = ao * DMAT_symm;
+          const Eigen::VectorXd rho = 0.5 * DMATxao.cwiseProduct(ao).rowwise().sum();
+          const Eigen::VectorXd rho_grad_x = DMATxao.cwiseProduct(ao_grad_x).rowwise().sum();
+          const Eigen::VectorXd rho_grad_y = DMATxao.cwiseProduct(ao_grad_y).rowwise().sum();
+          const Eigen::VectorXd rho_grad_z = DMATxao.cwiseProduct(ao_grad_z).rowwise().sum();
+
+          // skip points, where the density is very small
+          std::vector<int> significant;
           for (unsigned p = 0; p < box.size(); p++) {
-            Eigen::VectorXd ao = Eigen::VectorXd::Zero(box.Matrixsize());
-            Eigen::MatrixX3d ao_grad= Eigen::MatrixX3d::Zero(box.Matrixsize(),3);
-            for (unsigned j = 0; j < box.Shellsize(); ++j) {
-              Eigen::Block<Eigen::MatrixX3d> grad_block=ao_grad.block(aoranges[j].start,0,aoranges[j].size,3);
-              Eigen::VectorBlock<Eigen::VectorXd> ao_block=ao.segment(aoranges[j].start,aoranges[j].size);
-              shells[j]->EvalAOspace(ao_block,grad_block,points[p]);             
+            if (rho(p) * weights[p] >= 1.e-20) {
+              significant.push_back(p);
             }
-            const double rho =0.5* (ao.transpose()*DMAT_symm*ao).value();
+          }
+          const int nsignificant = significant.size();
+          Eigen::VectorXd rho_sig(nsignificant);
+          Eigen::VectorXd sigma_sig(nsignificant);
+          for (int k = 0; k < nsignificant; k++) {
+            const int p = significant[k];
+            rho_sig(k) = rho(p);
+            sigma_sig(k) = rho_grad_x(p) * rho_grad_x(p) + rho_grad_y(p) * rho_grad_y(p) + rho_grad_z(p) * rho_grad_z(p);
+          }
+          Eigen::VectorXd f_xc; // E_xc[n] = int{n(r)*eps_xc[n(r)] d3r} = int{ f_xc(r) d3r }
+          Eigen::VectorXd df_drho; // v_xc_rho(r) = df/drho
+          Eigen::VectorXd df_dsigma; // df/dsigma ( df/dgrad(rho) = df/dsigma * dsigma/dgrad(rho) = df/dsigma * 2*grad(rho))
+          EvaluateXC(rho_sig, sigma_sig, f_xc, df_drho, df_dsigma);
+
+          Eigen::VectorXd coeff_ao = Eigen::VectorXd::Zero(box.size());
+          Eigen::VectorXd coeff_x = Eigen::VectorXd::Zero(box.size());
+          Eigen::VectorXd coeff_y = Eigen::VectorXd::Zero(box.size());
+          Eigen::VectorXd coeff_z = Eigen::VectorXd::Zero(box.size());
+          for (int k = 0; k < nsignificant; k++) {
+            const int p = significant[k];
             const double weight = weights[p];
-            if (rho*weight < 1.e-20) continue; // skip the rest, if density is very small
-            const Eigen::Vector3d rho_grad = ao.transpose()*DMAT_symm*ao_grad;
-            const double sigma = (rho_grad.transpose()*rho_grad).value();
-            const Eigen::VectorXd grad =ao_grad*rho_grad;
-            double f_xc; // E_xc[n] = int{n(r)*eps_xc[n(r)] d3r} = int{ f_xc(r) d3r }
-            double df_drho; // v_xc_rho(r) = df/drho
-            double df_dsigma; // df/dsigma ( df/dgrad(rho) = df/dsigma * dsigma/dgrad(rho) = df/dsigma * 2*grad(rho))
-            EvaluateXC(rho, sigma, f_xc, df_drho, df_dsigma); 
-            EXC_box += weight * rho * f_xc;
-            auto addXC = weight * (0.5*df_drho * ao+ 2.0 * df_dsigma *grad);
-            // Exchange correlation energy
-            Vxc_here.noalias() += addXC* ao.transpose();
+            EXC_box += weight * rho(p) * f_xc(k);
+            coeff_ao(p) = 0.5 * weight * df_drho(k);
+            const double grad_factor = 2.0 * weight * df_dsigma(k);
+            coeff_x(p) = grad_factor * rho_grad_x(p);
+            coeff_y(p) = grad_factor * rho_grad_y(p);
+            coeff_z(p) = grad_factor * rho_grad_z(p);
           }
+          const Eigen::MatrixXd addXC = coeff_ao.asDiagonal() * ao + coeff_x.asDiagonal() * ao_grad_x
+                  + coeff_y.asDiagonal() * ao_grad_y + coeff_z.asDiagonal() * ao_grad_z;
+          const Eigen::MatrixXd Vxc_here = addXC.transpose() * ao;
           box.AddtoBigMatrix(vxc_thread[thread], Vxc_here);
           Exc_thread[thread] += EXC_box;
         }
@@ -440,29 +508,21 @@ namespace votca {
         for (unsigned i = thread_start[thread]; i < thread_stop[thread]; ++i) {
 
           const GridBox& box = _grid_boxes[i];
-          Eigen::MatrixXd Vex_here = Eigen::MatrixXd::Zero(box.Matrixsize(), box.Matrixsize());
-          const std::vector<tools::vec>& points = box.getGridPoints();
           const std::vector<double>& weights = box.getGridWeights();
 
-          //iterate over gridpoints
+          Eigen::MatrixXd ao;
+          EvalAOBlock(box, ao);
+          Eigen::VectorXd coeff(box.size());
           for (unsigned p = 0; p < box.size(); p++) {
-            Eigen::VectorXd ao = Eigen::VectorXd::Zero(box.Matrixsize());
-            const std::vector<GridboxRange>& aoranges = box.getAOranges();
-            const std::vector<const AOShell* > shells = box.getShells();
-            for (unsigned j = 0; j < box.Shellsize(); ++j) {
-              Eigen::VectorBlock<Eigen::VectorXd> ao_block=ao.segment(aoranges[j].start,aoranges[j].size);
-              shells[j]->EvalAOspace(ao_block, points[p]);
-            }
-            Eigen::VectorXd addEX = weights[p] * Potentialvalues[box.getIndexoffirstgridpoint() + p] * ao;
-            Vex_here += addEX.transpose() * ao;
+            coeff(p) = weights[p] * Potentialvalues[box.getIndexoffirstgridpoint() + p];
           }
+          const Eigen::MatrixXd Vex_here = ao.transpose() * coeff.asDiagonal() * ao;
           box.AddtoBigMatrix(vex_thread[thread], Vex_here);
         }
       }
       for (unsigned i = 0; i < nthreads; ++i) {
         ExternalMat += vex_thread[i];
       }
-      ExternalMat += ExternalMat.transpose();
       return ExternalMat;
     }
       
@@ -481,19 +541,14 @@ namespace votca {
           double N_box = 0.0;
           GridBox& box = _grid_boxes[i];
           const Eigen::MatrixXd DMAT_here = box.ReadFromBigMatrix(density_matrix);
-          const std::vector<tools::vec>& points = box.getGridPoints();
           const std::vector<double>& weights = box.getGridWeights();
           box.prepareDensity();
+          Eigen::MatrixXd ao;
+          EvalAOBlock(box, ao);
+          const Eigen::VectorXd rho_box = (ao * DMAT_here).cwiseProduct(ao).rowwise().sum();
           //iterate over gridpoints
           for (unsigned p = 0; p < box.size(); p++) {
-            Eigen::VectorXd ao = Eigen::VectorXd::Zero(box.Matrixsize());
-            const std::vector<GridboxRange>& aoranges = box.getAOranges();
-            const std::vector<const AOShell* > shells = box.getShells();
-            for (unsigned j = 0; j < box.Shellsize(); ++j) {
-              Eigen::VectorBlock<Eigen::VectorXd> ao_block=ao.segment(aoranges[j].start,aoranges[j].size);
-              shells[j]->EvalAOspace(ao_block, points[p]);
-            }
-            double rho =(ao.transpose()*DMAT_here*ao)(0, 0);
+            double rho = rho_box(p);
             box.addDensity(rho);
             N_box += rho * weights[p];
           }
@@ -537,16 +592,12 @@ namespace votca {
           const std::vector<tools::vec>& points = box.getGridPoints();
           const std::vector<double>& weights = box.getGridWeights();
           box.prepareDensity();
+          Eigen::MatrixXd ao;
+          EvalAOBlock(box, ao);
+          const Eigen::VectorXd rho_box = (ao * DMAT_here).cwiseProduct(ao).rowwise().sum();
           //iterate over gridpoints
           for (unsigned p = 0; p < box.size(); p++) {
-            Eigen::VectorXd ao = Eigen::VectorXd::Zero(box.Matrixsize());
-            const std::vector<GridboxRange>& aoranges = box.getAOranges();
-            const std::vector<const AOShell* > shells = box.getShells();
-            for (unsigned j = 0; j < box.Shellsize(); ++j) {
-              Eigen::VectorBlock<Eigen::VectorXd> ao_block=ao.segment(aoranges[j].start,aoranges[j].size);
-              shells[j]->EvalAOspace(ao_block, points[p]);
-            }
-            double rho =(ao.transpose()*DMAT_here*ao)(0, 0);
+            double rho = rho_box(p);
             box.addDensity(rho);
             N_box += rho * weights[p];
             centroid_box+=rho * weights[p] * points[p];
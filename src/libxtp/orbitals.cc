@@ -226,202 +226,137 @@ namespace votca {
           return nuclei_dip - electronic_dip;
         }
 
-        Eigen::MatrixXd Orbitals::TransitionDensityMatrix(const QMState& state) const{
-            if (state.Type() != QMStateType::Singlet) {
-                throw runtime_error("Spin type not known for transition density matrix. Available only for singlet");
-            }
-            const MatrixXfd& BSECoefs = _BSE_singlet_coefficients;
-            if(BSECoefs.cols()<state.Index()+1 || BSECoefs.rows()<2){
-                throw runtime_error("Orbitals object has no information about state:"+state.ToString());
-            }
-            Eigen::MatrixXd dmatTS = Eigen::MatrixXd::Zero(_basis_set_size, _basis_set_size);
-            // The Transition dipole is sqrt2 bigger because of the spin, the excited state is a linear combination of 2 slater determinants, where either alpha or beta spin electron is excited
-            double sqrt2 = sqrt(2.0);
-            /*Trying to implement D_{alpha,beta}= sqrt2*sum_{i}^{occ}sum_{j}^{virt}{BSEcoef(i,j)*MOcoef(alpha,i)*MOcoef(beta,j)} */
-            // c stands for conduction band and thus virtual orbitals
-            // v stand for valence band and thus occupied orbitals
-            
-            // indexing info BSE vector index to occupied/virtual orbital
-            Index2MO index=BSEIndex2MOIndex();
-
-            if (!_useTDA) {
-                const MatrixXfd& BSECoefs_AR = _BSE_singlet_coefficients_AR;
-#pragma omp parallel for
-                for (int a = 0; a < dmatTS.rows(); a++) {
-                    for (int b = 0; b < dmatTS.cols(); b++) {
-                        for (int i = 0; i < _bse_size; i++) {
-                            int occ = index.I2v[i];
-                            int virt =index.I2c[i];
-                            dmatTS(a, b) += sqrt2 * (BSECoefs(i, state.Index()) + BSECoefs_AR(i, state.Index())) * _mo_coefficients(a, occ) * _mo_coefficients(b, virt); //check factor 2??
-                        }
-                    }
+        Eigen::MatrixXd Orbitals::BSECoefficients(const std::vector<QMState>& states, bool antiresonant) const{
+            // one column per state, the antiresonant part only exists for full BSE singlets
+            Eigen::MatrixXd coeffs = Eigen::MatrixXd::Zero(_bse_size, states.size());
+            for (unsigned i = 0; i < states.size(); i++) {
+                const QMState& state = states[i];
+                if (!state.Type().isExciton()) {
+                    throw runtime_error("Spin type not known for density matrix. Available are singlet and triplet");
                 }
-            } else {
-
-#pragma omp parallel for
-                for (int a = 0; a < dmatTS.rows(); a++) {
-                    for (int b = 0; b < dmatTS.cols(); b++) {
-                        for (int i = 0; i < _bse_size; i++) {
-                            int occ = index.I2v[i];
-                            int virt =index.I2c[i];
-                            dmatTS(a, b) += sqrt2 * BSECoefs(i, state.Index()) * _mo_coefficients(a, occ) * _mo_coefficients(b, virt); //check factor 2??
-                        }
+                const MatrixXfd& BSECoefs = (state.Type() == QMStateType::Singlet) ? _BSE_singlet_coefficients : _BSE_triplet_coefficients;
+                if (BSECoefs.cols() < state.Index() + 1 || BSECoefs.rows() < 2) {
+                    throw runtime_error("Orbitals object has no information about state:" + state.ToString());
+                }
+                if (!antiresonant) {
+                    coeffs.col(i) = BSECoefs.col(state.Index()).cast<double>();
+                } else if (!_useTDA && state.Type() == QMStateType::Singlet) {
+                    if (_BSE_singlet_coefficients_AR.cols() < state.Index() + 1) {
+                        throw runtime_error("Orbitals object has no information about state:" + state.ToString());
                     }
+                    coeffs.col(i) = _BSE_singlet_coefficients_AR.col(state.Index()).cast<double>();
                 }
-
             }
-            return dmatTS;
+            return coeffs;
         }
 
-        std::vector<Eigen::MatrixXd > Orbitals::DensityMatrixExcitedState(const QMState& state) const{
-            std::vector<Eigen::MatrixXd > dmat = DensityMatrixExcitedState_R(state);
-            if (!_useTDA && state.Type() == QMStateType::Singlet) {
-                std::vector<Eigen::MatrixXd > dmat_AR = DensityMatrixExcitedState_AR(state);
-                dmat[0] -= dmat_AR[0];
-                dmat[1] -= dmat_AR[1];
-            }
-            return dmat;
+        Eigen::MatrixXd Orbitals::TransitionDensityMatrix(const QMState& state) const{
+            return TransitionDensityMatrices(std::vector<QMState>(1, state))[0];
         }
 
-        // Excited state density matrix
-
-        std::vector<Eigen::MatrixXd> Orbitals::DensityMatrixExcitedState_R(const QMState& state) const{
-            if (!state.Type().isExciton()) {
-                throw runtime_error("Spin type not known for density matrix. Available are singlet and triplet");
-            }
-
-            const MatrixXfd & BSECoefs = (state.Type() == QMStateType::Singlet) ? _BSE_singlet_coefficients : _BSE_triplet_coefficients;
-            if(BSECoefs.cols()<state.Index()+1 || BSECoefs.rows()<2){
-                throw runtime_error("Orbitals object has no information about state:"+state.ToString());
+        std::vector<Eigen::MatrixXd> Orbitals::TransitionDensityMatrices(const std::vector<QMState>& states) const{
+            for (const QMState& state : states) {
+                if (state.Type() != QMStateType::Singlet) {
+                    throw runtime_error("Spin type not known for transition density matrix. Available only for singlet");
+                }
             }
             /******
              *
-             *    Density matrix for GW-BSE based excitations
-             *
-             *    - electron contribution
-             *      D_ab = \sum{vc} \sum{c'} A_{vc}A_{vc'} mo_a(c)mo_b(c')
-             *
-             *    - hole contribution
-             *      D_ab = \sum{vc} \sum{v'} A_{vc}A_{v'c} mo_a(v)mo_b(v')
-             *
+             *    D_ab = sqrt2 * \sum{vc} (A+B)_{vc} mo_a(v)mo_b(c)
              *
-             *   more efficient:
+             *    The Transition dipole is sqrt2 bigger because of the spin, the excited state is a linear combination of 2 slater determinants, where either alpha or beta spin electron is excited.
+             *    The coefficients of each state reshaped to ctotal x vtotal are (A+B)_{cv}, so
              *
-             *   - electron contribution
-             *      D_ab = \sum{c} \sum{c'} mo_a(c)mo_b(c') [ \sum{v} A_{vc}A_{vc'} ]
-             *           = \sum{c} \sum{c'} mo_a(c)mo_b(c') A_{cc'}
-             *
-             *   - hole contribution
-             *      D_ab = \sum{v} \sum{v'} mo_a(v)mo_b(v') [ \sum{c} A_{vc}A_{v'c} ]
-             *           = \sum{v} \sum{v'} mo_a(v)mo_b(v') A_{vv'}
+             *    D = sqrt2 * mo(v) [mo(c) (A+B)]^T
              *
+             *    and the virtual levels are transformed for all states in one product.
              */
-            std::vector<Eigen::MatrixXd > dmatEX;
-            dmatEX.resize(2);
-            dmatEX[0] = Eigen::MatrixXd::Zero(_basis_set_size, _basis_set_size);
-            dmatEX[1] = Eigen::MatrixXd::Zero(_basis_set_size, _basis_set_size);
-            Index2MO index=BSEIndex2MOIndex();
-
-            // electron assist matrix A_{cc'}
-            Eigen::MatrixXd Acc = Eigen::MatrixXd::Zero(_bse_ctotal, _bse_ctotal);
-            Eigen::MatrixXd Avv = Eigen::MatrixXd::Zero(_bse_vtotal, _bse_vtotal);
-
-            for (int idx1 = 0; idx1 < _bse_size; idx1++) {
-                int v = index.I2v[idx1];
-                int c = index.I2c[idx1];
-                // electron assist matrix A_{cc'}
-#pragma omp parallel for
-                for (int c2 = _bse_cmin; c2 <= _bse_cmax; c2++) {
-                    int idx2 = (_bse_cmax - _bse_cmin + 1)*(v - _bse_vmin)+(c2 - _bse_cmin);
-                    Acc(c - _bse_cmin, c2 - _bse_cmin) += BSECoefs(idx1, state.Index()) * BSECoefs(idx2, state.Index());
-                }
-
-                // hole assist matrix A_{vv'}
-#pragma omp parallel for
-                for (int v2 = _bse_vmin; v2 <= _bse_vmax; v2++) {
-                    int idx2 = (_bse_cmax - _bse_cmin + 1)*(v2 - _bse_vmin)+(c - _bse_cmin);
-                    Avv(v - _bse_vmin, v2 - _bse_vmin) += BSECoefs(idx1, state.Index()) * BSECoefs(idx2, state.Index());
-                }
+            const int nstates = states.size();
+            Eigen::MatrixXd coeffs = BSECoefficients(states, false);
+            if (!_useTDA) {
+                coeffs += BSECoefficients(states, true);
             }
-
-            // hole part as matrix products
+            Eigen::Map<const Eigen::MatrixXd> coeffs_cv(coeffs.data(), _bse_ctotal, _bse_vtotal * nstates);
             Eigen::MatrixXd occlevels = _mo_coefficients.block(0, _bse_vmin, _mo_coefficients.rows(), _bse_vtotal);
-            dmatEX[0] = occlevels * Avv * occlevels.transpose();
-
-            // electron part as matrix products
             Eigen::MatrixXd virtlevels = _mo_coefficients.block(0, _bse_cmin, _mo_coefficients.rows(), _bse_ctotal);
-            dmatEX[1] = virtlevels * Acc * virtlevels.transpose();
-            return dmatEX;
+            Eigen::MatrixXd virt_coeffs = virtlevels * coeffs_cv;
+
+            const double sqrt2 = sqrt(2.0);
+            std::vector<Eigen::MatrixXd> dmatTS(nstates);
+            for (int i = 0; i < nstates; i++) {
+                dmatTS[i] = sqrt2 * occlevels * virt_coeffs.middleCols(i * _bse_vtotal, _bse_vtotal).transpose();
+            }
+            return dmatTS;
         }
 
-        // Excited state density matrix
+        std::vector<Eigen::MatrixXd > Orbitals::DensityMatrixExcitedState(const QMState& state) const{
+            return DensityMatricesExcitedStates(std::vector<QMState>(1, state))[0];
+        }
 
-        std::vector<Eigen::MatrixXd > Orbitals::DensityMatrixExcitedState_AR(const QMState& state) const{
-            if (state.Type() != QMStateType::Singlet) {
-                throw runtime_error("Spin type not known for density matrix. Available is singlet");
-            }
-            
-            const MatrixXfd& BSECoefs_AR = _BSE_singlet_coefficients_AR;
-            if(BSECoefs_AR.cols()<state.Index()+1 || BSECoefs_AR.rows()<2){
-                throw runtime_error("Orbitals object has no information about state:"+state.ToString());
-            }
+        // Excited state density matrices
+
+        std::vector< std::vector<Eigen::MatrixXd> > Orbitals::DensityMatricesExcitedStates(const std::vector<QMState>& states) const{
             /******
              *
-             *    Density matrix for GW-BSE based excitations
-             *
-             *    - electron contribution
-             *      D_ab = \sum{vc} \sum{v'} B_{vc}B_{v'c} mo_a(v)mo_b(v')
+             *    Density matrix for GW-BSE based excitations, A resonant and B antiresonant coefficients
              *
              *    - hole contribution
-             *      D_ab = \sum{vc} \sum{c'} B_{vc}B_{vc'} mo_a(c)mo_b(c')
-             *
+             *      D_ab = \sum{v} \sum{v'} mo_a(v)mo_b(v') [ \sum{c} A_{vc}A_{v'c} - B_{vc}B_{v'c} ]
+             *           = \sum{v} \sum{v'} mo_a(v)mo_b(v') (A^TA - B^TB)_{vv'}
              *
-             *   more efficient:
-             *
-             *   - electron contribution
-             *      D_ab = \sum{v} \sum{v'} mo_a(v)mo_b(v') [ \sum{c} B_{vc}B_{v'c} ]
-             *           = \sum{v} \sum{v'} mo_a(v)mo_b(v') B_{vv'}
+             *    - electron contribution
+             *      D_ab = \sum{c} \sum{c'} mo_a(c)mo_b(c') [ \sum{v} A_{vc}A_{vc'} - B_{vc}B_{vc'} ]
+             *           = [mo(c) A] [mo(c) A]^T - [mo(c) B] [mo(c) B]^T
              *
-             *   - hole contribution
-             *      D_ab = \sum{c} \sum{c'} mo_a(c)mo_b(c') [ \sum{v} B_{vc}B_{vc'} ]
-             *           = \sum{c} \sum{c'} mo_a(c)mo_b(c') B_{cc'}
+             *    with A and B the coefficients of a state reshaped to ctotal x vtotal.
+             *    B is only present for singlets of the full BSE.
+             *    The MO blocks are multiplied once with the stacked matrices of all states.
              *
              */
-            std::vector<Eigen::MatrixXd > dmatAR;
-            dmatAR.resize(2);
-            dmatAR[0] = Eigen::MatrixXd::Zero(_basis_set_size, _basis_set_size);
-            dmatAR[1] = Eigen::MatrixXd::Zero(_basis_set_size, _basis_set_size);
-            Index2MO index=BSEIndex2MOIndex();
-
-            // hole assist matrix B_{cc'}
-            Eigen::MatrixXd Bcc = Eigen::MatrixXd::Zero(_bse_ctotal, _bse_ctotal);
-            Eigen::MatrixXd Bvv = Eigen::MatrixXd::Zero(_bse_vtotal, _bse_vtotal);
-
-            for (int idx1 = 0; idx1 < _bse_size; idx1++) {
-                int v = index.I2v[idx1];
-                int c = index.I2c[idx1];
-                // hole assist matrix B_{cc'}
-#pragma omp parallel for
-                for (int c2 = _bse_cmin; c2 <= _bse_cmax; c2++) {
-                    int idx2 = (_bse_cmax - _bse_cmin + 1)*(v - _bse_vmin)+(c2 - _bse_cmin);
-                    Bcc(c - _bse_cmin, c2 - _bse_cmin) += BSECoefs_AR(idx1, state.Index()) * BSECoefs_AR(idx2, state.Index());
-                }
+            const int nstates = states.size();
+            const Eigen::MatrixXd coeffs = BSECoefficients(states, false);
+            const Eigen::MatrixXd coeffs_AR = BSECoefficients(states, true);
+            bool has_AR = false;
+            for (const QMState& state : states) {
+                has_AR = has_AR || (!_useTDA && state.Type() == QMStateType::Singlet);
+            }
+            Eigen::Map<const Eigen::MatrixXd> A(coeffs.data(), _bse_ctotal, _bse_vtotal * nstates);
+            Eigen::Map<const Eigen::MatrixXd> B(coeffs_AR.data(), _bse_ctotal, _bse_vtotal * nstates);
 
-                // electron assist matrix B_{vv'}
+            // hole assist matrices A^TA - B^TB of all states side by side
+            Eigen::MatrixXd Avv(_bse_vtotal, _bse_vtotal * nstates);
 #pragma omp parallel for
-                for (int v2 = _bse_vmin; v2 <= _bse_vmax; v2++) {
-                    int idx2 = (_bse_cmax - _bse_cmin + 1)*(v2 - _bse_vmin)+(c - _bse_cmin);
-                    Bvv(v - _bse_vmin, v2 - _bse_vmin) += BSECoefs_AR(idx1, state.Index()) * BSECoefs_AR(idx2, state.Index());
+            for (int i = 0; i < nstates; i++) {
+                const int start = i * _bse_vtotal;
+                Avv.middleCols(start, _bse_vtotal).noalias() =
+                        A.middleCols(start, _bse_vtotal).transpose() * A.middleCols(start, _bse_vtotal);
+                if (has_AR) {
+                    Avv.middleCols(start, _bse_vtotal).noalias() -=
+                            B.middleCols(start, _bse_vtotal).transpose() * B.middleCols(start, _bse_vtotal);
                 }
             }
 
-            // hole part as matrix products
             Eigen::MatrixXd occlevels = _mo_coefficients.block(0, _bse_vmin, _mo_coefficients.rows(), _bse_vtotal);
-            dmatAR[0] = occlevels * Bvv * occlevels.transpose();
-            // electron part as matrix products
             Eigen::MatrixXd virtlevels = _mo_coefficients.block(0, _bse_cmin, _mo_coefficients.rows(), _bse_ctotal);
-            dmatAR[1] = virtlevels * Bcc * virtlevels.transpose();
-            return dmatAR;
+            const Eigen::MatrixXd occ_Avv = occlevels * Avv;
+            const Eigen::MatrixXd virt_A = virtlevels * A;
+            Eigen::MatrixXd virt_B;
+            if (has_AR) {
+                virt_B = virtlevels * B;
+            }
+
+            std::vector< std::vector<Eigen::MatrixXd> > dmatEX(nstates, std::vector<Eigen::MatrixXd>(2));
+            for (int i = 0; i < nstates; i++) {
+                const int start = i * _bse_vtotal;
+                // hole part
+                dmatEX[i][0] = occ_Avv.middleCols(start, _bse_vtotal) * occlevels.transpose();
+                // electron part
+                dmatEX[i][1] = virt_A.middleCols(start, _bse_vtotal) * virt_A.middleCols(start, _bse_vtotal).transpose();
+                if (has_AR) {
+                    dmatEX[i][1] -= virt_B.middleCols(start, _bse_vtotal) * virt_B.middleCols(start, _bse_vtotal).transpose();
+                }
+            }
+            return dmatEX;
         }
 
         Eigen::VectorXd Orbitals::LoewdinPopulation(const Eigen::MatrixXd & densitymatrix, const Eigen::MatrixXd & overlapmatrix, int frag){
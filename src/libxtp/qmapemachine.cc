@@ -161,17 +161,17 @@ bool QMAPEMachine::Iterate(string jobFolder, int iterCnt) {
     else
         CTP_LOG(ctp::logWARNING,*_log) << "Could not create directory " << runFolder << flush;
     
-    Orbitals orb_iter_input;
-    
-    qminterface.GenerateQMAtomsFromPolarSegs(_job->getPolarTop(), orb_iter_input);
-
-    DFTEngine dftengine;
-    dftengine.Initialize(_dft_options);
-    dftengine.setLogger(_log);
-    dftengine.ConfigureExternalGrid(_externalgridaccuracy);  
-    dftengine.Prepare(orb_iter_input);
-    if (iterCnt == 0) { 
-      SetupPolarSiteGrids(dftengine.getExternalGridpoints(),orb_iter_input.QMAtoms());
+    // the QM geometry is fixed, so later iterations only update the external
+    // potential and start the SCF from the MOs of the previous iteration
+    if (iterCnt == 0) {
+      qminterface.GenerateQMAtomsFromPolarSegs(_job->getPolarTop(), orb_iter_input);
+      _dftengine.Initialize(_dft_options);
+      _dftengine.setLogger(_log);
+      _dftengine.ConfigureExternalGrid(_externalgridaccuracy);  
+      _dftengine.Prepare(orb_iter_input);
+      SetupPolarSiteGrids(_dftengine.getExternalGridpoints(),orb_iter_input.QMAtoms());
+    } else if (_run_dft && !_dftengine.PrepareWarmStart(orb_iter_input)) {
+      throw std::runtime_error("QMAPEMachine could not reuse the DFT setup of the first iteration");
     }
 
     // COMPUTE POLARIZATION STATE WITH QM0(0)
@@ -187,10 +187,10 @@ bool QMAPEMachine::Iterate(string jobFolder, int iterCnt) {
         _cape->EvaluatePotential(target_fg, false, true, false);
             }
     
-    dftengine.setExternalGrid(ExtractElGrid_fromPolarsites(),ExtractNucGrid_fromPolarsites());
+    _dftengine.setExternalGrid(ExtractElGrid_fromPolarsites(),ExtractNucGrid_fromPolarsites());
     
     if (_run_dft) {
-    dftengine.Evaluate(orb_iter_input);
+    _dftengine.Evaluate(orb_iter_input);
     }
   
 	orb_iter_input.WriteXYZ(runFolder + "/Fullstructure.xyz","Full structure");
@@ -62,6 +62,8 @@ namespace votca {
       key = sfx + ".tholemodel";
       _static_qmmm = true;
       qmpack->setWithPolarization(false);
+      // only the background changes between iterations
+      qmpack->setWarmStart(true);
       if (opt->exists(key + ".induce")) {
         bool induce = opt->get(key + ".induce").as<bool>();
         if (induce) {
@@ -145,6 +147,16 @@ namespace votca {
       _qmpack->setCharge(chrg);
       _qmpack->setSpin(spin);
 
+      // the setup kept between the iterations must not leak into the next job,
+      // also if an iteration throws
+      struct WarmStartGuard {
+        QMPackage* qmpack;
+        ~WarmStartGuard() {
+          qmpack->setWarmStart(false);
+        }
+      };
+      WarmStartGuard guard{_qmpack};
+
       int iterCnt = 0;
       int iterMax = _maxIter;
       for (; iterCnt < iterMax; ++iterCnt) {
@@ -53,6 +53,7 @@ namespace votca {
             _cleanup = _xtpdft_options.get(key + ".cleanup").as<std::string> ();
            
             _write_guess=_xtpdft_options.ifExistsReturnElseReturnDefault<bool>(key + ".read_guess", false);
+            _engine.reset();
             
             // check if ECPs are used in xtpdft
             _write_pseudopotentials=false;
@@ -73,23 +74,74 @@ namespace votca {
 
     
         /**
-         * Run calls DFTENGINE
+         * Run calls DFTENGINE, with warm start the engine of the last run is
+         * reused if the atoms are unchanged
          */
         bool XTPDFT::Run( Orbitals& orbitals ) {
+          if (_warm_start && _engine && (_write_charges || !_engine_charges)) {
+            _engine->setLogger(_pLog);
+            if(_write_charges){
+              _engine->setExternalcharges(_PolarSegments);
+            }
+            if (!_engine->PrepareWarmStart(orbitals)) {
+              _engine.reset();
+            }
+          } else {
+            _engine.reset();
+          }
+          if (!_engine) {
+            _engine = std::make_shared<DFTEngine>();
+            _engine->Initialize(_xtpdft_options);
+            _engine->setLogger(_pLog);
+            _engine->setThreads(_threads);
+            _engine->setWithGuess(_write_guess);
+
+            if(_write_charges){
+              _engine->setExternalcharges(_PolarSegments);
+            }
+            _engine_charges = _write_charges;
+            _engine->Prepare( orbitals );
+          }
+          _engine->Evaluate( orbitals );
+          _basisset_name = _engine->getDFTBasisName();
+          if (!_warm_start) {
+            _engine.reset();
+          }
+          if (_save_orbfile) {
+            std::string file_name = _run_dir + "/" + _log_file_name;
+            orbitals.WriteToCpt(file_name);
+          }
+            return true;
+    }
+
+        QMPackage* XTPDFT::Clone() const {
+          XTPDFT* clone = new XTPDFT(*this);
+          clone->_save_orbfile = false;
+          clone->_engine.reset();
+          // the engine moves and recharges the external sites, every clone gets its own
+          clone->_PolarSegments.clear();
+          for (const std::shared_ptr<ctp::PolarSeg>& seg : _PolarSegments) {
+            clone->_PolarSegments.push_back(std::shared_ptr<ctp::PolarSeg>(new ctp::PolarSeg(seg.get(), false)));
+          }
+          return clone;
+        }
+
+        /**
+         * Loads the basis sets of a DFTEngine for the geometry in orbitals and
+         * differentiates the energy of the converged MOs at frozen density, no SCF is run
+         */
+        bool XTPDFT::CalculateSemiNumericalGradient(Orbitals& orbitals, double displacement, Eigen::MatrixX3d& gradient) {
           DFTEngine xtpdft;
           xtpdft.Initialize(_xtpdft_options);
           xtpdft.setLogger(_pLog);
-           
+          xtpdft.setThreads(_threads);
           if(_write_charges){
             xtpdft.setExternalcharges(_PolarSegments);
           }
-          xtpdft.Prepare( orbitals );
-          xtpdft.Evaluate( orbitals );
-          _basisset_name = xtpdft.getDFTBasisName();
-          std::string file_name = _run_dir + "/" + _log_file_name;
-          orbitals.WriteToCpt(file_name);
-            return true;
-    }
+          xtpdft.PrepareSemiNumericalGradient( orbitals );
+          gradient = xtpdft.EvaluateSemiNumericalGradient(orbitals, displacement);
+          return true;
+        }
 
     void XTPDFT::CleanUp() {
       if (_cleanup.size() != 0) {
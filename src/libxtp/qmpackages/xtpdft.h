@@ -25,6 +25,7 @@
 #include <votca/xtp/qmpackage.h>
 #include <votca/xtp/dftengine.h>
 
+#include <memory>
 #include <string>
 
 
@@ -57,13 +58,31 @@ namespace votca {
             bool ParseLogFile(Orbitals& orbitals);
 
             bool ParseOrbitalsFile(Orbitals& orbitals);
-            
+
+            bool CalculateSemiNumericalGradient(Orbitals& orbitals, double displacement, Eigen::MatrixX3d& gradient);
+
+            /// the copy does not write the orbitals file into the run directory
+            QMPackage* Clone() const;
+
+            /// keeps the DFTEngine between runs, which only rebuilds the external multipole terms, switching it off drops the engine
+            void setWarmStart(bool warm_start) {
+                _warm_start = warm_start;
+                if (!_warm_start) {
+                    _engine.reset();
+                }
+            }
+
             void setMultipoleBackground( std::vector<std::shared_ptr<ctp::PolarSeg> > multipoles);
 
         private:
             void WriteChargeOption() { return ;}
             tools::Property _xtpdft_options;
             std::string _cleanup;
+            bool _save_orbfile = true;
+            bool _warm_start = false;
+            // engine of the last run if _warm_start and whether it has external charges
+            std::shared_ptr<DFTEngine> _engine;
+            bool _engine_charges = false;
 
             
         };
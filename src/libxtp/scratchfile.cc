@@ -0,0 +1,64 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <votca/xtp/scratchfile.h>
+#include <fstream>
+#include <stdexcept>
+
+namespace votca {
+  namespace xtp {
+
+    ScratchFile::ScratchFile(const std::string& filename, std::size_t bytes)
+    : _filename(filename), _bytes(bytes) {
+      if (bytes == 0) {
+        throw std::runtime_error("Scratch file " + filename + " would be empty");
+      }
+      {
+        std::filebuf fbuf;
+        if (!fbuf.open(filename.c_str(), std::ios_base::in | std::ios_base::out
+                | std::ios_base::trunc | std::ios_base::binary)) {
+          throw std::runtime_error("Could not create scratch file " + filename);
+        }
+        // sets the size without writing the content, the file stays sparse
+        fbuf.pubseekoff(bytes - 1, std::ios_base::beg);
+        fbuf.sputc(0);
+      }
+      Map(boost::interprocess::read_write);
+    }
+
+    ScratchFile::~ScratchFile() {
+      boost::interprocess::mapped_region().swap(_region);
+      boost::interprocess::file_mapping::remove(_filename.c_str());
+    }
+
+    void ScratchFile::FinishWriting() {
+      _region.flush();
+      Map(boost::interprocess::read_only);
+      return;
+    }
+
+    void ScratchFile::Map(boost::interprocess::mode_t mode) {
+      boost::interprocess::file_mapping mapping(_filename.c_str(), mode);
+      boost::interprocess::mapped_region region(mapping, mode);
+      _region.swap(region);
+      return;
+    }
+
+  }
+}
@@ -0,0 +1,67 @@
+/*
+ *            Copyright 2009-2018 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <votca/xtp/shellpairdata.h>
+#include <votca/xtp/aoshell.h>
+
+namespace votca {
+  namespace xtp {
+
+    void ShellPairData::AddPairs(std::vector<PrimitivePair>& pairs, const AOShell* shell_row, const AOShell* shell_col) {
+      const tools::vec& pos_row = shell_row->getPos();
+      const tools::vec& pos_col = shell_col->getPos();
+      const tools::vec diff = pos_row - pos_col;
+      const double dist2 = diff * diff;
+      for (const AOGaussianPrimitive& gaussian_row : *shell_row) {
+        const double decay_row = gaussian_row.getDecay();
+        for (const AOGaussianPrimitive& gaussian_col : *shell_col) {
+          const double decay_col = gaussian_col.getDecay();
+          PrimitivePair pair;
+          pair.zeta = decay_row + decay_col;
+          pair.xi = decay_row * decay_col / pair.zeta;
+          pair.exparg = pair.xi * dist2;
+          if (pair.exparg > 40.0) {
+            continue;
+          }
+          pair.first = &gaussian_row;
+          pair.second = &gaussian_col;
+          pair.P = (decay_row * pos_row + decay_col * pos_col) / pair.zeta;
+          pairs.push_back(pair);
+        }
+      }
+      return;
+    }
+
+    void ShellPairData::Fill(const std::vector<AOShell*>& shells) {
+      _pairs.clear();
+      _offsets.clear();
+      _offsets.reserve(shells.size() * (shells.size() + 1) / 2 + 1);
+      _offsets.push_back(0);
+      for (unsigned row = 0; row < shells.size(); row++) {
+        for (unsigned col = 0; col <= row; col++) {
+          AddPairs(_pairs, shells[row], shells[col]);
+          _offsets.push_back(_pairs.size());
+        }
+      }
+      _pairs.shrink_to_fit();
+      return;
+    }
+
+  }
+}
@@ -108,7 +108,9 @@ namespace votca {
    }
    
    std::vector<int> Statefilter::CollapseResults(std::vector< std::vector<int> >& results)const{
-     if(results.size()==1){
+     if(results.size()==0){
+       return std::vector<int>(0);
+     }else if(results.size()==1){
        return results[0];
      }else{
       std::vector<int> result=results[0];
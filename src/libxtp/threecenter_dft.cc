@@ -26,15 +26,13 @@ namespace votca {
   namespace xtp {
 
     void TCMatrix_dft::Fill(AOBasis& auxbasis, AOBasis& dftbasis, const Eigen::MatrixXd& V_sqrtm1) {
-
-      for (int i = 0; i < auxbasis.AOBasisSize(); i++) {
-        try {
-          _matrix.push_back(Symmetric_Matrix(dftbasis.AOBasisSize()));
-        } catch (std::bad_alloc& ba) {
-          std::cerr << "Basisset/aux basis too large for 3c calculation. Not enough RAM. Caught bad alloc: " << ba.what() << std::endl;
-          exit(0);
-        }
-
+      _basissize = dftbasis.AOBasisSize();
+      const int npair = (_basissize * (_basissize + 1)) / 2;
+      try {
+        _matrix = Eigen::MatrixXd::Zero(npair, auxbasis.AOBasisSize());
+      } catch (std::bad_alloc& ba) {
+        std::cerr << "Basisset/aux basis too large for 3c calculation. Not enough RAM. Caught bad alloc: " << ba.what() << std::endl;
+        exit(0);
       }
       #pragma omp parallel for schedule(dynamic)
       for (int is = dftbasis.getNumofShells()-1; is >=0; is--) {
@@ -48,17 +46,41 @@ namespace votca {
         FillBlock(block, is, dftbasis, auxbasis);
         int offset = dftshell->getStartIndex();
         for (unsigned i = 0; i < block.size(); ++i) {
-          Eigen::MatrixXd temp =V * block[i];
-          for (int mu = 0; mu < temp.rows(); ++mu) {
-            for (int j = 0; j < temp.cols(); ++j) {
-              _matrix[mu](i + offset, j) = temp(mu, j);
-            }
-          }
+          // row i+offset of the lower triangle is contiguous in packed storage
+          const int row = i + offset;
+          _matrix.middleRows((row * (row + 1)) / 2, row + 1) = (V * block[i]).transpose();
         }
       }
       return;
     }
 
+    Symmetric_Matrix TCMatrix_dft::getDatamatrix(int i)const{
+      Symmetric_Matrix result(_basissize);
+      for (int row = 0; row < _basissize; ++row) {
+        const int start = (row * (row + 1)) / 2;
+        for (int col = 0; col <= row; ++col) {
+          result(row, col) = _matrix(start + col, i);
+        }
+      }
+      return result;
+    }
+
+    Eigen::MatrixXd TCMatrix_dft::getStackedMatrices(int start, int count)const{
+      Eigen::MatrixXd result(count * _basissize, _basissize);
+      #pragma omp parallel for
+      for (int i = 0; i < count; ++i) {
+        for (int row = 0; row < _basissize; ++row) {
+          const int packed = (row * (row + 1)) / 2;
+          for (int col = 0; col <= row; ++col) {
+            const double value = _matrix(packed + col, start + i);
+            result(i * _basissize + row, col) = value;
+            result(i * _basissize + col, row) = value;
+          }
+        }
+      }
+      return result;
+    }
+
     /*
      * Determines the 3-center integrals for a given shell in the aux basis
      * by calculating the 3-center overlap integral of the functions in the
@@ -87,7 +109,8 @@ namespace votca {
             }
           }
 
-          bool nonzero = FillThreeCenterRepBlock(threec_block, shell_aux, left_dftshell, shell_col);
+          bool nonzero = FillThreeCenterRepBlock(threec_block, shell_aux, left_dftshell, shell_col,
+                  dftbasis.getShellPairData().getPairs(shellindex, is));
           if (nonzero) {
 
             for (int left = 0; left < left_dftshell->getNumFunc(); left++) {
@@ -19,11 +19,15 @@
 
 
 #include <votca/xtp/threecenter.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 namespace votca {
   namespace xtp {
 
-    void TCMatrix_gwbse::Initialize(int _basissize, int mmin, int mmax, int nmin, int nmax) {
+    void TCMatrix_gwbse::Initialize(int _basissize, int mmin, int mmax, int nmin, int nmax,
+            const std::string& scratchfile) {
 
       // here as storage indices starting from zero
       _nmin = nmin;
@@ -34,14 +38,23 @@ namespace votca {
       _mtotal = mmax - mmin + 1;
       basissize = _basissize;
 
-      // vector has mtotal elements
-      _matrix.resize(_mtotal);
-
-      // each element is a gwabasis-by-n matrix, initialize to zero
-      for (int i = 0; i < this->get_mtot(); i++) {
-        _matrix[i] = MatrixXfd::Zero(_ntotal,basissize);
+      // mtotal levels, each a n-by-gwabasis matrix, initialized to zero
+      const long levelsize = long(_ntotal) * basissize;
+      _offsets.resize(_mtotal);
+      _rows.assign(_mtotal, _ntotal);
+      for (int i = 0; i < _mtotal; i++) {
+        _offsets[i] = i * levelsize;
+      }
+      if (scratchfile.empty()) {
+        _scratch.reset();
+        _storage.assign(_mtotal * levelsize, 0);
+      } else {
+        // the file is sparse, i.e. zero, until it is filled
+        _storage.clear();
+        _storage.shrink_to_fit();
+        _scratch = std::make_shared<ScratchFile>(scratchfile, _mtotal * levelsize * sizeof (real_gwbse));
       }
-      
+      return;
     }
 
     /*
@@ -49,10 +62,11 @@ namespace votca {
      */
     void TCMatrix_gwbse::Cleanup() {
 
-      for (unsigned i = 0; i < _matrix.size(); i++) {
-        _matrix[ i ].resize(0, 0);
-      }
-      _matrix.clear();
+      _storage.clear();
+      _storage.shrink_to_fit();
+      _scratch.reset();
+      _offsets.clear();
+      _rows.clear();
       return;
     } // TCMatrix::Cleanup
 
@@ -65,22 +79,94 @@ namespace votca {
 #pragma omp parallel for
       for (int i_occ = 0; i_occ < _mtotal; i_occ++) {
     #if (GWBSE_DOUBLE)
-          Eigen::MatrixXd temp= _matrix[ i_occ ]*matrix;
-       _matrix[ i_occ ] = temp;
+          Eigen::MatrixXd temp= (*this)[ i_occ ]*matrix;
+       (*this)[ i_occ ] = temp;
 #else  
-       const Eigen::MatrixXd m = _matrix[ i_occ ].cast<double>();
-       _matrix[ i_occ ].noalias()=(m*matrix).cast<float>();
+       const Eigen::MatrixXd m = (*this)[ i_occ ].cast<double>();
+       (*this)[ i_occ ].noalias()=(m*matrix).cast<float>();
 #endif
        
       }
       return;
     } 
 
+    /*
+     * Levels of source multiplied by matrix, source itself stays unchanged.
+     * Both objects need the same dimensions.
+     */
+    void TCMatrix_gwbse::MultiplyRightWithAuxMatrix(const TCMatrix_gwbse& source, const Eigen::MatrixXd& matrix) {
+      if (source.get_mtot() != _mtotal || source.get_ntot() != _ntotal || source.getAuxDimension() != basissize) {
+        throw std::runtime_error("TCMatrix_gwbse::MultiplyRightWithAuxMatrix: dimensions of source do not match");
+      }
+#pragma omp parallel for
+      for (int i_occ = 0; i_occ < _mtotal; i_occ++) {
+#if (GWBSE_DOUBLE)
+        (*this)[ i_occ ].noalias() = source[ i_occ ] * matrix;
+#else
+        const Eigen::MatrixXd m = source[ i_occ ].cast<double>();
+        (*this)[ i_occ ].noalias() = (m * matrix).cast<float>();
+#endif
+      }
+      return;
+    }
+
+    /*
+     * Like MultiplyRightWithAuxMatrix, but the result has fewer columns.
+     * The levels are compacted in place one after another, level i ends
+     * up in front of its old position, so no level is overwritten before
+     * it has been multiplied.
+     */
+    void TCMatrix_gwbse::ReduceAuxDimension(const Eigen::MatrixXd& matrix) {
+      if (matrix.rows() != basissize || matrix.cols() > basissize) {
+        throw std::runtime_error("TCMatrix_gwbse::ReduceAuxDimension: matrix has to be aux x r with r <= aux");
+      }
+      const int newsize = matrix.cols();
+      long offset = 0;
+      for (int i_occ = 0; i_occ < _mtotal; i_occ++) {
+        const Eigen::MatrixXd temp = (*this)[ i_occ ].cast<double>() * matrix;
+        _offsets[i_occ] = offset;
+        Eigen::Map<MatrixXfd>(data() + offset, _rows[i_occ], newsize) = temp.cast<real_gwbse>();
+        offset += long(_rows[i_occ]) * newsize;
+      }
+      basissize = newsize;
+      if (!_scratch) {
+        _storage.resize(offset);
+        _storage.shrink_to_fit();
+      }
+      return;
+    }
+
+    /*
+     * Truncated eigendecomposition of the aux x aux Gram matrix
+     * G = sum_m M_m^T M_m. Projecting onto the eigenvectors that are kept
+     * removes exactly the sum of the dropped eigenvalues from ||M||^2, so the
+     * smallest eigenvalues are dropped as long as their sum stays below
+     * tolerance^2 x trace(G).
+     */
+    Eigen::MatrixXd TCMatrix_gwbse::TruncatedAuxBasis(double tolerance) const {
+      Eigen::MatrixXd gram = Eigen::MatrixXd::Zero(basissize, basissize);
+      for (int i_occ = 0; i_occ < _mtotal; i_occ++) {
+        const Eigen::MatrixXd level = (*this)[ i_occ ].cast<double>();
+        gram.selfadjointView<Eigen::Upper>().rankUpdate(level.transpose());
+      }
+      Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(gram.selfadjointView<Eigen::Upper>());
+      const Eigen::VectorXd& eigenvalues = es.eigenvalues();
+      const double allowed = tolerance * tolerance * eigenvalues.sum();
+      // eigenvalues are sorted in increasing order
+      double dropped = 0.0;
+      int first = 0;
+      while (first < basissize && dropped + std::max(0.0, eigenvalues(first)) <= allowed) {
+        dropped += std::max(0.0, eigenvalues(first));
+        first++;
+      }
+      return es.eigenvectors().rightCols(basissize - first);
+    }
+
     void TCMatrix_gwbse::Print(std::string _ident) {
 
       for (int k = 0; k < _mtotal; k++) {
         std::cout <<k<<std::endl;
-         std::cout <<this->_matrix[k]<< std::endl;  
+         std::cout <<(*this)[k]<< std::endl;  
       }
       return;
     }
@@ -89,10 +175,16 @@ namespace votca {
      * Fill the 3-center object by looping over shells of GW basis set and
      * calling FillBlock, which calculates all 3-center overlap integrals
      * associated to a particular shell, convoluted with the DFT orbital
-     * coefficients
+     * coefficients. The significant DFT shell pairs are determined once
+     * and shared by all aux shells.
      */
     void TCMatrix_gwbse::Fill(const AOBasis& gwbasis, const AOBasis& dftbasis, const Eigen::MatrixXd& dft_orbitals) {
 
+      const double pair_threshold = 1.e-10;
+      const std::vector< std::pair<int, int> > shellpairs = SignificantShellPairs(dftbasis, pair_threshold);
+      const Eigen::MatrixXd dftm = dft_orbitals.block(0, _mmin, dft_orbitals.rows(), _mtotal);
+      const Eigen::MatrixXd dftn = dft_orbitals.block(0, _nmin, dft_orbitals.rows(), _ntotal);
+
       // loop over all shells in the GW basis and get _Mmn for that shell
 #pragma omp parallel for schedule(guided)//private(_block)
       for (unsigned is = 0; is < gwbasis.getNumofShells(); is++) {
@@ -102,14 +194,15 @@ namespace votca {
           block.push_back(Eigen::MatrixXd::Zero(_ntotal,shell->getNumFunc()));
         }
         // Fill block for this shell (3-center overlap with _dft_basis + multiplication with _dft_orbitals )
-        FillBlock(block, shell, dftbasis, dft_orbitals);
+        FillBlock(block, shell, dftbasis, shellpairs, dftm, dftn);
 
         // put into correct position
         for (int m_level = 0; m_level < this->get_mtot(); m_level++) {
+          Eigen::Map<MatrixXfd> level = (*this)[m_level];
           for (int i_gw = 0; i_gw < shell->getNumFunc(); i_gw++) {
             for (int n_level = 0; n_level < this->get_ntot(); n_level++) {
 
-              _matrix[m_level]( n_level,shell->getStartIndex() + i_gw) = block[m_level](n_level,i_gw);
+              level( n_level,shell->getStartIndex() + i_gw) = block[m_level](n_level,i_gw);
 
             } // n-th DFT orbital
           } // GW basis function in shell
@@ -121,80 +214,100 @@ namespace votca {
     /*
      * Determines the 3-center integrals for a given shell in the GW basis
      * by calculating the 3-center overlap integral of the functions in the
-     * GW shell with ALL functions in the DFT basis set (FillThreeCenterOLBlock),
-     * followed by a convolution of those with the DFT orbital coefficients 
+     * GW shell with the significant pairs of the DFT basis set
+     * (FillThreeCenterRepBlock), followed by a convolution of those with the
+     * DFT orbital coefficients. Each pair block is multiplied with the m
+     * coefficients right away, so only the half transformed
+     * nbasis x mtotal matrices are stored, the dense nbasis x nbasis
+     * integral matrix is never built.
      */
 
-    void TCMatrix_gwbse::FillBlock(std::vector< Eigen::MatrixXd >& block, const AOShell* auxshell, const AOBasis& dftbasis, const Eigen::MatrixXd& dft_orbitals) {
+    void TCMatrix_gwbse::FillBlock(std::vector< Eigen::MatrixXd >& block, const AOShell* auxshell, const AOBasis& dftbasis,
+            const std::vector< std::pair<int, int> >& shellpairs, const Eigen::MatrixXd& dftm, const Eigen::MatrixXd& dftn) {
       tensor3d::extent_gen extents;
-      std::vector<Eigen::MatrixXd> symmstorage;
+      std::vector<Eigen::MatrixXd> halftransformed;
       for (int i = 0; i < auxshell->getNumFunc(); ++i) {
-        symmstorage.push_back(Eigen::MatrixXd::Zero(dftbasis.AOBasisSize(), dftbasis.AOBasisSize()));
+        halftransformed.push_back(Eigen::MatrixXd::Zero(dftbasis.AOBasisSize(), _mtotal));
       }
-      const Eigen::MatrixXd dftm = dft_orbitals.block(0, _mmin, dft_orbitals.rows(), _mtotal);
-      const Eigen::MatrixXd dftn = dft_orbitals.block(0, _nmin, dft_orbitals.rows(), _ntotal);
-      // alpha-loop over the "left" DFT basis function
-      for (unsigned row = 0; row < dftbasis.getNumofShells(); row++) {
-
-        const AOShell* shell_row = dftbasis.getShell(row);
+      for (const std::pair<int, int>& pair : shellpairs) {
+        const AOShell* shell_row = dftbasis.getShell(pair.first);
+        const AOShell* shell_col = dftbasis.getShell(pair.second);
         const int row_start = shell_row->getStartIndex();
-        // ThreecMatrix is symmetric, restrict explicit calculation to triangular matrix
-        for (unsigned col = 0; col <= row; col++) {
-          const AOShell* shell_col = dftbasis.getShell(col);
-          const int col_start = shell_col->getStartIndex();
-
-          tensor3d threec_block(extents[ range(0, auxshell->getNumFunc()) ][ range(0, shell_row->getNumFunc()) ][ range(0, shell_col->getNumFunc())]);
-          for (int i = 0; i < auxshell->getNumFunc(); ++i) {
-            for (int j = 0; j < shell_row->getNumFunc(); ++j) {
-              for (int k = 0; k < shell_col->getNumFunc(); ++k) {
-                threec_block[i][j][k] = 0.0;
-              }
+        const int col_start = shell_col->getStartIndex();
+        const int row_size = shell_row->getNumFunc();
+        const int col_size = shell_col->getNumFunc();
+
+        tensor3d threec_block(extents[ range(0, auxshell->getNumFunc()) ][ range(0, row_size) ][ range(0, col_size)]);
+        for (int i = 0; i < auxshell->getNumFunc(); ++i) {
+          for (int j = 0; j < row_size; ++j) {
+            for (int k = 0; k < col_size; ++k) {
+              threec_block[i][j][k] = 0.0;
             }
           }
+        }
 
-          bool nonzero = FillThreeCenterRepBlock(threec_block, auxshell, shell_row, shell_col);
-          if (nonzero) {
-            for (int _aux = 0; _aux < auxshell->getNumFunc(); _aux++) {
-              for (int _row = 0; _row < shell_row->getNumFunc(); _row++) {
-                for (int _col = 0; _col < shell_col->getNumFunc(); _col++) {
-                  //symmetry
-                  if ((col_start + _col)>(row_start + _row)) {
-                    continue;
-                  }
-                  symmstorage[_aux](row_start + _row, col_start + _col) = threec_block[_aux][_row][_col];
-                } // ROW copy
-              } // COL copy
-            } // AUX copy
+        bool nonzero = FillThreeCenterRepBlock(threec_block, auxshell, shell_row, shell_col,
+                dftbasis.getShellPairData().getPairs(pair.first, pair.second));
+        if (!nonzero) {
+          continue;
+        }
+        Eigen::MatrixXd integrals(row_size, col_size);
+        for (int _aux = 0; _aux < auxshell->getNumFunc(); _aux++) {
+          for (int _row = 0; _row < row_size; _row++) {
+            for (int _col = 0; _col < col_size; _col++) {
+              integrals(_row, _col) = threec_block[_aux][_row][_col];
+            }
           }
-        } // gamma-loop
-      } // alpha-loop
-      for (int k = 0; k < auxshell->getNumFunc(); ++k) {
-        Eigen::MatrixXd& matrix = symmstorage[k];
-        for (int i = 0; i < matrix.rows(); ++i) {
-          for (int j = 0; j < i; ++j) {
-            matrix(j, i) = matrix(i, j);
+          halftransformed[_aux].middleRows(row_start, row_size).noalias() += integrals * dftm.middleRows(col_start, col_size);
+          //symmetry
+          if (pair.first != pair.second) {
+            halftransformed[_aux].middleRows(col_start, col_size).noalias() += integrals.transpose() * dftm.middleRows(row_start, row_size);
           }
-        }
-        Eigen::MatrixXd threec_inMo = dftn.transpose() * matrix*dftm;
+        } // AUX copy
+      } // shell pairs
+      for (int k = 0; k < auxshell->getNumFunc(); ++k) {
+        const Eigen::MatrixXd threec_inMo = dftn.transpose() * halftransformed[k];
         for (int i = 0; i < threec_inMo.cols(); ++i) {
-          for (int j = 0; j < threec_inMo.rows(); ++j) {
-            block[i](j, k) = threec_inMo(j, i);
-          }
+          block[i].col(k) = threec_inMo.col(i);
         }
       }
       return;
     } // TCMatrix::FillBlock
 
     void TCMatrix_gwbse::Prune(int min, int max) {
-        
-
-      _matrix.resize(max + 1);
+      // the remaining levels are moved to the front of the buffer, only
+      // rows up to max are kept. Targets never overlap data still to be moved.
+      const int rows = max + 1;
+      if (max >= int(_offsets.size()) || min < 0) {
+        throw std::runtime_error("TCMatrix_gwbse::Prune: max level outside of stored range");
+      }
+      for (int i = min; i < max + 1; i++) {
+        if (_rows[i] < rows) {
+          throw std::runtime_error("TCMatrix_gwbse::Prune: max level outside of stored range");
+        }
+      }
+      real_gwbse* buffer = data();
+      long offset = 0;
+      _offsets.resize(max + 1);
+      _rows.resize(max + 1);
       // entries until min can be freed
       for (int i = 0; i < min; i++) {
-        _matrix[i].resize(0, 0);
+        _offsets[i] = 0;
+        _rows[i] = 0;
+      }
+      for (int i = min; i < max + 1; i++) {
+        const real_gwbse* source = buffer + _offsets[i];
+        real_gwbse* target = buffer + offset;
+        for (int col = 0; col < basissize; col++) {
+          std::memmove(target + long(col) * rows, source + long(col) * _rows[i], rows * sizeof (real_gwbse));
+        }
+        _offsets[i] = offset;
+        _rows[i] = rows;
+        offset += long(rows) * basissize;
       }
-      for (unsigned i = min; i < _matrix.size(); i++) {
-        _matrix[i].conservativeResize( max + 1,Eigen::NoChange);
+      if (!_scratch) {
+        _storage.resize(offset);
+        _storage.shrink_to_fit();
       }
       return;
     }
@@ -18,6 +18,9 @@
  */
 
 #include <votca/xtp/threecenter.h>
+#include <votca/xtp/cartesianindex.h>
+#include <algorithm>
+#include <array>
 
 using namespace std;
 
@@ -25,6 +28,37 @@ using namespace std;
 namespace votca {
     namespace xtp {
  
+        /*
+         * The product of two shells decays at least like exp(-xi R^2) with
+         * xi=a*b/(a+b) of the most diffuse primitives. The polynomial part of
+         * higher angular momenta is covered by (1+sqrt(xi)R)^(la+lb). Shells
+         * on the same center are always kept, their overlap can vanish by
+         * symmetry while the three-center integrals do not.
+         */
+        std::vector< std::pair<int, int> > TCMatrix::SignificantShellPairs(const AOBasis& dftbasis, double threshold) {
+            std::vector< std::pair<int, int> > pairs;
+            for (unsigned row = 0; row < dftbasis.getNumofShells(); row++) {
+                const AOShell* shell_row = dftbasis.getShell(row);
+                for (unsigned col = 0; col <= row; col++) {
+                    const AOShell* shell_col = dftbasis.getShell(col);
+                    const tools::vec diff = shell_row->getPos() - shell_col->getPos();
+                    const double dist2 = diff * diff;
+                    if (dist2 > 1e-12) {
+                        const double a = shell_row->getMinDecay();
+                        const double b = shell_col->getMinDecay();
+                        const double xi = a * b / (a + b);
+                        const double estimate = std::exp(-xi * dist2)
+                                * std::pow(1.0 + std::sqrt(xi * dist2), shell_row->getLmax() + shell_col->getLmax());
+                        if (estimate < threshold) {
+                            continue;
+                        }
+                    }
+                    pairs.push_back(std::make_pair(int(row), int(col)));
+                }
+            }
+            return pairs;
+        }
+
         
         /*
          * Calculate 3-center electron repulsion integrals 
@@ -42,7 +76,8 @@ namespace votca {
          */
         
       
-        bool TCMatrix::FillThreeCenterRepBlock(tensor3d& threec_block, const AOShell* shell_3, const AOShell* shell_1, const AOShell* shell_2) {
+        bool TCMatrix::FillThreeCenterRepBlockGeneric(tensor3d& threec_block, const AOShell* shell_3, const AOShell* shell_1, const AOShell* shell_2,
+                const ShellPairData::Pairs& pairs) {
 
             const double pi = boost::math::constants::pi<double>();
             const double gwaccuracy = 1.e-11;
@@ -190,25 +225,31 @@ namespace votca {
                    122,124,125,127,128,129,131,132,133,134,136,137,138,139,140,142,143,144,145,146,147,149,150,151,152,153,154,155,157,158,159,160,161,162,163,164 };
 
             
+            // the recursion buffers are allocated once per shell triple and
+            // cleared for every primitive triple
+            tensor3d::extent_gen extents;
+            tensor3d R_temp(extents[ range(0, ncombined ) ][ range(0, ngamma ) ][ range(0, max(2,mmax+1))]);
+            tensor3d R(extents[ range(0, ncombined ) ][ range(0, nbeta ) ][ range(0, ngamma)]);
+
             tools::vec amb=pos_alpha-pos_beta;
             double amb0=amb.getX();
             double amb1=amb.getY();
             double amb2=amb.getZ();
-            double dist3 = amb * amb;
 
-            for ( AOShell::GaussianIterator italpha = shell_alpha->begin(); italpha != shell_alpha->end(); ++italpha){
+            for (const ShellPairData::PrimitivePair& pair : pairs) {
+                // pairs run over the primitives of shell_1 x shell_2
+                const AOGaussianPrimitive* italpha = alphabetaswitch ? pair.second : pair.first;
+                const AOGaussianPrimitive* itbeta = alphabetaswitch ? pair.first : pair.second;
                 const double decay_alpha = italpha->getDecay();
-            
-                for ( AOShell::GaussianIterator itbeta = shell_beta->begin(); itbeta != shell_beta->end(); ++itbeta){
-                    const double decay_beta = itbeta->getDecay();
-                    double rzeta = 0.5 / (decay_alpha+decay_beta);
-                    tools::vec P = 2.0 * (decay_alpha*pos_alpha+decay_beta*pos_beta) * rzeta;
+                const double decay_beta = itbeta->getDecay();
+                    double rzeta = 0.5 / pair.zeta;
+                    const tools::vec& P = pair.P;
                     tools::vec pma = P - pos_alpha;
                     double pma0 = pma.getX();
                     double pma1 = pma.getY();
                     double pma2 = pma.getZ();
-                    double xi = 2.0 * decay_alpha * decay_beta * rzeta;
-                    double fact_alpha_beta = 16.0 * xi * pow(pi / (decay_alpha * decay_beta), 0.25) * exp(-xi * dist3);
+                    double xi = pair.xi;
+                    double fact_alpha_beta = 16.0 * xi * pow(pi / (decay_alpha * decay_beta), 0.25) * exp(-pair.exparg);
                     
                     for ( AOShell::GaussianIterator itgamma = shell_gamma->begin(); itgamma != shell_gamma->end(); ++itgamma){
                         const double decay_gamma = itgamma->getDecay();
@@ -246,31 +287,12 @@ namespace votca {
             double wmc2 = wmc.getZ();
             
           
-            tensor3d::extent_gen extents;
-            tensor3d R_temp;
-            R_temp.resize(extents[ range(0, ncombined ) ][ range(0, ngamma ) ][ range(0, max(2,mmax+1))]);
-            //initialize to zero
-            for (index3d i = 0; i != ncombined; ++i) {
-                for (index3d j = 0; j != ngamma; ++j) { 
-                    for (index3d k = 0; k != mmax+1; ++k) { 
-                                       R_temp[i][j][k] = 0.0;
-                                   }
-                               }
-                           }
-            
-            tensor3d R;
-            R.resize(extents[ range(0, ncombined ) ][ range(0, nbeta ) ][ range(0, ngamma)]);
             //initialize to zero
-            for (index3d i = 0; i != ncombined; ++i) {
-                            for (index3d j = 0; j != nbeta; ++j) {
-                                for (index3d k = 0; k != ngamma; ++k) {
-                                    R[i][j][k] = 0.0;
-                                }
-                            }
-                        }
-
+            std::fill(R_temp.data(), R_temp.data() + R_temp.num_elements(), 0.0);
+            std::fill(R.data(), R.data() + R.num_elements(), 0.0);
 
-            const std::vector<double> FmT=AOMatrix<double>::XIntegrate(mmax+1, U);
+            BoysFunction::Values FmT;
+            BoysFunction::Evaluate(FmT, mmax, U);
 
             //ss integrals
 
@@ -1186,8 +1208,8 @@ if (lmax_beta > 3) {
             int offset_alpha = shell_alpha->getOffset();
             int offset_gamma = shell_gamma->getOffset();
 
-            const Eigen::MatrixXd trafo_beta=AOSuperMatrix::getTrafo(*itbeta);
-            const Eigen::MatrixXd trafo_alpha=AOSuperMatrix::getTrafo(*italpha);
+            const Eigen::MatrixXd& trafo_beta = AOSuperMatrix::getTrafo(*itbeta);
+            const Eigen::MatrixXd& trafo_alpha = AOSuperMatrix::getTrafo(*italpha);
             
        
 
@@ -1229,7 +1251,6 @@ if (lmax_beta > 3) {
 
                 }
             }
-        }
 
  
     
@@ -1241,4 +1262,292 @@ if (lmax_beta > 3) {
         
         
        
+        namespace {
+
+        /*
+         * Vertical recursion on the aux function at fixed m for the cartesians
+         * C...CSTOP-1 and all a,
+         * (a|c+1_d)^m = WC_d (a|c)^(m+1) + N_d(a)/(2(zeta+gamma)) (a-1_d|c)^(m+1)
+         *             + N_d(c)/(2gamma) ((a|c-1_d)^m - zeta/(zeta+gamma) (a|c-1_d)^(m+1))
+         * with (a|c)^m at R_temp[(c*M1+m)*NAB+a]. c and m are template
+         * parameters, so that every step compiles to code with fixed offsets.
+         */
+        template <int NAB, int M1, int M, int C, int CSTOP>
+        struct VerticalStepC {
+            static void Apply(double* R_temp, const double* fak_a, const double* wmc, double rgamma, double cfak) {
+                using namespace CartesianIndex;
+                const int d = direction[C];
+                const int c1 = less[d][C];
+                const int c2 = less[d][c1];
+                const double fak_c = exponent[d][c1] * rgamma;
+                const double* c1_m1 = R_temp + (c1 * M1 + M + 1) * NAB;
+                const double* c2_m = R_temp + (c2 * M1 + M) * NAB;
+                const double* c2_m1 = R_temp + (c2 * M1 + M + 1) * NAB;
+                double* c_m = R_temp + (C * M1 + M) * NAB;
+                for (int a = 0; a < NAB; a++) {
+                    c_m[a] = wmc[d] * c1_m1[a] + fak_a[d * NAB + a] * c1_m1[less[d][a]] + fak_c * (c2_m[a] - cfak * c2_m1[a]);
+                }
+                VerticalStepC<NAB, M1, M, C + 1, CSTOP>::Apply(R_temp, fak_a, wmc, rgamma, cfak);
+            }
+        };
+
+        template <int NAB, int M1, int M, int CSTOP>
+        struct VerticalStepC<NAB, M1, M, CSTOP, CSTOP> {
+            static void Apply(double*, const double*, const double*, double, double) {
+            }
+        };
+
+        // all steps for m=M...0, (a|c)^m is needed up to level LC-m
+        template <int NAB, int M1, int LC, int M>
+        struct VerticalC {
+            static void Apply(double* R_temp, const double* fak_a, const double* wmc, double rgamma, double cfak) {
+                VerticalStepC<NAB, M1, M, 1, CartesianIndex::NumUpTo(LC - M)>::Apply(R_temp, fak_a, wmc, rgamma, cfak);
+                VerticalC<NAB, M1, LC, M - 1>::Apply(R_temp, fak_a, wmc, rgamma, cfak);
+            }
+        };
+
+        template <int NAB, int M1, int LC>
+        struct VerticalC<NAB, M1, LC, -1> {
+            static void Apply(double*, const double*, const double*, double, double) {
+            }
+        };
+
+        /*
+         * (ab|c) for fixed angular momenta LA>=LB of the DFT shells and LC of
+         * the aux shell. The recursions are those of
+         * FillThreeCenterRepBlockGeneric, but with compile-time loop bounds and
+         * index tables, and with the intermediates in fixed size arrays on the
+         * stack, so that the compiler unrolls them for every combination.
+         * The aux functions are transformed to sphericals right after the
+         * vertical recursion, the DFT functions after the horizontal one,
+         * first alpha then beta.
+         */
+        template <int LA, int LB, int LC>
+        struct ThreeCenterKernel {
+            static const int LAB = LA + LB;
+            static const int MMAX = LAB + LC;
+            static const int NAB = CartesianIndex::NumUpTo(LAB);
+            static const int NB = CartesianIndex::NumUpTo(LB);
+            static const int NC = CartesianIndex::NumUpTo(LC);
+            static const int NSPH_A = CartesianIndex::NumSphericalUpTo(LA);
+            static const int NSPH_C = CartesianIndex::NumSphericalUpTo(LC);
+            static_assert(LAB <= CartesianIndex::MaxL && LC <= CartesianIndex::MaxL, "index tables only reach g functions");
+
+            static bool Fill(tensor3d& threec_block, const AOShell* shell_alpha, const AOShell* shell_beta,
+                    const AOShell* shell_gamma, bool alphabetaswitch, const ShellPairData::Pairs& pairs) {
+                using namespace CartesianIndex;
+                const double pi = boost::math::constants::pi<double>();
+                const double gwaccuracy = 1.e-11;
+                bool does_contribute = false;
+
+                const tools::vec& pos_alpha = shell_alpha->getPos();
+                const tools::vec& pos_beta = shell_beta->getPos();
+                const tools::vec& pos_gamma = shell_gamma->getPos();
+                const tools::vec amb_vec = pos_alpha - pos_beta;
+                const double amb[3] = {amb_vec.getX(), amb_vec.getY(), amb_vec.getZ()};
+
+                const int offset_alpha = shell_alpha->getOffset();
+                const int offset_beta = shell_beta->getOffset();
+                const int offset_gamma = shell_gamma->getOffset();
+                const int numfunc_alpha = shell_alpha->getNumFunc();
+                const int numfunc_beta = shell_beta->getNumFunc();
+                const int ntrafo_gamma = shell_gamma->getNumFunc() + offset_gamma;
+                const int start_beta = sph_start[offset_beta];
+
+                // the a index runs fastest everywhere, so that the innermost
+                // loops have a fixed length and contiguous operands
+                // (a|s)^m, a up to LA+LB, m up to MMAX
+                std::array<double, (MMAX + 1) * NAB> R_s;
+                // (a|c)^m, c up to LC, m up to LC
+                std::array<double, NC * (LC + 1) * NAB> R_temp;
+                // (ab|c) with spherical c
+                std::array<double, NSPH_C * NB * NAB> R;
+                // (ab|c) with spherical a and c
+                std::array<double, NSPH_C * NB * NSPH_A> R_alpha;
+
+                auto RS = [&R_s](int a, int m) -> double& {
+                    return R_s[m * NAB + a];
+                };
+                auto RT = [&R_temp](int a, int c, int m) -> double& {
+                    return R_temp[(c * (LC + 1) + m) * NAB + a];
+                };
+                auto RH = [&R](int a, int b, int c) -> double& {
+                    return R[(c * NB + b) * NAB + a];
+                };
+                auto RA = [&R_alpha](int a, int b, int c) -> double& {
+                    return R_alpha[(c * NB + b) * NSPH_A + a];
+                };
+
+                for (const ShellPairData::PrimitivePair& pair : pairs) {
+                    // pairs run over the primitives of shell_1 x shell_2
+                    const AOGaussianPrimitive* italpha = alphabetaswitch ? pair.second : pair.first;
+                    const AOGaussianPrimitive* itbeta = alphabetaswitch ? pair.first : pair.second;
+                    const double decay_alpha = italpha->getDecay();
+                    const double decay_beta = itbeta->getDecay();
+                    const double rzeta = 0.5 / pair.zeta;
+                    const tools::vec& P = pair.P;
+                    const tools::vec pma_vec = P - pos_alpha;
+                    const double pma[3] = {pma_vec.getX(), pma_vec.getY(), pma_vec.getZ()};
+                    const double fact_alpha_beta = 16.0 * pair.xi * pow(pi / (decay_alpha * decay_beta), 0.25) * exp(-pair.exparg);
+                    const Eigen::MatrixXd& trafo_alpha = AOSuperMatrix::getTrafo(*italpha);
+                    const Eigen::MatrixXd& trafo_beta = AOSuperMatrix::getTrafo(*itbeta);
+
+                    for (AOShell::GaussianIterator itgamma = shell_gamma->begin(); itgamma != shell_gamma->end(); ++itgamma) {
+                        const double decay_gamma = itgamma->getDecay();
+                        const double decay = pair.zeta + decay_gamma;
+                        const double rgamma = 0.5 / decay_gamma;
+                        const double rdecay = 0.5 / decay;
+
+                        const double sss = fact_alpha_beta * pow(rdecay * rdecay * rgamma, 0.25);
+                        if (sss < gwaccuracy) {
+                            continue;
+                        }
+                        does_contribute = true;
+
+                        const double gfak = decay_gamma / decay;
+                        const double cfak = pair.zeta / decay;
+                        const tools::vec W = (pair.zeta * P + decay_gamma * pos_gamma) / decay;
+                        const double U = pair.zeta * decay_gamma / decay * (P - pos_gamma)*(P - pos_gamma);
+                        const tools::vec wmp_vec = W - P;
+                        const tools::vec wmc_vec = W - pos_gamma;
+                        const double wmp[3] = {wmp_vec.getX(), wmp_vec.getY(), wmp_vec.getZ()};
+                        const double wmc[3] = {wmc_vec.getX(), wmc_vec.getY(), wmc_vec.getZ()};
+
+                        BoysFunction::Values FmT;
+                        BoysFunction::Evaluate(FmT, MMAX, U);
+                        for (int m = 0; m <= MMAX; m++) {
+                            RS(0, m) = sss * FmT[m];
+                        }
+
+                        // vertical recursion on a, (a+1_d|s)^m is needed up to level MMAX-m
+                        for (int m = MMAX - 1; m >= 0; m--) {
+                            const int a_stop = (NumUpTo(MMAX - m) < NAB) ? NumUpTo(MMAX - m) : NAB;
+                            for (int a = 1; a < a_stop; a++) {
+                                const int d = direction[a];
+                                const int a1 = less[d][a];
+                                const int a2 = less[d][a1];
+                                RS(a, m) = pma[d] * RS(a1, m) + wmp[d] * RS(a1, m + 1)
+                                        + exponent[d][a1] * rzeta * (RS(a2, m) - gfak * RS(a2, m + 1));
+                            }
+                        }
+                        std::copy_n(R_s.begin(), (LC + 1) * NAB, R_temp.begin());
+
+                        // vertical recursion on c, (a|c+1_d)^m is needed up to level LC-m
+                        std::array<double, 3 * NAB> fak_a;
+                        for (int d = 0; d < 3; d++) {
+                            for (int a = 0; a < NAB; a++) {
+                                fak_a[d * NAB + a] = exponent[d][a] * rdecay;
+                            }
+                        }
+                        VerticalC<NAB, LC + 1, LC, LC - 1>::Apply(R_temp.data(), fak_a.data(), wmc, rgamma, cfak);
+
+                        // aux functions to sphericals, the trafo holds the contraction
+                        const Eigen::MatrixXd& trafo_gamma = AOSuperMatrix::getTrafo(*itgamma);
+                        for (int i_gamma = offset_gamma; i_gamma < ntrafo_gamma; i_gamma++) {
+                            for (int a = 0; a < NAB; a++) {
+                                RH(a, 0, i_gamma) = 0.0;
+                            }
+                            for (int j = 0; j < sph_numcart[i_gamma]; j++) {
+                                const int c = sph_cart[i_gamma][j];
+                                const double coeff = trafo_gamma(c, i_gamma);
+                                for (int a = 0; a < NAB; a++) {
+                                    RH(a, 0, i_gamma) += coeff * RT(a, c, 0);
+                                }
+                            }
+                        }
+
+                        // horizontal recursion, (a|b+1_d|c)=(a+1_d|b|c)+AB_d (a|b|c)
+                        for (int b = 1; b < NB; b++) {
+                            const int d = direction[b];
+                            const int b1 = less[d][b];
+                            for (int i_gamma = offset_gamma; i_gamma < ntrafo_gamma; i_gamma++) {
+                                for (int a = 0; a < NumUpTo(LAB - Level(b)); a++) {
+                                    RH(a, b, i_gamma) = RH(more[d][a], b1, i_gamma) + amb[d] * RH(a, b1, i_gamma);
+                                }
+                            }
+                        }
+
+                        // alpha to sphericals
+                        for (int i_gamma = offset_gamma; i_gamma < ntrafo_gamma; i_gamma++) {
+                            for (int b = start_beta; b < NB; b++) {
+                                for (int i_alpha = 0; i_alpha < numfunc_alpha; i_alpha++) {
+                                    const int i_alpha_off = i_alpha + offset_alpha;
+                                    double value = 0.0;
+                                    for (int j = 0; j < sph_numcart[i_alpha_off]; j++) {
+                                        const int a = sph_cart[i_alpha_off][j];
+                                        value += trafo_alpha(a, i_alpha_off) * RH(a, b, i_gamma);
+                                    }
+                                    RA(i_alpha, b, i_gamma) = value;
+                                }
+                            }
+                        }
+
+                        // beta to sphericals and into the block
+                        for (int i_alpha = 0; i_alpha < numfunc_alpha; i_alpha++) {
+                            for (int i_beta = 0; i_beta < numfunc_beta; i_beta++) {
+                                const int i_beta_off = i_beta + offset_beta;
+                                for (int i_gamma = offset_gamma; i_gamma < ntrafo_gamma; i_gamma++) {
+                                    double value = 0.0;
+                                    for (int j = 0; j < sph_numcart[i_beta_off]; j++) {
+                                        const int b = sph_cart[i_beta_off][j];
+                                        value += trafo_beta(b, i_beta_off) * RA(i_alpha, b, i_gamma);
+                                    }
+                                    if (alphabetaswitch) {
+                                        threec_block[i_gamma - offset_gamma][i_beta][i_alpha] += value;
+                                    } else {
+                                        threec_block[i_gamma - offset_gamma][i_alpha][i_beta] += value;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+                return does_contribute;
+            }
+        };
+
+        typedef bool (*ThreeCenterKernelFunction)(tensor3d&, const AOShell*, const AOShell*, const AOShell*,
+                bool, const ShellPairData::Pairs&);
+
+        template <int LA, int LB>
+        ThreeCenterKernelFunction SelectThreeCenterKernel(int lmax_gamma) {
+            switch (lmax_gamma) {
+                case 0: return &ThreeCenterKernel<LA, LB, 0>::Fill;
+                case 1: return &ThreeCenterKernel<LA, LB, 1>::Fill;
+                case 2: return &ThreeCenterKernel<LA, LB, 2>::Fill;
+                case 3: return &ThreeCenterKernel<LA, LB, 3>::Fill;
+                case 4: return &ThreeCenterKernel<LA, LB, 4>::Fill;
+                default: return nullptr;
+            }
+        }
+
+        // kernels exist for s,p,d DFT shells with lmax_alpha>=lmax_beta and s to g aux shells
+        ThreeCenterKernelFunction SelectThreeCenterKernel(int lmax_alpha, int lmax_beta, int lmax_gamma) {
+            switch (3 * lmax_alpha + lmax_beta) {
+                case 0: return SelectThreeCenterKernel<0, 0>(lmax_gamma);
+                case 3: return SelectThreeCenterKernel<1, 0>(lmax_gamma);
+                case 4: return SelectThreeCenterKernel<1, 1>(lmax_gamma);
+                case 6: return SelectThreeCenterKernel<2, 0>(lmax_gamma);
+                case 7: return SelectThreeCenterKernel<2, 1>(lmax_gamma);
+                case 8: return SelectThreeCenterKernel<2, 2>(lmax_gamma);
+                default: return nullptr;
+            }
+        }
+
+        }
+
+        bool TCMatrix::FillThreeCenterRepBlock(tensor3d& threec_block, const AOShell* shell_3, const AOShell* shell_1, const AOShell* shell_2,
+                const ShellPairData::Pairs& pairs) {
+            const bool alphabetaswitch = shell_1->getLmax() < shell_2->getLmax();
+            const AOShell* shell_alpha = alphabetaswitch ? shell_2 : shell_1;
+            const AOShell* shell_beta = alphabetaswitch ? shell_1 : shell_2;
+            const int lmax_alpha = shell_alpha->getLmax();
+            ThreeCenterKernelFunction kernel = (lmax_alpha > 2) ? nullptr
+                    : SelectThreeCenterKernel(lmax_alpha, shell_beta->getLmax(), shell_3->getLmax());
+            if (kernel == nullptr) {
+                return FillThreeCenterRepBlockGeneric(threec_block, shell_3, shell_1, shell_2, pairs);
+            }
+            return kernel(threec_block, shell_alpha, shell_beta, shell_3, alphabetaswitch, pairs);
+        }
+
     }}
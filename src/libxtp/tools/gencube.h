@@ -51,7 +51,7 @@ namespace votca {
 
         private:
 
-            Eigen::VectorXd EvaluateBasisAtPosition(const AOBasis& dftbasis,const tools::vec& pos);
+            Eigen::MatrixXd EvaluateBasisAtPositions(const AOBasis& dftbasis,const Eigen::MatrixX3d& positions);
 
             void calculateCube();
             void subtractCubes();
@@ -239,18 +239,24 @@ namespace votca {
                     double x = xstart + double(ix) * xincr;
                     for (int iy = 0; iy <= _ysteps; iy++) {
                         double y = ystart + double(iy) * yincr;
+                        // all points along z at once
+                        Eigen::MatrixX3d positions(_zsteps + 1, 3);
+                        for (int iz = 0; iz <= _zsteps; iz++) {
+                            positions(iz, 0) = x;
+                            positions(iz, 1) = y;
+                            positions(iz, 2) = zstart + double(iz) * zincr;
+                        }
+                        Eigen::MatrixXd tmat=EvaluateBasisAtPositions(dftbasis,positions);
+                        Eigen::VectorXd values;
+                        if(do_amplitude){
+                            values = tmat * mat.col(amplitudeindex);
+                        }else{
+                            values = (tmat * mat).cwiseProduct(tmat).rowwise().sum();
+                        }
                         int Nrecord = 0;
                         for (int iz = 0; iz <= _zsteps; iz++) {
-                            double z = zstart + double(iz) * zincr;
                             Nrecord++;
-                            vec pos = vec(x, y, z);
-                            Eigen::VectorXd tmat=EvaluateBasisAtPosition(dftbasis,pos);
-                            double value=0.0;
-                            if(do_amplitude){
-                                value = (mat.col(amplitudeindex).transpose() * tmat).value();
-                            }else{  
-                                value = (tmat.transpose() * mat * tmat).value();
-                            }
+                            double value=values(iz);
                             if (Nrecord == 6 || iz == _zsteps) {
                                  out<<boost::format("%1$E \n")% value;
                                 Nrecord = 0;
@@ -267,19 +273,20 @@ namespace votca {
             return;
         }
         
-        Eigen::VectorXd GenCube::EvaluateBasisAtPosition(const AOBasis& dftbasis,const tools::vec& pos){
+        Eigen::MatrixXd GenCube::EvaluateBasisAtPositions(const AOBasis& dftbasis,const Eigen::MatrixX3d& positions){
             
-        // get value of orbitals at each gridpoint
-        Eigen::VectorXd tmat = Eigen::VectorXd::Zero(dftbasis.AOBasisSize());
+        // get value of orbitals at each gridpoint, rows are gridpoints
+        Eigen::MatrixXd tmat = Eigen::MatrixXd::Zero(positions.rows(),dftbasis.AOBasisSize());
         for (const AOShell* shell:dftbasis) {
             const double decay =shell->getMinDecay();
             const tools::vec& shellpos = shell->getPos();
-            tools::vec dist = shellpos - pos;
-            double distsq = dist*dist;
-            // if contribution is smaller than -ln(1e-10), calc density
+            double distsq = ((positions.col(0).array() - shellpos.getX()).square()
+                    + (positions.col(1).array() - shellpos.getY()).square()
+                    + (positions.col(2).array() - shellpos.getZ()).square()).minCoeff();
+            // if contribution is smaller than -ln(1e-10) for all points, skip shell
             if ((decay * distsq) < 20.7) {
-                Eigen::VectorBlock<Eigen::VectorXd> tmat_block = tmat.segment(shell->getStartIndex(), shell->getNumFunc());
-                shell->EvalAOspace(tmat_block, pos);
+                Eigen::Block<Eigen::MatrixXd> tmat_block = tmat.block(0,shell->getStartIndex(),positions.rows(), shell->getNumFunc());
+                shell->EvalAOspace(tmat_block, positions);
             }
         }
         return tmat;
@@ -18,6 +18,7 @@
 #define BOOST_TEST_MODULE aobasis_test
 #include <boost/test/unit_test.hpp>
 #include <votca/xtp/aobasis.h>
+#include <votca/xtp/aoshell.h>
 #include <votca/xtp/aomatrix.h>
 #include <votca/xtp/orbitals.h>
 #include <votca/xtp/convergenceacc.h>
@@ -201,5 +202,76 @@ BOOST_AUTO_TEST_CASE(ReorderMos_test) {
   BOOST_CHECK_EQUAL(check_reorder_nwchem, 1);
 }   
 
+BOOST_AUTO_TEST_CASE(EvalAOspace_batch_test) {
+  // the batched kernels used by the grid boxes have to reproduce the
+  // pointwise evaluation, values and gradients for s to g shells
+  const int npoints = 50;
+  Eigen::MatrixX3d points = Eigen::MatrixX3d::Zero(npoints, 3);
+  for (int p = 0; p < npoints; p++) {
+    points(p, 0) = 1.5 * std::sin(0.7 * p);
+    points(p, 1) = 1.2 * std::cos(1.3 * p) - 0.2;
+    points(p, 2) = 0.05 * p - 1.0;
+  }
+
+  const std::vector<std::string> types = {"S", "P", "D", "F", "G"};
+  for (unsigned l = 0; l < types.size(); l++) {
+    BasisSet bs;
+    Element& element = bs.addElement("C");
+    Shell& shell = element.addShell(types[l], 1.0);
+    std::vector<double> contraction(l + 1, 0.0);
+    contraction[l] = 1.0;
+    for (double decay : {5.0, 1.2, 0.3}) {
+      shell.addGaussian(decay, contraction);
+    }
+    QMAtom atom(0, "C", 0.1, -0.2, 0.3);
+    std::vector<QMAtom*> atoms = {&atom};
+    AOBasis aobasis;
+    aobasis.AOBasisFill(bs, atoms);
+    const AOShell* aoshell = aobasis.getShell(0);
+    const int nfunc = aoshell->getNumFunc();
+
+    Eigen::MatrixXd ao_point = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::MatrixXd grad_x_point = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::MatrixXd grad_y_point = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::MatrixXd grad_z_point = Eigen::MatrixXd::Zero(npoints, nfunc);
+    for (int p = 0; p < npoints; p++) {
+      const votca::tools::vec pos(points(p, 0), points(p, 1), points(p, 2));
+      Eigen::VectorXd values = Eigen::VectorXd::Zero(nfunc);
+      Eigen::MatrixX3d gradients = Eigen::MatrixX3d::Zero(nfunc, 3);
+      Eigen::VectorBlock<Eigen::VectorXd> values_block = values.segment(0, nfunc);
+      Eigen::Block<Eigen::MatrixX3d> gradients_block = gradients.block(0, 0, nfunc, 3);
+      aoshell->EvalAOspace(values_block, gradients_block, pos);
+      ao_point.row(p) = values.transpose();
+      grad_x_point.row(p) = gradients.col(0).transpose();
+      grad_y_point.row(p) = gradients.col(1).transpose();
+      grad_z_point.row(p) = gradients.col(2).transpose();
+    }
+
+    Eigen::MatrixXd ao = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::Block<Eigen::MatrixXd> ao_block = ao.block(0, 0, npoints, nfunc);
+    aoshell->EvalAOspace(ao_block, points);
+    bool check_values = ao.isApprox(ao_point, 1e-10);
+
+    Eigen::MatrixXd ao_grad = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::MatrixXd grad_x = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::MatrixXd grad_y = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::MatrixXd grad_z = Eigen::MatrixXd::Zero(npoints, nfunc);
+    Eigen::Block<Eigen::MatrixXd> ao_grad_block = ao_grad.block(0, 0, npoints, nfunc);
+    Eigen::Block<Eigen::MatrixXd> grad_x_block = grad_x.block(0, 0, npoints, nfunc);
+    Eigen::Block<Eigen::MatrixXd> grad_y_block = grad_y.block(0, 0, npoints, nfunc);
+    Eigen::Block<Eigen::MatrixXd> grad_z_block = grad_z.block(0, 0, npoints, nfunc);
+    aoshell->EvalAOspace(ao_grad_block, grad_x_block, grad_y_block, grad_z_block, points);
+    bool check_gradients = ao_grad.isApprox(ao_point, 1e-10)
+            && grad_x.isApprox(grad_x_point, 1e-10)
+            && grad_y.isApprox(grad_y_point, 1e-10)
+            && grad_z.isApprox(grad_z_point, 1e-10);
+    if (!check_values || !check_gradients) {
+      std::cout << "batched AO evaluation differs for shell " << types[l] << std::endl;
+    }
+    BOOST_CHECK_EQUAL(check_values, 1);
+    BOOST_CHECK_EQUAL(check_gradients, 1);
+  }
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE atomicguesscache_test
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <votca/xtp/atomicguesscache.h>
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(atomicguesscache_test)
+
+BOOST_AUTO_TEST_CASE(store_load) {
+  boost::filesystem::path directory = boost::filesystem::temp_directory_path()
+          / boost::filesystem::unique_path("xtp_guesscache_%%%%-%%%%");
+  AtomicGuessCache cache(directory.string());
+
+  const std::string key = AtomicGuessCache::Key("C", "3-21G", "", "XC_HYB_GGA_XC_PBEH", "medium");
+  Eigen::MatrixXd dmat;
+  BOOST_CHECK_EQUAL(cache.Load(key, dmat), false);
+
+  Eigen::MatrixXd stored = Eigen::MatrixXd::Random(9, 9);
+  stored = stored * stored.transpose();
+  stored(0, 0) = 1.0 / 3.0;
+  BOOST_CHECK_EQUAL(cache.Store(key, stored), true);
+  BOOST_CHECK_EQUAL(cache.Load(key, dmat), true);
+  BOOST_CHECK_EQUAL(dmat.rows(), 9);
+  BOOST_CHECK_EQUAL(dmat.cols(), 9);
+  BOOST_CHECK_EQUAL((dmat - stored).cwiseAbs().maxCoeff(), 0.0);
+
+  // differs only in characters which are replaced in the file name
+  const std::string clash = AtomicGuessCache::Key("C", "3-21G", "", "XC_HYB_GGA_XC PBEH", "medium");
+  BOOST_CHECK_EQUAL(cache.Load(clash, dmat), false);
+  const std::string other = AtomicGuessCache::Key("C", "3-21G", "ecp", "XC_HYB_GGA_XC_PBEH", "medium");
+  BOOST_CHECK_EQUAL(cache.Load(other, dmat), false);
+
+  boost::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
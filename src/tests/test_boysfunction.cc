@@ -0,0 +1,85 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE boysfunction_test
+#include <boost/test/unit_test.hpp>
+#include <votca/xtp/boysfunction.h>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(boysfunction_test)
+
+// series with positive terms only, summed in long double
+long double Reference(int m, long double U) {
+  long double term = 1.0L / (2 * m + 1);
+  long double sum = term;
+  for (int i = 1; term > 1e-22L * sum; i++) {
+    term *= 2.0L * U / (2.0L * m + 2 * i + 1);
+    sum += term;
+  }
+  return std::exp(-U) * sum;
+}
+
+BOOST_AUTO_TEST_CASE(accuracy) {
+  double maxerror = 0.0;
+  BoysFunction::Values FmU;
+  for (int i = 0; i < 2000; i++) {
+    const double U = 0.0311 * i;
+    BoysFunction::Evaluate(FmU, BoysFunction::MaxOrder, U);
+    for (int m = 0; m <= BoysFunction::MaxOrder; m++) {
+      const long double ref = Reference(m, U);
+      maxerror = std::max(maxerror, double(std::abs((FmU[m] - ref) / ref)));
+    }
+  }
+  BOOST_CHECK_LT(maxerror, 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(closed_form) {
+  const double pi = boost::math::constants::pi<double>();
+  BoysFunction::Values FmU;
+  BoysFunction::Evaluate(FmU, 2, 0.0);
+  BOOST_CHECK_CLOSE(FmU[0], 1.0, 1e-10);
+  BOOST_CHECK_CLOSE(FmU[1], 1.0 / 3.0, 1e-10);
+  BOOST_CHECK_CLOSE(FmU[2], 1.0 / 5.0, 1e-10);
+  for (double U : {0.04, 1.7, 12.3, 35.99, 36.0, 80.0}) {
+    BoysFunction::Evaluate(FmU, 0, U);
+    BOOST_CHECK_CLOSE(FmU[0], 0.5 * std::sqrt(pi / U) * std::erf(std::sqrt(U)), 1e-10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(batch) {
+  Eigen::VectorXd U = 25.0 * (Eigen::VectorXd::Random(500).array() + 1.0);
+  const int mmax = 9;
+  Eigen::MatrixXd batch;
+  BoysFunction::Evaluate(batch, mmax, U);
+  BOOST_CHECK_EQUAL(batch.rows(), 500);
+  BOOST_CHECK_EQUAL(batch.cols(), mmax + 1);
+  BoysFunction::Values FmU;
+  double maxerror = 0.0;
+  for (int i = 0; i < U.size(); i++) {
+    BoysFunction::Evaluate(FmU, mmax, U(i));
+    for (int m = 0; m <= mmax; m++) {
+      maxerror = std::max(maxerror, std::abs(batch(i, m) - FmU[m]) / FmU[m]);
+    }
+  }
+  BOOST_CHECK_LT(maxerror, 1e-14);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -291,7 +291,101 @@ if(!check_tpsi){
 }
 BOOST_CHECK_EQUAL(check_tpsi, true);
 
-  
+// matrix-free operator has to reproduce the dense Hamiltonians
+bse.SetupHs();
+bse.SetupHt();
+MatrixXfd Hs_operator=bse.getOperator(2.0,0.0).Dense();
+MatrixXfd Ht_operator=bse.getOperator(0.0,0.0).Dense();
+bool check_hs=Hs_operator.isApprox(orbitals.eh_s(),1e-4);
+if(!check_hs){
+    cout<<"Hs operator"<<endl;
+    cout<<Hs_operator<<endl;
+    cout<<"Hs dense"<<endl;
+    cout<<orbitals.eh_s()<<endl;
+}
+BOOST_CHECK_EQUAL(check_hs, true);
+bool check_ht=Ht_operator.isApprox(orbitals.eh_t(),1e-4);
+BOOST_CHECK_EQUAL(check_ht, true);
+
+Eigen::VectorXd diag_ref=orbitals.eh_s().diagonal().cast<double>();
+bool check_diag=bse.getOperator(2.0,0.0).diagonal().isApprox(diag_ref,1e-4);
+BOOST_CHECK_EQUAL(check_diag, true);
+
+bse.configureDavidson(true,1e-7,100);
+bse.Solve_triplets();
+bool check_te_davidson=te_ref.isApprox(orbitals.BSETripletEnergies(),0.001);
+if(!check_te_davidson){
+    cout<<"Triplet energy Davidson"<<endl;
+    cout<<orbitals.BSETripletEnergies()<<endl;
+}
+BOOST_CHECK_EQUAL(check_te_davidson, true);
+
+// Davidson on (A-B)(A+B) has to reproduce the dense BTDA, X and Y up to a common sign
+orbitals.setTDAApprox(false);
+bse.configureDavidson(false,1e-7,100);
+bse.Solve_singlets_BTDA();
+VectorXfd se_btda_dense=orbitals.BSESingletEnergies();
+MatrixXfd X_btda_dense=orbitals.BSESingletCoefficients();
+MatrixXfd Y_btda_dense=orbitals.BSESingletCoefficientsAR();
+bse.configureDavidson(true,1e-7,100);
+bse.Solve_singlets_BTDA();
+bool check_se_btda_davidson=se_btda_dense.isApprox(orbitals.BSESingletEnergies(),1e-4);
+if(!check_se_btda_davidson){
+    cout<<"Singlets energy BTDA Davidson"<<endl;
+    cout<<orbitals.BSESingletEnergies()<<endl;
+    cout<<"Singlets energy BTDA dense"<<endl;
+    cout<<se_btda_dense<<endl;
+}
+BOOST_CHECK_EQUAL(check_se_btda_davidson, true);
+bool check_spsi_btda_davidson=true;
+for(int i=0;i<X_btda_dense.cols();i++){
+  double sign=(X_btda_dense.col(i).dot(orbitals.BSESingletCoefficients().col(i))>0) ? 1.0 : -1.0;
+  double diff_X=(sign*orbitals.BSESingletCoefficients().col(i)-X_btda_dense.col(i)).cwiseAbs().maxCoeff();
+  double diff_Y=(sign*orbitals.BSESingletCoefficientsAR().col(i)-Y_btda_dense.col(i)).cwiseAbs().maxCoeff();
+  if(diff_X>1e-3 || diff_Y>1e-3){
+    cout<<"Singlets psi BTDA Davidson "<<i<<" max deviation X "<<diff_X<<" Y "<<diff_Y<<endl;
+    check_spsi_btda_davidson=false;
+  }
+}
+BOOST_CHECK_EQUAL(check_spsi_btda_davidson, true);
+
+// a tile memory far below a single tile forces tiles of width 1 in Add_Hd, Add_Hd2 and Add_Hx
+MatrixXfd Hs_single_tile=orbitals.eh_s();
+MatrixXfd Ht_single_tile=orbitals.eh_t();
+bse.setTileMemory(1e-6);
+bse.SetupHs();
+bse.SetupHt();
+bool check_hs_tiled=Hs_single_tile.isApprox(orbitals.eh_s(),1e-5);
+if(!check_hs_tiled){
+    cout<<"Hs tiled"<<endl;
+    cout<<orbitals.eh_s()<<endl;
+    cout<<"Hs single tile"<<endl;
+    cout<<Hs_single_tile<<endl;
+}
+BOOST_CHECK_EQUAL(check_hs_tiled, true);
+bool check_ht_tiled=Ht_single_tile.isApprox(orbitals.eh_t(),1e-5);
+BOOST_CHECK_EQUAL(check_ht_tiled, true);
+bse.configureDavidson(false,1e-7,100);
+bse.Solve_singlets_BTDA();
+bool check_se_btda_tiled=se_btda_dense.isApprox(orbitals.BSESingletEnergies(),1e-5);
+if(!check_se_btda_tiled){
+    cout<<"Singlets energy BTDA tiled"<<endl;
+    cout<<orbitals.BSESingletEnergies()<<endl;
+}
+BOOST_CHECK_EQUAL(check_se_btda_tiled, true);
+bool check_spsi_btda_tiled=true;
+for(int i=0;i<X_btda_dense.cols();i++){
+  double sign=(X_btda_dense.col(i).dot(orbitals.BSESingletCoefficients().col(i))>0) ? 1.0 : -1.0;
+  double diff_X=(sign*orbitals.BSESingletCoefficients().col(i)-X_btda_dense.col(i)).cwiseAbs().maxCoeff();
+  double diff_Y=(sign*orbitals.BSESingletCoefficientsAR().col(i)-Y_btda_dense.col(i)).cwiseAbs().maxCoeff();
+  if(diff_X>1e-4 || diff_Y>1e-4){
+    cout<<"Singlets psi BTDA tiled "<<i<<" max deviation X "<<diff_X<<" Y "<<diff_Y<<endl;
+    check_spsi_btda_tiled=false;
+  }
+}
+BOOST_CHECK_EQUAL(check_spsi_btda_tiled, true);
+bse.setTileMemory(256.0);
+orbitals.setTDAApprox(true);
   
 }
 
@@ -26,6 +26,20 @@ using namespace std;
 
 BOOST_AUTO_TEST_SUITE(convergenceacc_test)
 
+// a few accelerated iterations with the model Fock matrix H+0.2*S*D*S
+Eigen::MatrixXd ModelSCF(ConvergenceAcc& d, const Eigen::MatrixXd& H, const Eigen::MatrixXd& S) {
+  Eigen::VectorXd MOEnergies;
+  Eigen::MatrixXd MOCoeffs;
+  d.SolveFockmatrix(MOEnergies, MOCoeffs, H);
+  Eigen::MatrixXd dmat = d.DensityMatrix(MOCoeffs, MOEnergies);
+  for (int i = 0; i < 6; i++) {
+    Eigen::MatrixXd F = H + 0.2 * S * dmat * S;
+    double totE = 0.5 * dmat.cwiseProduct(H + F).sum();
+    dmat = d.Iterate(dmat, F, MOEnergies, MOCoeffs, totE);
+  }
+  return dmat;
+}
+
 BOOST_AUTO_TEST_CASE(levelshift_test) {
    
 ofstream xyzfile("molecule.xyz");
@@ -127,6 +141,86 @@ BOOST_CHECK_EQUAL(check_level, 1);
 
 }
 
+BOOST_AUTO_TEST_CASE(reset_test) {
+
+  ofstream xyzfile("methane_reset.xyz");
+  xyzfile << " 5" << endl;
+  xyzfile << " methane" << endl;
+  xyzfile << " C            .000000     .000000     .000000" << endl;
+  xyzfile << " H            .629118     .629118     .629118" << endl;
+  xyzfile << " H           -.629118    -.629118     .629118" << endl;
+  xyzfile << " H            .629118    -.629118    -.629118" << endl;
+  xyzfile << " H           -.629118     .629118    -.629118" << endl;
+  xyzfile.close();
+
+  ofstream basisfile("minimal.xml");
+  basisfile << "<basis name=\"minimal\">" << endl;
+  basisfile << "  <element name=\"H\">" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << endl;
+  basisfile << "      <constant decay=\"5.000000e-01\">" << endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "  </element>" << endl;
+  basisfile << "  <element name=\"C\">" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << endl;
+  basisfile << "      <constant decay=\"1.000000e+00\">" << endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"P\">" << endl;
+  basisfile << "      <constant decay=\"5.000000e-01\">" << endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"P\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "  </element>" << endl;
+  basisfile << "</basis>" << endl;
+  basisfile.close();
+
+  Orbitals orbitals;
+  orbitals.LoadFromXYZ("methane_reset.xyz");
+  BasisSet basis;
+  basis.LoadBasisSet("minimal.xml");
+  AOBasis aobasis;
+  aobasis.AOBasisFill(basis, orbitals.QMAtoms());
+  AOOverlap overlap;
+  overlap.Fill(aobasis);
+  AOKinetic kinetic;
+  kinetic.Fill(aobasis);
+  AOESP esp;
+  esp.Fillnucpotential(aobasis, orbitals.QMAtoms());
+  Eigen::MatrixXd H = kinetic.Matrix() + esp.getNuclearpotential();
+  const Eigen::MatrixXd& S = overlap.Matrix();
+
+  votca::ctp::Logger log(votca::ctp::logERROR);
+  ConvergenceAcc fresh;
+  fresh.setLogger(&log);
+  fresh.Configure(ConvergenceAcc::closed, true, false, 4, false, 0, 1000, 0, 0, 10, 0.7);
+  fresh.setOverlap(&overlap, 1e-8);
+  Eigen::MatrixXd dmat_fresh = ModelSCF(fresh, H, S);
+
+  // a run on another Hamiltonian fills the history, after Reset it must be gone
+  ConvergenceAcc reused;
+  reused.setLogger(&log);
+  reused.Configure(ConvergenceAcc::closed, true, false, 4, false, 0, 1000, 0, 0, 10, 0.7);
+  reused.setOverlap(&overlap, 1e-8);
+  Eigen::MatrixXd H_other = H + 0.3 * Eigen::MatrixXd::Identity(H.rows(), H.cols());
+  ModelSCF(reused, H_other, S);
+  reused.Reset();
+  Eigen::MatrixXd dmat_reused = ModelSCF(reused, H, S);
+
+  bool check_reset = dmat_reused.isApprox(dmat_fresh, 1e-10);
+  if (!check_reset) {
+    cout << "fresh" << endl;
+    cout << dmat_fresh << endl;
+    cout << "after Reset" << endl;
+    cout << dmat_reused << endl;
+  }
+  BOOST_CHECK_EQUAL(check_reset, 1);
+  BOOST_CHECK_EQUAL(reused.getUseMixing(), fresh.getUseMixing());
+  BOOST_CHECK_EQUAL(reused.getDIIsError(), fresh.getDIIsError());
+}
+
 
 
 BOOST_AUTO_TEST_SUITE_END()
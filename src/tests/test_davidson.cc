@@ -0,0 +1,106 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE davidson_test
+#include <boost/test/unit_test.hpp>
+#include <votca/xtp/davidsonsolver.h>
+
+using namespace votca::xtp;
+
+// minimal operator wrapper around a dense matrix
+struct DenseOperator {
+  DenseOperator(const Eigen::MatrixXd& mat) : _mat(mat){};
+  int rows() const { return _mat.rows(); }
+  Eigen::VectorXd diagonal() const { return _mat.diagonal(); }
+  Eigen::MatrixXd matmul(const Eigen::MatrixXd& X) const { return _mat * X; }
+  const Eigen::MatrixXd& _mat;
+};
+
+// diagonally dominant like a BSE Hamiltonian
+Eigen::MatrixXd TestMatrix(int size) {
+  Eigen::MatrixXd mat = 0.01 * Eigen::MatrixXd::Random(size, size);
+  for (int i = 0; i < size; ++i) {
+    mat(i, i) = 0.3 + 0.01 * i;
+  }
+  return mat;
+}
+
+BOOST_AUTO_TEST_SUITE(davidson_test)
+
+BOOST_AUTO_TEST_CASE(davidson_symmetric) {
+  int size = 200;
+  int neigen = 5;
+  Eigen::MatrixXd mat = TestMatrix(size);
+  Eigen::MatrixXd sym = 0.5 * (mat + mat.transpose());
+
+  DavidsonSolver ds;
+  ds.setTolerance(1e-9);
+  ds.setMaxIterations(100);
+  ds.solve(DenseOperator(sym), neigen);
+  BOOST_CHECK_EQUAL(ds.Info(), true);
+
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(sym);
+  Eigen::VectorXd ref = es.eigenvalues().head(neigen);
+  bool check_eigenvalues = ds.eigenvalues().isApprox(ref, 1e-8);
+  if (!check_eigenvalues) {
+    std::cout << "ref" << std::endl;
+    std::cout << ref << std::endl;
+    std::cout << "result" << std::endl;
+    std::cout << ds.eigenvalues() << std::endl;
+  }
+  BOOST_CHECK_EQUAL(check_eigenvalues, true);
+
+  for (int i = 0; i < neigen; ++i) {
+    double overlap = std::abs(ds.eigenvectors().col(i).dot(es.eigenvectors().col(i)));
+    BOOST_CHECK_CLOSE(overlap, 1.0, 1e-4);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(davidson_nonsymmetric) {
+  int size = 150;
+  int neigen = 4;
+  // product of two symmetric positive definite matrices has a real spectrum
+  Eigen::MatrixXd a = TestMatrix(size);
+  Eigen::MatrixXd b = TestMatrix(size);
+  Eigen::MatrixXd mat = (0.5 * (a + a.transpose())) * (0.5 * (b + b.transpose()));
+
+  DavidsonSolver ds;
+  ds.setMatrixType(DavidsonSolver::NONSYMMETRIC);
+  ds.setTolerance(1e-9);
+  ds.setMaxIterations(100);
+  ds.solve(DenseOperator(mat), neigen);
+  BOOST_CHECK_EQUAL(ds.Info(), true);
+
+  Eigen::EigenSolver<Eigen::MatrixXd> es(mat);
+  Eigen::VectorXd all = es.eigenvalues().real();
+  std::sort(all.data(), all.data() + all.size());
+  Eigen::VectorXd ref = all.head(neigen);
+  bool check_eigenvalues = ds.eigenvalues().isApprox(ref, 1e-8);
+  if (!check_eigenvalues) {
+    std::cout << "ref" << std::endl;
+    std::cout << ref << std::endl;
+    std::cout << "result" << std::endl;
+    std::cout << ds.eigenvalues() << std::endl;
+  }
+  BOOST_CHECK_EQUAL(check_eigenvalues, true);
+
+  Eigen::MatrixXd residual = mat * ds.eigenvectors()
+          - ds.eigenvectors() * ds.eigenvalues().asDiagonal();
+  BOOST_CHECK_EQUAL(residual.colwise().norm().maxCoeff() < 1e-8, true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -24,6 +24,17 @@ using namespace votca::xtp;
 
 BOOST_AUTO_TEST_SUITE(diis_test)
 
+// antisymmetric like the commutator FDS-SDF, different for every step
+Eigen::MatrixXd ErrorMatrix(int step) {
+  Eigen::MatrixXd error = Eigen::MatrixXd::Zero(4, 4);
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      error(i, j) = std::sin(1.0 + step + 3 * i + j) / (step + 1);
+    }
+  }
+  return error - error.transpose();
+}
+
 BOOST_AUTO_TEST_CASE(coeffs_test) {
   
   
@@ -106,4 +117,32 @@ BOOST_CHECK_EQUAL(check_diis, 1);
 
 }
 
+BOOST_AUTO_TEST_CASE(reset_test) {
+
+  DIIS fresh;
+  fresh.setHistLength(5);
+  for (int step = 3; step < 6; step++) {
+    fresh.Update(0, ErrorMatrix(step));
+  }
+  Eigen::VectorXd coeffs_fresh = fresh.CalcCoeff();
+
+  // the errors of a previous run must not enter the coefficients after Reset
+  DIIS reused;
+  reused.setHistLength(5);
+  for (int step = 0; step < 4; step++) {
+    reused.Update(0, ErrorMatrix(step));
+  }
+  reused.CalcCoeff();
+  reused.Reset();
+  for (int step = 3; step < 6; step++) {
+    reused.Update(0, ErrorMatrix(step));
+  }
+  Eigen::VectorXd coeffs_reused = reused.CalcCoeff();
+
+  BOOST_CHECK_EQUAL(coeffs_reused.size(), 3);
+  bool check_reset = coeffs_reused.size() == coeffs_fresh.size() && coeffs_reused.isApprox(coeffs_fresh, 1e-10);
+  BOOST_CHECK_EQUAL(check_reset, 1);
+  BOOST_CHECK_EQUAL(reused.Info(), fresh.Info());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
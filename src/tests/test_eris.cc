@@ -19,6 +19,7 @@
 #include <boost/test/unit_test.hpp>
 #include <votca/xtp/ERIs.h>
 #include <votca/xtp/convergenceacc.h>
+#include <votca/xtp/fourcenter.h>
 
 using namespace votca::xtp;
 using namespace std;
@@ -379,6 +380,103 @@ BOOST_AUTO_TEST_CASE(fourcenter_direct){
   }
   BOOST_CHECK_EQUAL(check_eris, 1);
 
+  ERIs eris3;
+  eris3.Initialize_4c_screening(aobasis,1e-10);
+  eris3.Initialize_4c_disk(aobasis,"fourcenter_disk.scratch");
+  eris3.CalculateERIs_4c_small_molecule(dmat);
+  bool check_disk=eris3.getERIs().isApprox(eris2.getERIs(),0.001);
+  BOOST_CHECK_EQUAL(check_disk, 1);
+
+  eris2.CalculateEXX_4c_small_molecule(dmat);
+  eris3.CalculateEXX_4c_small_molecule(dmat);
+  bool check_disk_exx=eris3.getEXX().isApprox(eris2.getEXX(),0.001);
+  BOOST_CHECK_EQUAL(check_disk_exx, 1);
+
+  // the file is read back in batches, a second build must give the same result
+  eris3.CalculateERIs_4c_small_molecule(dmat);
+  bool check_disk_replay=eris3.getERIs().isApprox(eris2.getERIs(),0.001);
+  BOOST_CHECK_EQUAL(check_disk_replay, 1);
+
+  // J from density differences has to follow the full build over an SCF like
+  // sequence of densities, steps 1-3 are incremental and step 4 is a rebuild
+  Eigen::MatrixXd perturbation=Eigen::MatrixXd::Zero(17,17);
+  for(int i=0;i<17;i++){
+    for(int j=0;j<17;j++){
+      perturbation(i,j)=0.01*std::cos(double(i+j));
+    }
+  }
+  ERIs eris4;
+  eris4.Initialize_4c_screening(aobasis,1e-10);
+  eris4.setIncrementalRebuild(3);
+  for(int step=0;step<7;step++){
+    Eigen::MatrixXd dmat_step=dmat+perturbation/double(step+1);
+    eris1.CalculateERIs_4c_direct(aobasis,dmat_step);
+    eris4.CalculateERIs_4c_direct_incremental(aobasis,dmat_step);
+    bool check_incremental=eris4.getERIs().isApprox(eris1.getERIs(),1e-6);
+    if(!check_incremental){
+      std::cout<<"incremental J step "<<step<<std::endl;
+      std::cout<<eris4.getERIs()<<std::endl;
+      std::cout<<eris1.getERIs()<<std::endl;
+    }
+    BOOST_CHECK_EQUAL(check_incremental, 1);
+  }
+
+}
+
+BOOST_AUTO_TEST_CASE(fourcenter_specialised){
+  // s,p,d and sp shells on four atoms, the last one close enough to the
+  // first to be treated as the same centre
+  const std::vector<std::string> types = {"S", "P", "D"};
+  BasisSet basis;
+  Element& element = basis.addElement("C");
+  for (unsigned l = 0; l < types.size(); l++) {
+    std::vector<double> contraction(l + 1, 0.0);
+    contraction[l] = 1.0;
+    Shell& shell = element.addShell(types[l], 1.0);
+    shell.addGaussian(8.0, contraction);
+    shell.addGaussian(1.5, contraction);
+    shell.addGaussian(0.35, contraction);
+  }
+  Shell& spshell = element.addShell("SP", 1.0);
+  spshell.addGaussian(2.0, {0.4, 0.7});
+  spshell.addGaussian(0.5, {0.6, 0.3});
+
+  QMAtom atom_a(0, "C", 0.0, 0.0, 0.0);
+  QMAtom atom_b(1, "C", 1.4, 1.1, -0.3);
+  QMAtom atom_c(2, "C", -0.6, 1.9, 0.8);
+  QMAtom atom_d(3, "C", 0.1, 0.05, 0.0);
+  std::vector<QMAtom*> atoms = {&atom_a, &atom_b, &atom_c, &atom_d};
+  AOBasis aobasis;
+  aobasis.AOBasisFill(basis, atoms);
+  const int nshells = 4;
+
+  // atoms of the four shells
+  const int patterns[][4] = {{0, 1, 2, 3}, {0, 0, 1, 1}, {1, 2, 1, 0}, {0, 3, 1, 2}};
+  FCMatrix fcmatrix;
+  tensor4d::extent_gen extents;
+  double maxdiff = 0.0;
+  for (const auto& pattern : patterns) {
+    for (int combination = 0; combination < nshells * nshells * nshells * nshells; combination++) {
+      const AOShell* shells[4];
+      int rest = combination;
+      for (int i = 0; i < 4; i++) {
+        shells[i] = aobasis.getShell(nshells * pattern[i] + rest % nshells);
+        rest /= nshells;
+      }
+      tensor4d block(extents[shells[0]->getNumFunc()][shells[1]->getNumFunc()]
+              [shells[2]->getNumFunc()][shells[3]->getNumFunc()]);
+      tensor4d block_generic(extents[shells[0]->getNumFunc()][shells[1]->getNumFunc()]
+              [shells[2]->getNumFunc()][shells[3]->getNumFunc()]);
+      std::fill_n(block.data(), block.num_elements(), 0.0);
+      std::fill_n(block_generic.data(), block_generic.num_elements(), 0.0);
+      fcmatrix.FillFourCenterRepBlock(block, shells[0], shells[1], shells[2], shells[3]);
+      fcmatrix.FillFourCenterRepBlockGeneric(block_generic, shells[0], shells[1], shells[2], shells[3]);
+      for (unsigned i = 0; i < block.num_elements(); i++) {
+        maxdiff = std::max(maxdiff, std::abs(block.data()[i] - block_generic.data()[i]));
+      }
+    }
+  }
+  BOOST_CHECK_SMALL(maxdiff, 1e-12);
 }
         
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,390 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE forces_test
+#include <boost/test/unit_test.hpp>
+#include <votca/xtp/forces.h>
+#include <votca/xtp/orbitals.h>
+#include <votca/xtp/gwbseengine.h>
+#include <votca/xtp/qmpackagefactory.h>
+#include <votca/tools/property.h>
+#include <fstream>
+#include <memory>
+
+using namespace votca::xtp;
+using namespace votca;
+using namespace std;
+
+// QM package with an analytic energy, cheap enough to compare the ways Forces runs the displaced calculations
+class AnalyticQMPackage : public QMPackage {
+public:
+  std::string getPackageName() {
+    return "analytic";
+  }
+  void Initialize(tools::Property& options) {
+    return;
+  }
+  bool WriteInputFile(Orbitals& orbitals) {
+    return true;
+  }
+  bool Run(Orbitals& orbitals) {
+    const std::vector<QMAtom*>& atoms = orbitals.QMAtoms();
+    double energy = 0.0;
+    for (unsigned i = 0; i < atoms.size(); i++) {
+      for (unsigned j = i + 1; j < atoms.size(); j++) {
+        double distance = abs(atoms[i]->getPos() - atoms[j]->getPos());
+        energy += 0.5 * (distance - 1.8) * (distance - 1.8);
+      }
+      double z = atoms[i]->getPos().getZ();
+      energy += 0.01 * (i + 1) * z * z * z;
+    }
+    orbitals.setQMEnergy(energy * tools::conv::hrt2ev);
+    return true;
+  }
+  bool ParseLogFile(Orbitals& orbitals) {
+    return true;
+  }
+  bool ParseOrbitalsFile(Orbitals& orbitals) {
+    return true;
+  }
+  void CleanUp() {
+    return;
+  }
+  QMPackage* Clone() const {
+    return new AnalyticQMPackage(*this);
+  }
+protected:
+  void WriteChargeOption() {
+    return;
+  }
+};
+
+// water with an ECP on oxygen and a hybrid functional for the xtp package
+void WriteWaterInput() {
+
+  ofstream xyzfile("h2o.xyz");
+  xyzfile << " 3" << endl;
+  xyzfile << " water, slightly distorted" << endl;
+  xyzfile << " O            .000000     .000000     .119262" << endl;
+  xyzfile << " H            .000000     .800000    -.450000" << endl;
+  xyzfile << " H            .050000    -.750000    -.500000" << endl;
+  xyzfile.close();
+
+  ofstream basisfile("ecpbasis.xml");
+  basisfile << "<basis name=\"ubecp\">" << endl;
+  basisfile << "  <element name=\"O\">" << endl;
+  for (double decay : {47.105518, 5.911346, 0.976483, 0.296070}) {
+    basisfile << "    <shell type=\"S\" scale=\"1.0\">" << endl;
+    basisfile << "      <constant decay=\"" << decay << "\">" << endl;
+    basisfile << "        <contractions type=\"S\" factor=\"1.0\"/>" << endl;
+    basisfile << "      </constant>" << endl;
+    basisfile << "    </shell>" << endl;
+  }
+  for (double decay : {16.692219, 3.900702, 1.078253, 0.284189, 0.070200}) {
+    basisfile << "    <shell type=\"P\" scale=\"1.0\">" << endl;
+    basisfile << "      <constant decay=\"" << decay << "\">" << endl;
+    basisfile << "        <contractions type=\"P\" factor=\"1.0\"/>" << endl;
+    basisfile << "      </constant>" << endl;
+    basisfile << "    </shell>" << endl;
+  }
+  basisfile << "  </element>" << endl;
+  basisfile << "  <element name=\"H\">" << endl;
+  for (double decay : {33.865, 5.09479, 1.15879, 0.32584, 0.102741}) {
+    basisfile << "    <shell type=\"S\" scale=\"1.0\">" << endl;
+    basisfile << "      <constant decay=\"" << decay << "\">" << endl;
+    basisfile << "        <contractions type=\"S\" factor=\"1.0\"/>" << endl;
+    basisfile << "      </constant>" << endl;
+    basisfile << "    </shell>" << endl;
+  }
+  basisfile << "  </element>" << endl;
+  basisfile << "</basis>" << endl;
+  basisfile.close();
+
+  ofstream auxbasisfile("auxbasis.xml");
+  auxbasisfile << "<basis name=\"aux\">" << endl;
+  auxbasisfile << "  <element name=\"O\">" << endl;
+  for (double decay : {20.0, 5.0, 1.2, 0.3}) {
+    auxbasisfile << "    <shell type=\"S\" scale=\"1.0\">" << endl;
+    auxbasisfile << "      <constant decay=\"" << decay << "\">" << endl;
+    auxbasisfile << "        <contractions type=\"S\" factor=\"1.0\"/>" << endl;
+    auxbasisfile << "      </constant>" << endl;
+    auxbasisfile << "    </shell>" << endl;
+  }
+  for (double decay : {2.0, 0.5}) {
+    auxbasisfile << "    <shell type=\"P\" scale=\"1.0\">" << endl;
+    auxbasisfile << "      <constant decay=\"" << decay << "\">" << endl;
+    auxbasisfile << "        <contractions type=\"P\" factor=\"1.0\"/>" << endl;
+    auxbasisfile << "      </constant>" << endl;
+    auxbasisfile << "    </shell>" << endl;
+  }
+  auxbasisfile << "    <shell type=\"D\" scale=\"1.0\">" << endl;
+  auxbasisfile << "      <constant decay=\"1.0\">" << endl;
+  auxbasisfile << "        <contractions type=\"D\" factor=\"1.0\"/>" << endl;
+  auxbasisfile << "      </constant>" << endl;
+  auxbasisfile << "    </shell>" << endl;
+  auxbasisfile << "  </element>" << endl;
+  auxbasisfile << "  <element name=\"H\">" << endl;
+  for (double decay : {3.0, 0.8, 0.2}) {
+    auxbasisfile << "    <shell type=\"S\" scale=\"1.0\">" << endl;
+    auxbasisfile << "      <constant decay=\"" << decay << "\">" << endl;
+    auxbasisfile << "        <contractions type=\"S\" factor=\"1.0\"/>" << endl;
+    auxbasisfile << "      </constant>" << endl;
+    auxbasisfile << "    </shell>" << endl;
+  }
+  auxbasisfile << "    <shell type=\"P\" scale=\"1.0\">" << endl;
+  auxbasisfile << "      <constant decay=\"1.0\">" << endl;
+  auxbasisfile << "        <contractions type=\"P\" factor=\"1.0\"/>" << endl;
+  auxbasisfile << "      </constant>" << endl;
+  auxbasisfile << "    </shell>" << endl;
+  auxbasisfile << "  </element>" << endl;
+  auxbasisfile << "</basis>" << endl;
+  auxbasisfile.close();
+
+  ofstream ecpfile("ecp.xml");
+  ecpfile << "<pseudopotential name=\"ECP_STUTTGART\">" << endl;
+  ecpfile << "  <element name=\"O\" lmax=\"3\" ncore=\"2\">" << endl;
+  ecpfile << "    <shell type=\"F\"><constant power=\"2\" decay=\"1.0\" contraction=\"0.0\"></constant></shell>" << endl;
+  ecpfile << "    <shell type=\"S\"><constant power=\"2\" decay=\"10.44567000\" contraction=\"50.77106900\"></constant></shell>" << endl;
+  ecpfile << "    <shell type=\"P\"><constant power=\"2\" decay=\"18.04517400\" contraction=\"-4.90355100\"></constant></shell>" << endl;
+  ecpfile << "    <shell type=\"D\"><constant power=\"2\" decay=\"8.16479800\" contraction=\"-3.31212400\"></constant></shell>" << endl;
+  ecpfile << "  </element>" << endl;
+  ecpfile << "</pseudopotential>" << endl;
+  ecpfile.close();
+
+  ofstream optionsfile("forces.xml");
+  optionsfile << "<options>" << endl;
+  optionsfile << "  <package>" << endl;
+  optionsfile << "    <name>xtp</name>" << endl;
+  optionsfile << "    <charge>0</charge>" << endl;
+  optionsfile << "    <spin>1</spin>" << endl;
+  optionsfile << "    <threads>1</threads>" << endl;
+  optionsfile << "    <cleanup></cleanup>" << endl;
+  optionsfile << "    <dftbasis>ecpbasis.xml</dftbasis>" << endl;
+  optionsfile << "    <auxbasis>auxbasis.xml</auxbasis>" << endl;
+  optionsfile << "    <ecp>ecp.xml</ecp>" << endl;
+  optionsfile << "    <xc_functional>XC_HYB_GGA_XC_PBEH</xc_functional>" << endl;
+  optionsfile << "    <convergence>" << endl;
+  optionsfile << "      <energy>1e-10</energy>" << endl;
+  optionsfile << "      <error>1e-8</error>" << endl;
+  optionsfile << "      <max_iterations>200</max_iterations>" << endl;
+  optionsfile << "    </convergence>" << endl;
+  optionsfile << "  </package>" << endl;
+  optionsfile << "  <gwbse_engine>" << endl;
+  optionsfile << "    <tasks>dft</tasks>" << endl;
+  optionsfile << "    <mofile>system_dft.orb</mofile>" << endl;
+  optionsfile << "    <dftlog>system_dft.orb</dftlog>" << endl;
+  optionsfile << "  </gwbse_engine>" << endl;
+  optionsfile << "  <forces_seminumerical>" << endl;
+  optionsfile << "    <method>seminumerical</method>" << endl;
+  optionsfile << "    <removal>none</removal>" << endl;
+  optionsfile << "  </forces_seminumerical>" << endl;
+  optionsfile << "  <forces_central>" << endl;
+  optionsfile << "    <method>central</method>" << endl;
+  optionsfile << "    <removal>none</removal>" << endl;
+  optionsfile << "  </forces_central>" << endl;
+  optionsfile << "  <forces_concurrent>" << endl;
+  optionsfile << "    <method>central</method>" << endl;
+  optionsfile << "    <removal>none</removal>" << endl;
+  optionsfile << "    <concurrent_tasks>2</concurrent_tasks>" << endl;
+  optionsfile << "    <threads_per_task>1</threads_per_task>" << endl;
+  optionsfile << "  </forces_concurrent>" << endl;
+  optionsfile << "</options>" << endl;
+  optionsfile.close();
+}
+
+BOOST_AUTO_TEST_SUITE(forces_test)
+
+BOOST_AUTO_TEST_CASE(seminumerical_vs_central) {
+
+  WriteWaterInput();
+
+  tools::Property options;
+  load_property_from_xml(options, "forces.xml");
+
+  ctp::Logger log(ctp::logERROR);
+  QMPackageFactory::RegisterAll();
+  std::unique_ptr<QMPackage> qmpackage(QMPackages().Create("xtp"));
+  qmpackage->Initialize(options.get("options"));
+  qmpackage->setLog(&log);
+  qmpackage->setRunDir(".");
+
+  GWBSEEngine gwbse_engine;
+  gwbse_engine.Initialize(options.get("options.gwbse_engine"), "h2o.orb");
+  gwbse_engine.setLog(&log);
+  gwbse_engine.setQMPackage(qmpackage.get());
+
+  Orbitals orbitals;
+  orbitals.LoadFromXYZ("h2o.xyz");
+  std::vector<tools::vec> positions;
+  for (const QMAtom* atom : orbitals.QMAtoms()) {
+    positions.push_back(atom->getPos());
+  }
+  gwbse_engine.ExcitationEnergies(orbitals);
+  double energy = orbitals.getTotalStateEnergy(QMState("n"));
+
+  Statefilter filter;
+  filter.setLogger(&log);
+  filter.setInitialState(QMState("n"));
+
+  Forces seminumerical(gwbse_engine, filter, orbitals);
+  seminumerical.setLog(&log);
+  seminumerical.Initialize(options.get("options.forces_seminumerical"));
+  seminumerical.Calculate(energy);
+  Eigen::MatrixX3d forces_seminumerical = seminumerical.GetForces();
+
+  bool positions_restored = true;
+  for (unsigned i = 0; i < positions.size(); i++) {
+    positions_restored = positions_restored && (abs(orbitals.QMAtoms()[i]->getPos() - positions[i]) < 1e-12);
+  }
+  BOOST_CHECK_EQUAL(positions_restored, true);
+
+  Forces central(gwbse_engine, filter, orbitals);
+  central.setLog(&log);
+  central.Initialize(options.get("options.forces_central"));
+  central.Calculate(energy);
+  Eigen::MatrixX3d forces_central = central.GetForces();
+
+  bool check_forces = (forces_seminumerical - forces_central).cwiseAbs().maxCoeff() < 1e-4;
+  if (!check_forces) {
+    cout << "seminumerical" << endl;
+    cout << forces_seminumerical << endl;
+    cout << "central differences" << endl;
+    cout << forces_central << endl;
+  }
+  BOOST_CHECK_EQUAL(check_forces, true);
+  BOOST_CHECK_EQUAL(forces_central.cwiseAbs().maxCoeff() > 1e-3, true);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_vs_serial) {
+
+  ofstream optionsfile("forces_analytic.xml");
+  optionsfile << "<options>" << endl;
+  optionsfile << "  <gwbse_engine>" << endl;
+  optionsfile << "    <tasks>dft</tasks>" << endl;
+  optionsfile << "    <mofile>system.orb</mofile>" << endl;
+  optionsfile << "    <dftlog>system.log</dftlog>" << endl;
+  optionsfile << "  </gwbse_engine>" << endl;
+  for (std::string method : {"forward", "central"}) {
+    for (int tasks : {1, 3}) {
+      optionsfile << "  <" << method << "_" << tasks << ">" << endl;
+      optionsfile << "    <method>" << method << "</method>" << endl;
+      optionsfile << "    <removal>none</removal>" << endl;
+      optionsfile << "    <concurrent_tasks>" << tasks << "</concurrent_tasks>" << endl;
+      optionsfile << "    <threads_per_task>1</threads_per_task>" << endl;
+      optionsfile << "  </" << method << "_" << tasks << ">" << endl;
+    }
+  }
+  optionsfile << "</options>" << endl;
+  optionsfile.close();
+
+  tools::Property options;
+  load_property_from_xml(options, "forces_analytic.xml");
+
+  ctp::Logger log(ctp::logERROR);
+  AnalyticQMPackage qmpackage;
+  qmpackage.setLog(&log);
+
+  GWBSEEngine gwbse_engine;
+  gwbse_engine.Initialize(options.get("options.gwbse_engine"), "analytic.orb");
+  gwbse_engine.setLog(&log);
+  gwbse_engine.setQMPackage(&qmpackage);
+
+  Orbitals orbitals;
+  orbitals.AddAtom(QMAtom(0, "O", 0.0, 0.0, 0.2));
+  orbitals.AddAtom(QMAtom(1, "H", 0.0, 1.5, -0.9));
+  orbitals.AddAtom(QMAtom(2, "H", 0.1, -1.4, -1.0));
+  gwbse_engine.ExcitationEnergies(orbitals);
+  double energy = orbitals.getTotalStateEnergy(QMState("n"));
+
+  Statefilter filter;
+  filter.setLogger(&log);
+  filter.setInitialState(QMState("n"));
+
+  for (std::string method : {"forward", "central"}) {
+    Forces serial(gwbse_engine, filter, orbitals);
+    serial.setLog(&log);
+    serial.Initialize(options.get("options." + method + "_1"));
+    serial.Calculate(energy);
+
+    Forces concurrent(gwbse_engine, filter, orbitals);
+    concurrent.setLog(&log);
+    concurrent.Initialize(options.get("options." + method + "_3"));
+    concurrent.Calculate(energy);
+
+    bool check_forces = (serial.GetForces() == concurrent.GetForces());
+    if (!check_forces) {
+      cout << method << " serial" << endl;
+      cout << serial.GetForces() << endl;
+      cout << method << " concurrent" << endl;
+      cout << concurrent.GetForces() << endl;
+    }
+    BOOST_CHECK_EQUAL(check_forces, true);
+    BOOST_CHECK_EQUAL(serial.GetForces().cwiseAbs().maxCoeff() > 1e-3, true);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(xtp_concurrent_vs_serial) {
+
+  WriteWaterInput();
+
+  tools::Property options;
+  load_property_from_xml(options, "forces.xml");
+
+  ctp::Logger log(ctp::logERROR);
+  QMPackageFactory::RegisterAll();
+  std::unique_ptr<QMPackage> qmpackage(QMPackages().Create("xtp"));
+  qmpackage->Initialize(options.get("options"));
+  qmpackage->setLog(&log);
+  qmpackage->setRunDir(".");
+
+  GWBSEEngine gwbse_engine;
+  gwbse_engine.Initialize(options.get("options.gwbse_engine"), "h2o.orb");
+  gwbse_engine.setLog(&log);
+  gwbse_engine.setQMPackage(qmpackage.get());
+
+  Orbitals orbitals;
+  orbitals.LoadFromXYZ("h2o.xyz");
+  gwbse_engine.ExcitationEnergies(orbitals);
+  double energy = orbitals.getTotalStateEnergy(QMState("n"));
+
+  Statefilter filter;
+  filter.setLogger(&log);
+  filter.setInitialState(QMState("n"));
+
+  Forces serial(gwbse_engine, filter, orbitals);
+  serial.setLog(&log);
+  serial.Initialize(options.get("options.forces_central"));
+  serial.Calculate(energy);
+
+  Forces concurrent(gwbse_engine, filter, orbitals);
+  concurrent.setLog(&log);
+  concurrent.Initialize(options.get("options.forces_concurrent"));
+  concurrent.Calculate(energy);
+
+  // the displaced SCFs start from different guesses, so the energies only agree to the convergence threshold
+  bool check_forces = (serial.GetForces() - concurrent.GetForces()).cwiseAbs().maxCoeff() < 1e-6;
+  if (!check_forces) {
+    cout << "serial" << endl;
+    cout << serial.GetForces() << endl;
+    cout << "concurrent" << endl;
+    cout << concurrent.GetForces() << endl;
+  }
+  BOOST_CHECK_EQUAL(check_forces, true);
+  BOOST_CHECK_EQUAL(serial.GetForces().cwiseAbs().maxCoeff() > 1e-3, true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
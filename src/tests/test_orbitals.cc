@@ -335,4 +335,68 @@ BOOST_CHECK_EQUAL(check_s1, 1);
   
 }
 
+BOOST_AUTO_TEST_CASE(densmat_batch_test) {
+  Orbitals orbitals;
+  orbitals.setBasisSetSize(10);
+  orbitals.setNumberOfLevels(4,6);
+  orbitals.MOCoefficients()=Eigen::MatrixXd::Random(10,10);
+  orbitals.setBSEindices(1,8,3);
+  orbitals.setTDAApprox(false);
+  const int vtotal=3;
+  const int ctotal=5;
+  orbitals.BSESingletCoefficients()=MatrixXfd::Random(vtotal*ctotal,3);
+  orbitals.BSESingletCoefficientsAR()=0.1*MatrixXfd::Random(vtotal*ctotal,3);
+  orbitals.BSETripletCoefficients()=MatrixXfd::Random(vtotal*ctotal,3);
+
+  std::vector<QMState> states={QMState("s1"),QMState("t3"),QMState("s2")};
+  std::vector< std::vector<Eigen::MatrixXd> > dmats=orbitals.DensityMatricesExcitedStates(states);
+  BOOST_CHECK_EQUAL(dmats.size(), 3);
+
+  const Eigen::MatrixXd& MOs=orbitals.MOCoefficients();
+  for (unsigned i=0;i<states.size();i++){
+    // reference from the definition, the antiresonant part only contributes for singlets
+    Eigen::MatrixXd hole_ref=Eigen::MatrixXd::Zero(10,10);
+    Eigen::MatrixXd electron_ref=Eigen::MatrixXd::Zero(10,10);
+    bool singlet=(states[i].Type()==QMStateType::Singlet);
+    Eigen::VectorXd A=(singlet ? orbitals.BSESingletCoefficients() : orbitals.BSETripletCoefficients()).col(states[i].Index()).cast<double>();
+    Eigen::VectorXd B=Eigen::VectorXd::Zero(A.size());
+    if(singlet){
+      B=orbitals.BSESingletCoefficientsAR().col(states[i].Index()).cast<double>();
+    }
+    for (int v=0;v<vtotal;v++){
+      for (int c=0;c<ctotal;c++){
+        for (int v2=0;v2<vtotal;v2++){
+          double w=A(ctotal*v+c)*A(ctotal*v2+c)-B(ctotal*v+c)*B(ctotal*v2+c);
+          hole_ref+=w*MOs.col(1+v)*MOs.col(1+v2).transpose();
+        }
+        for (int c2=0;c2<ctotal;c2++){
+          double w=A(ctotal*v+c)*A(ctotal*v+c2)-B(ctotal*v+c)*B(ctotal*v+c2);
+          electron_ref+=w*MOs.col(4+c)*MOs.col(4+c2).transpose();
+        }
+      }
+    }
+    bool check_hole=hole_ref.isApprox(dmats[i][0],1e-5);
+    bool check_electron=electron_ref.isApprox(dmats[i][1],1e-5);
+    BOOST_CHECK_EQUAL(check_hole, 1);
+    BOOST_CHECK_EQUAL(check_electron, 1);
+    std::vector<Eigen::MatrixXd> single=orbitals.DensityMatrixExcitedState(states[i]);
+    BOOST_CHECK_EQUAL(single[0].isApprox(dmats[i][0],1e-10), 1);
+    BOOST_CHECK_EQUAL(single[1].isApprox(dmats[i][1],1e-10), 1);
+  }
+
+  std::vector<QMState> singlets={QMState("s2"),QMState("s1")};
+  std::vector<Eigen::MatrixXd> transition=orbitals.TransitionDensityMatrices(singlets);
+  for (unsigned i=0;i<singlets.size();i++){
+    Eigen::VectorXd XpY=(orbitals.BSESingletCoefficients().col(singlets[i].Index())
+                        +orbitals.BSESingletCoefficientsAR().col(singlets[i].Index())).cast<double>();
+    Eigen::MatrixXd trans_ref=Eigen::MatrixXd::Zero(10,10);
+    for (int v=0;v<vtotal;v++){
+      for (int c=0;c<ctotal;c++){
+        trans_ref+=std::sqrt(2.0)*XpY(ctotal*v+c)*MOs.col(1+v)*MOs.col(4+c).transpose();
+      }
+    }
+    BOOST_CHECK_EQUAL(trans_ref.isApprox(transition[i],1e-5), 1);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -309,9 +309,86 @@ if(!check4){
 
 BOOST_CHECK_EQUAL(check4 , true);
  
+TCMatrix_gwbse tc_disk;
+tc_disk.Initialize(aobasis.AOBasisSize(),0,5,0,7,"threecenter_gwbse.scratch");
+tc_disk.Fill(aobasis,aobasis,MOs);
+tc_disk.MultiplyRightWithAuxMatrix(cou.Pseudo_InvSqrt_GWBSE(overlap,1e-7));
+BOOST_CHECK_EQUAL(tc_disk.isOnDisk() , true);
+BOOST_CHECK_EQUAL(ref4.isApprox(tc_disk[4],1e-5) , true);
 
-
+tc.Prune(2,5);
+tc_disk.Prune(2,5);
+BOOST_CHECK_EQUAL(tc[4].rows() , 6);
+BOOST_CHECK_EQUAL(ref4.topRows(6).isApprox(tc[4],1e-5) , true);
+BOOST_CHECK_EQUAL(ref4.topRows(6).isApprox(tc_disk[4],1e-5) , true);
  
   
+}
+
+// gives access to the protected kernels
+class ThreeCenterKernels : public TCMatrix {
+public:
+  using TCMatrix::FillThreeCenterRepBlock;
+  using TCMatrix::FillThreeCenterRepBlockGeneric;
+};
+
+BOOST_AUTO_TEST_CASE(threecenter_specialised){
+  // s,p,d and sp DFT shells on two atoms, s to g aux shells on a third
+  // atom and on one of the DFT atoms
+  const std::vector<std::string> types = {"S", "P", "D", "F", "G"};
+  BasisSet basis;
+  Element& element = basis.addElement("C");
+  BasisSet auxbasis;
+  Element& auxelement = auxbasis.addElement("C");
+  for (unsigned l = 0; l < types.size(); l++) {
+    std::vector<double> contraction(l + 1, 0.0);
+    contraction[l] = 1.0;
+    if (l < 3) {
+      Shell& shell = element.addShell(types[l], 1.0);
+      shell.addGaussian(8.0, contraction);
+      shell.addGaussian(1.5, contraction);
+      shell.addGaussian(0.35, contraction);
+    }
+    Shell& auxshell = auxelement.addShell(types[l], 1.0);
+    auxshell.addGaussian(3.0, contraction);
+    auxshell.addGaussian(0.6, contraction);
+  }
+  Shell& spshell = element.addShell("SP", 1.0);
+  spshell.addGaussian(2.0, {0.4, 0.7});
+  spshell.addGaussian(0.5, {0.6, 0.3});
+
+  QMAtom atom_a(0, "C", 0.0, 0.0, 0.0);
+  QMAtom atom_b(1, "C", 1.4, 1.1, -0.3);
+  QMAtom atom_c(2, "C", -0.6, 1.9, 0.8);
+  std::vector<QMAtom*> dftatoms = {&atom_a, &atom_b};
+  std::vector<QMAtom*> auxatoms = {&atom_c, &atom_a};
+  AOBasis aobasis;
+  aobasis.AOBasisFill(basis, dftatoms);
+  AOBasis auxaobasis;
+  auxaobasis.AOBasisFill(auxbasis, auxatoms);
+
+  ThreeCenterKernels kernels;
+  tensor3d::extent_gen extents;
+  double maxdiff = 0.0;
+  for (unsigned row = 0; row < aobasis.getNumofShells(); row++) {
+    for (unsigned col = 0; col <= row; col++) {
+      const AOShell* shell_row = aobasis.getShell(row);
+      const AOShell* shell_col = aobasis.getShell(col);
+      const ShellPairData::Pairs pairs = aobasis.getShellPairData().getPairs(row, col);
+      for (const AOShell* auxshell : auxaobasis) {
+        tensor3d block(extents[auxshell->getNumFunc()][shell_row->getNumFunc()][shell_col->getNumFunc()]);
+        tensor3d block_generic(extents[auxshell->getNumFunc()][shell_row->getNumFunc()][shell_col->getNumFunc()]);
+        std::fill_n(block.data(), block.num_elements(), 0.0);
+        std::fill_n(block_generic.data(), block_generic.num_elements(), 0.0);
+        bool contributes = kernels.FillThreeCenterRepBlock(block, auxshell, shell_row, shell_col, pairs);
+        bool contributes_generic = kernels.FillThreeCenterRepBlockGeneric(block_generic, auxshell, shell_row, shell_col, pairs);
+        BOOST_CHECK_EQUAL(contributes, contributes_generic);
+        for (unsigned i = 0; i < block.num_elements(); i++) {
+          maxdiff = std::max(maxdiff, std::abs(block.data()[i] - block_generic.data()[i]));
+        }
+      }
+    }
+  }
+  BOOST_CHECK_SMALL(maxdiff, 1e-12);
 }
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2009-2018 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE xtpdft_test
+#include <boost/test/unit_test.hpp>
+#include <votca/xtp/orbitals.h>
+#include <votca/xtp/qmpackagefactory.h>
+#include <votca/ctp/polarseg.h>
+#include <votca/tools/property.h>
+#include <fstream>
+#include <memory>
+
+using namespace votca::xtp;
+using namespace votca;
+using namespace std;
+
+std::vector<std::shared_ptr<ctp::PolarSeg> > ChargeBackground(const std::string& filename, double charge, double z) {
+  ofstream mpsfile(filename);
+  mpsfile << "! One Site" << endl;
+  mpsfile << "! N=1 " << endl;
+  mpsfile << "Units angstrom" << endl;
+  mpsfile << "  C +0 0 " << z << " Rank 0" << endl;
+  mpsfile << charge << endl;
+  mpsfile << "P +1.9445387 +0.0000000 +0.0000000 +1.9445387 +0.0000000 +1.9445387 " << endl;
+  mpsfile.close();
+  std::vector<ctp::APolarSite*> sites = ctp::APS_FROM_MPS(filename, 0);
+  std::vector<std::shared_ptr<ctp::PolarSeg> > polar_segments;
+  polar_segments.push_back(std::shared_ptr<ctp::PolarSeg>(new ctp::PolarSeg(0, sites)));
+  return polar_segments;
+}
+
+BOOST_AUTO_TEST_SUITE(xtpdft_test)
+
+BOOST_AUTO_TEST_CASE(warm_start_external_charges) {
+
+  ofstream xyzfile("molecule.xyz");
+  xyzfile << " 5" << endl;
+  xyzfile << " methane" << endl;
+  xyzfile << " C            .000000     .000000     .000000" << endl;
+  xyzfile << " H            .629118     .629118     .629118" << endl;
+  xyzfile << " H           -.629118    -.629118     .629118" << endl;
+  xyzfile << " H            .629118    -.629118    -.629118" << endl;
+  xyzfile << " H           -.629118     .629118    -.629118" << endl;
+  xyzfile.close();
+
+  ofstream basisfile("3-21G.xml");
+  basisfile << "<basis name=\"3-21G\">" << endl;
+  basisfile << "  <element name=\"H\">" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << endl;
+  basisfile << "      <constant decay=\"5.447178e+00\">" << endl;
+  basisfile << "        <contractions factor=\"1.562850e-01\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "      <constant decay=\"8.245470e-01\">" << endl;
+  basisfile << "        <contractions factor=\"9.046910e-01\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << endl;
+  basisfile << "      <constant decay=\"1.831920e-01\">" << endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "  </element>" << endl;
+  basisfile << "  <element name=\"C\">" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << endl;
+  basisfile << "      <constant decay=\"1.722560e+02\">" << endl;
+  basisfile << "        <contractions factor=\"6.176690e-02\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "      <constant decay=\"2.591090e+01\">" << endl;
+  basisfile << "        <contractions factor=\"3.587940e-01\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "      <constant decay=\"5.533350e+00\">" << endl;
+  basisfile << "        <contractions factor=\"7.007130e-01\" type=\"S\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"SP\">" << endl;
+  basisfile << "      <constant decay=\"3.664980e+00\">" << endl;
+  basisfile << "        <contractions factor=\"-3.958970e-01\" type=\"S\"/>" << endl;
+  basisfile << "        <contractions factor=\"2.364600e-01\" type=\"P\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "      <constant decay=\"7.705450e-01\">" << endl;
+  basisfile << "        <contractions factor=\"1.215840e+00\" type=\"S\"/>" << endl;
+  basisfile << "        <contractions factor=\"8.606190e-01\" type=\"P\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"SP\">" << endl;
+  basisfile << "      <constant decay=\"1.958570e-01\">" << endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"S\"/>" << endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"P\"/>" << endl;
+  basisfile << "      </constant>" << endl;
+  basisfile << "    </shell>" << endl;
+  basisfile << "  </element>" << endl;
+  basisfile << "</basis>" << endl;
+  basisfile.close();
+
+  // without an aux basis the Coulomb matrix is built incrementally from the four center integrals
+  ofstream optionsfile("xtpdft.xml");
+  optionsfile << "<options>" << endl;
+  optionsfile << "  <package>" << endl;
+  optionsfile << "    <name>xtp</name>" << endl;
+  optionsfile << "    <charge>0</charge>" << endl;
+  optionsfile << "    <spin>1</spin>" << endl;
+  optionsfile << "    <threads>1</threads>" << endl;
+  optionsfile << "    <cleanup></cleanup>" << endl;
+  optionsfile << "    <dftbasis>3-21G.xml</dftbasis>" << endl;
+  optionsfile << "    <four_center_method>direct</four_center_method>" << endl;
+  optionsfile << "    <fock_rebuild>4</fock_rebuild>" << endl;
+  optionsfile << "    <xc_functional>XC_HYB_GGA_XC_PBEH</xc_functional>" << endl;
+  optionsfile << "    <convergence>" << endl;
+  optionsfile << "      <energy>1e-10</energy>" << endl;
+  optionsfile << "      <error>1e-8</error>" << endl;
+  optionsfile << "      <max_iterations>200</max_iterations>" << endl;
+  optionsfile << "    </convergence>" << endl;
+  optionsfile << "  </package>" << endl;
+  optionsfile << "</options>" << endl;
+  optionsfile.close();
+
+  tools::Property options;
+  load_property_from_xml(options, "xtpdft.xml");
+
+  ctp::Logger log(ctp::logERROR);
+  QMPackageFactory::RegisterAll();
+
+  // second QM/MM iteration: same atoms, the polarised background has changed
+  std::unique_ptr<QMPackage> warm(QMPackages().Create("xtp"));
+  warm->Initialize(options.get("options"));
+  warm->setLog(&log);
+  warm->setRunDir(".");
+  warm->setWarmStart(true);
+  Orbitals orbitals_warm;
+  orbitals_warm.LoadFromXYZ("molecule.xyz");
+  warm->setMultipoleBackground(ChargeBackground("background_1.mps", 0.5, 3.0));
+  warm->Run(orbitals_warm);
+  double energy_first = orbitals_warm.getQMEnergy();
+  warm->setMultipoleBackground(ChargeBackground("background_2.mps", -0.8, 2.5));
+  warm->Run(orbitals_warm);
+  double energy_warm = orbitals_warm.getQMEnergy();
+  warm->setWarmStart(false);
+
+  std::unique_ptr<QMPackage> cold(QMPackages().Create("xtp"));
+  cold->Initialize(options.get("options"));
+  cold->setLog(&log);
+  cold->setRunDir(".");
+  Orbitals orbitals_cold;
+  orbitals_cold.LoadFromXYZ("molecule.xyz");
+  cold->setMultipoleBackground(ChargeBackground("background_2.mps", -0.8, 2.5));
+  cold->Run(orbitals_cold);
+  double energy_cold = orbitals_cold.getQMEnergy();
+
+  bool check_energy = std::abs(energy_warm - energy_cold) < 1e-6;
+  if (!check_energy) {
+    cout << "first background " << energy_first << endl;
+    cout << "warm start " << energy_warm << endl;
+    cout << "cold start " << energy_cold << endl;
+  }
+  BOOST_CHECK_EQUAL(check_energy, true);
+  BOOST_CHECK_EQUAL(std::abs(energy_first - energy_cold) > 1e-3, true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()